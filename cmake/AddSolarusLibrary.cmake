@@ -7,11 +7,13 @@ file(
   include/solarus/audio/Music.h
   include/solarus/audio/OggDecoder.h
   include/solarus/audio/Sound.h
+  include/solarus/audio/SoundPool.h
   include/solarus/audio/SpcDecoder.h
 
   include/solarus/containers/Grid.h
   include/solarus/containers/Quadtree.h
   include/solarus/containers/Quadtree.inl
+  include/solarus/containers/SpscQueue.h
 
   include/solarus/core/Ability.h
   include/solarus/core/AbilityInfo.h
@@ -39,6 +41,8 @@ file(
   include/solarus/core/MainLoop.h
   include/solarus/core/Map.h
   include/solarus/core/MapData.h
+  include/solarus/core/MapSnapshot.h
+  include/solarus/core/MappedArchive.h
   include/solarus/core/PixelBits.h
   include/solarus/core/Point.h
   include/solarus/core/Point.inl
@@ -51,6 +55,7 @@ file(
   include/solarus/core/ResourceType.h
   include/solarus/core/SavegameConverterV1.h
   include/solarus/core/Savegame.h
+  include/solarus/core/SavegameKey.h
   include/solarus/core/Settings.h
   include/solarus/core/Size.h
   include/solarus/core/Size.inl
@@ -62,6 +67,7 @@ file(
   include/solarus/core/TimerPtr.h
   include/solarus/core/Treasure.h
 
+  include/solarus/entities/AnimatedRegions.h
   include/solarus/entities/AnimatedTilePattern.h
   include/solarus/entities/Arrow.h
   include/solarus/entities/Block.h
@@ -192,6 +198,7 @@ file(
   include/solarus/lua/ExportableToLuaPtr.h
   include/solarus/lua/LuaContext.h
   include/solarus/lua/LuaData.h
+  include/solarus/lua/LuaDataCache.h
   include/solarus/lua/LuaException.h
   include/solarus/lua/LuaTools.h
   include/solarus/lua/LuaTools.inl
@@ -230,6 +237,7 @@ file(
   src/audio/Music.cpp
   src/audio/OggDecoder.cpp
   src/audio/Sound.cpp
+  src/audio/SoundPool.cpp
   src/audio/SpcDecoder.cpp
 
   src/core/AbilityInfo.cpp
@@ -252,6 +260,8 @@ file(
   src/core/MainLoop.cpp
   src/core/Map.cpp
   src/core/MapData.cpp
+  src/core/MapSnapshot.cpp
+  src/core/MappedArchive.cpp
   src/core/PixelBits.cpp
   src/core/Point.cpp
   src/core/QuestFiles.cpp
@@ -262,6 +272,7 @@ file(
   src/core/ResourceProvider.cpp
   src/core/SavegameConverterV1.cpp
   src/core/Savegame.cpp
+  src/core/SavegameKey.cpp
   src/core/Settings.cpp
   src/core/Size.cpp
   src/core/SolarusFatal.cpp
@@ -271,6 +282,7 @@ file(
   src/core/Timer.cpp
   src/core/Treasure.cpp
 
+  src/entities/AnimatedRegions.cpp
   src/entities/AnimatedTilePattern.cpp
   src/entities/Arrow.cpp
   src/entities/Block.cpp
@@ -392,6 +404,7 @@ file(
   src/lua/LanguageApi.cpp
   src/lua/LuaContext.cpp
   src/lua/LuaData.cpp
+  src/lua/LuaDataCache.cpp
   src/lua/LuaException.cpp
   src/lua/LuaTools.cpp
   src/lua/MainApi.cpp
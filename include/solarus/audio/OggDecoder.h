@@ -32,8 +32,10 @@ class OggDecoder {
   public:
 
     OggDecoder();
+    ~OggDecoder();
 
     bool load(std::string&& ogg_data, bool loop);
+    bool load(SDL_RWops* ogg_stream, bool loop);
     void unload();
     void decode(ALuint destination_buffer, ALsizei nb_samples);
 
@@ -47,9 +49,15 @@ class OggDecoder {
     };
     using OggFileUniquePtr = std::unique_ptr<OggVorbis_File, OggFileDeleter>;
 
-    OggFileUniquePtr ogg_file;         /**< The file used by the vorbisfile lib. */
+    bool open(void* datasource, const ov_callbacks& callbacks);
+
     Sound::SoundFromMemory ogg_mem;    /**< The encoded music loaded in memory,
                                         * passed to the vorbisfile lib as user data. */
+    Sound::SoundFromStream ogg_stream; /**< The encoded music read progressively,
+                                        * passed to the vorbisfile lib as user data. */
+    OggFileUniquePtr ogg_file;         /**< The file used by the vorbisfile lib.
+                                        * Declared after its data source so that it
+                                        * is destroyed first. */
     vorbis_info* ogg_info;             /**< Info about the OGG file. */
     ogg_int64_t loop_start_pcm;        /**< Where to loop to in PCM samples.
                                         * -1 means no loop. */
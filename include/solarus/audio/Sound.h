@@ -18,13 +18,16 @@
 #define SOLARUS_SOUND_H
 
 #include "solarus/core/Common.h"
+#include <cstdint>
 #include <string>
-#include <list>
 #include <map>
+#include <vector>
 #include <al.h>
 #include <alc.h>
 #include <vorbis/vorbisfile.h>
 
+struct SDL_RWops;
+
 namespace Solarus {
 
 class Arguments;
@@ -37,6 +40,15 @@ class Arguments;
  * rather than calling directly the constructor of Sound.
  * This class is the only one that depends on the sound decoding library (libsndfile).
  * This class and the Music class are the only ones that depend on the audio mixer library (OpenAL).
+ *
+ * Sounds are played on a fixed pool of voices (OpenAL sources).
+ * When all voices are busy, a new sound replaces the oldest sound of lowest
+ * priority, unless all playing sounds have a higher priority.
+ *
+ * Sounds are decoded when played for the first time, or in background
+ * by load_all().
+ * Decoded sounds are kept in a cache limited in memory: the least recently
+ * played ones are unloaded first.
  */
 class SOLARUS_API Sound {
 
@@ -53,18 +65,30 @@ class SOLARUS_API Sound {
       bool loop;                /**< \c true to restart the sound if it finishes. */
     };
 
+    /**
+     * \brief Encoded sound file read progressively.
+     */
+    struct SoundFromStream {
+      SDL_RWops* rw;            /**< The OGG encoded data source. */
+      bool loop;                /**< \c true to restart the sound if it finishes. */
+    };
+
     // functions to load the encoded sound from memory
     static ov_callbacks ogg_callbacks;           /**< vorbisfile object used to load the encoded sound from memory */
+    static ov_callbacks ogg_stream_callbacks;    /**< vorbisfile object used to load the encoded sound from a stream */
 
-    Sound();
     explicit Sound(const std::string& sound_id);
     ~Sound();
+
+    Sound(const Sound& other) = delete;
+    Sound& operator=(const Sound& other) = delete;
+
     void load();
-    bool start();
+    bool start(int priority);
 
     static void load_all();
     static bool exists(const std::string& sound_id);
-    static void play(const std::string& sound_id);
+    static void play(const std::string& sound_id, int priority = 0);
 
     static void initialize(const Arguments& args);
     static void quit();
@@ -74,19 +98,56 @@ class SOLARUS_API Sound {
     static int get_volume();
     static void set_volume(int volume);
 
+    static int get_num_voices();
+    static int get_num_voices_playing();
+
   private:
 
-    ALuint decode_file(const std::string& file_name);
-    bool update_playing();
+    /**
+     * \brief An OpenAL source that plays at most one sound at a time.
+     */
+    struct Voice {
+      ALuint source;            /**< The OpenAL source. */
+      Sound* sound;             /**< The sound being played, or nullptr if the voice is free. */
+      int priority;             /**< Priority of the sound being played. */
+      uint64_t play_order;      /**< When the sound was started, to find the oldest one. */
+    };
+
+    static bool decode_file(
+        const std::string& file_name,
+        std::vector<char>& samples,
+        ALsizei& sample_rate,
+        bool report_errors
+    );
+    static std::string get_file_name(const std::string& sound_id);
+    void create_buffer(const std::vector<char>& samples, ALsizei sample_rate);
+    void unload();
+    bool is_used_by_voice() const;
+
+    static Voice* get_voice(int priority);
+    static void stop_voice(Voice& voice);
+    static void shrink_cache(const Sound* sound_to_keep);
+
+    static void run_decoder();
+    static void stop_decoder();
+    static bool take_decoded_samples(
+        const std::string& sound_id,
+        std::vector<char>& samples,
+        ALsizei& sample_rate
+    );
+    static void create_decoded_buffers();
 
     static ALCdevice* device;
     static ALCcontext* context;
 
     std::string id;                              /**< id of this sound */
     ALuint buffer;                               /**< the OpenAL buffer containing the PCM decoded data of this sound */
-    std::list<ALuint> sources;                   /**< the sources currently playing this sound */
-    static std::list<Sound*> current_sounds;     /**< the sounds currently playing */
+    size_t buffer_size;                          /**< size of the decoded data in bytes */
+    uint64_t last_play_order;                    /**< when this sound was played for the last time */
+    static std::vector<Voice> voices;            /**< the pool of voices to play sounds */
     static std::map<std::string, Sound> all_sounds;   /**< all sounds created before */
+    static size_t cache_size;                    /**< total size of the decoded sounds in bytes */
+    static uint64_t next_play_order;             /**< counter incremented whenever a sound is played */
 
     static bool initialized;                     /**< indicates that the audio system is initialized */
     static bool sounds_preloaded;                /**< true if load_all() was called */
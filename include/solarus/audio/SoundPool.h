@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_SOUND_POOL_H
+#define SOLARUS_SOUND_POOL_H
+
+#include "solarus/core/Common.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Solarus {
+
+/**
+ * \brief Decides which voice plays a new sound and which decoded sounds
+ * are unloaded.
+ *
+ * These choices make no OpenAL call, so that they can be tested without
+ * an audio device.
+ */
+namespace SoundPool {
+
+/**
+ * \brief State of a voice, when looking for one to play a new sound.
+ */
+struct VoiceState {
+  bool free;                    /**< Whether no sound is playing on this voice. */
+  int priority;                 /**< Priority of the sound playing. */
+  uint64_t play_order;          /**< When the sound playing was started. */
+};
+
+/**
+ * \brief State of a decoded sound, when looking for sounds to unload.
+ */
+struct CachedSound {
+  size_t size;                  /**< Size of the decoded data in bytes. */
+  uint64_t last_play_order;     /**< When the sound was played for the last time. */
+  bool can_unload;              /**< Whether the sound may be unloaded now. */
+};
+
+SOLARUS_API int choose_voice(const std::vector<VoiceState>& voices, int priority);
+SOLARUS_API std::vector<size_t> choose_sounds_to_unload(
+    const std::vector<CachedSound>& sounds,
+    size_t max_cache_size
+);
+
+}
+
+}
+
+#endif
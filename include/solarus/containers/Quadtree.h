@@ -60,6 +60,10 @@ class Quadtree {
     std::vector<T> get_elements(
         const Rectangle& where
     ) const;
+    void get_elements(
+        const Rectangle& where,
+        std::vector<T>& result
+    ) const;
 
     int get_num_elements() const;
     bool contains(const T& element) const;
@@ -105,7 +109,7 @@ class Quadtree {
 
         void get_elements(
             const Rectangle& region,
-            std::set<T>& result
+            std::vector<T>& result
         ) const;
 
         int get_num_elements() const;
@@ -209,9 +209,34 @@ template<typename T>
 std::vector<T> Quadtree<T>::get_elements(
     const Rectangle& region
 ) const {
-  std::set<T> element_set;
-  root.get_elements(region, element_set);
-  return std::vector<T>(element_set.begin(), element_set.end());
+  std::vector<T> result;
+  get_elements(region, result);
+  return result;
+}
+
+/**
+ * \brief Gets the elements intersecting the given rectangle.
+ *
+ * Unlike the other overload, this one can reuse the memory
+ * already allocated by the vector.
+ *
+ * \param[in] region The rectangle to check.
+ * The rectangle should be entirely contained in the quadtree space.
+ * \param[out] result The elements intersecting the rectangle,
+ * in arbitrary order. Its previous content is replaced.
+ * Elements outside the quadtree space are not added there.
+ */
+template<typename T>
+void Quadtree<T>::get_elements(
+    const Rectangle& region,
+    std::vector<T>& result
+) const {
+  result.clear();
+  root.get_elements(region, result);
+
+  // An element overlapping several cells was found several times.
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
 }
 
 /**
@@ -541,11 +566,12 @@ int Quadtree<T>::Node::get_num_elements() const {
  * \brief Gets the elements intersecting the given rectangle under this node.
  * \param[in] region The rectangle to check.
  * \param[in/out] result A list that will be filled with elements.
+ * Elements overlapping several cells may be added several times.
  */
 template<typename T>
 void Quadtree<T>::Node::get_elements(
     const Rectangle& region,
-    std::set<T>& result
+    std::vector<T>& result
 ) const {
 
   if (!get_cell().overlaps(region)) {
@@ -556,7 +582,7 @@ void Quadtree<T>::Node::get_elements(
   if (!is_split()) {
     for (const std::pair<T, Rectangle>& pair : elements) {
       if (pair.second.overlaps(region)) {
-        result.insert(pair.first);
+        result.push_back(pair.first);
       }
     }
   }
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_SPSC_QUEUE_H
+#define SOLARUS_SPSC_QUEUE_H
+
+#include "solarus/core/Common.h"
+#include "solarus/core/Debug.h"
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Solarus {
+
+/**
+ * \brief A bounded, lock-free FIFO queue for one producer and one consumer.
+ *
+ * Exactly one thread may call push() and exactly one (possibly different)
+ * thread may call pop(). No lock is ever taken: the two sides only
+ * synchronize through two atomic indexes.
+ *
+ * The queue never allocates after construction. When it is full, push()
+ * fails and the caller decides what to do with the element.
+ */
+template <typename T>
+class SpscQueue {
+
+  public:
+
+    explicit SpscQueue(size_t capacity);
+
+    SpscQueue(const SpscQueue& other) = delete;
+    SpscQueue& operator=(const SpscQueue& other) = delete;
+
+    size_t get_capacity() const;
+    bool is_empty() const;
+
+    bool push(const T& element);
+    bool push(T&& element);
+    bool pop(T& element);
+
+  private:
+
+    size_t next_index(size_t index) const;
+
+    std::vector<T> slots;              /**< Ring buffer. One slot always stays
+                                        * free to distinguish full from empty. */
+    std::atomic<size_t> read_index;    /**< Next slot to pop, written by the consumer. */
+    std::atomic<size_t> write_index;   /**< Next slot to push, written by the producer. */
+
+};
+
+/**
+ * \brief Creates an empty queue.
+ * \param capacity Maximum number of elements the queue can hold.
+ */
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity):
+    slots(capacity + 1),
+    read_index(0),
+    write_index(0) {
+
+  Debug::check_assertion(capacity > 0, "Invalid queue capacity");
+}
+
+/**
+ * \brief Returns the maximum number of elements of the queue.
+ * \return The capacity.
+ */
+template <typename T>
+size_t SpscQueue<T>::get_capacity() const {
+  return slots.size() - 1;
+}
+
+/**
+ * \brief Returns whether the queue is currently empty.
+ *
+ * The result is only a hint when called from the producer thread.
+ *
+ * \return \c true if there is nothing to pop.
+ */
+template <typename T>
+bool SpscQueue<T>::is_empty() const {
+  return read_index.load(std::memory_order_acquire) ==
+      write_index.load(std::memory_order_acquire);
+}
+
+/**
+ * \brief Returns the slot that follows the given one in the ring buffer.
+ * \param index A slot index.
+ * \return The next slot index.
+ */
+template <typename T>
+size_t SpscQueue<T>::next_index(size_t index) const {
+
+  ++index;
+  if (index == slots.size()) {
+    index = 0;
+  }
+  return index;
+}
+
+/**
+ * \brief Appends a copy of an element to the queue.
+ *
+ * Must only be called from the producer thread.
+ *
+ * \param element The element to add.
+ * \return \c false if the queue is full.
+ */
+template <typename T>
+bool SpscQueue<T>::push(const T& element) {
+
+  T copy(element);
+  return push(std::move(copy));
+}
+
+/**
+ * \brief Moves an element at the end of the queue.
+ *
+ * Must only be called from the producer thread.
+ * The element is left unchanged if the queue is full.
+ *
+ * \param element The element to add.
+ * \return \c false if the queue is full.
+ */
+template <typename T>
+bool SpscQueue<T>::push(T&& element) {
+
+  const size_t index = write_index.load(std::memory_order_relaxed);
+  const size_t next = next_index(index);
+  if (next == read_index.load(std::memory_order_acquire)) {
+    // Full.
+    return false;
+  }
+
+  slots[index] = std::move(element);
+  write_index.store(next, std::memory_order_release);
+  return true;
+}
+
+/**
+ * \brief Removes the first element of the queue.
+ *
+ * Must only be called from the consumer thread.
+ *
+ * \param[out] element Receives the element removed.
+ * \return \c false if the queue was empty.
+ */
+template <typename T>
+bool SpscQueue<T>::pop(T& element) {
+
+  const size_t index = read_index.load(std::memory_order_relaxed);
+  if (index == write_index.load(std::memory_order_acquire)) {
+    // Empty.
+    return false;
+  }
+
+  element = std::move(slots[index]);
+  slots[index] = T();  // Release resources held by the slot now.
+  read_index.store(next_index(index), std::memory_order_release);
+  return true;
+}
+
+}
+
+#endif
+
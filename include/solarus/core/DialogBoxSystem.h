@@ -23,9 +23,9 @@
 #include "solarus/core/Point.h"
 #include "solarus/graphics/SurfacePtr.h"
 #include "solarus/lua/ScopedLuaRef.h"
-#include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace Solarus {
 
@@ -59,6 +59,8 @@ class DialogBoxSystem {
 
     void draw(const SurfacePtr& dst_surface);
 
+    static std::vector<std::string> split_lines(const std::string& text);
+
   private:
 
     bool has_more_lines() const;
@@ -72,7 +74,8 @@ class DialogBoxSystem {
     // Fields only used by the built-in dialog box.
     bool built_in;                                  /**< Whether we are using the built-in dialog box. */
     static constexpr int nb_visible_lines = 3;      /**< Maximum number of visible lines. */
-    std::list<std::string> remaining_lines;         /**< Text of each line still to be displayed. */
+    std::vector<std::string> lines;                 /**< Text of each line of the dialog, split when it opens. */
+    size_t next_line_index;                         /**< Index in lines of the first line still to be displayed. */
     std::shared_ptr<TextSurface>
         line_surfaces[nb_visible_lines];            /**< Text surface of each visible line. */
     Point text_position;                            /**< Destination position of the first line. */
@@ -19,9 +19,12 @@
 
 #include "solarus/core/Common.h"
 #include "solarus/core/Ability.h"
+#include "solarus/core/SavegameKey.h"
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 struct lua_State;
 
@@ -110,8 +113,18 @@ class SOLARUS_API Equipment {
     // items
     std::map<std::string, std::shared_ptr<EquipmentItem>>
         items;                                   /**< Each item (properties loaded from item scripts). */
-
-    std::string get_ability_savegame_variable(Ability ability) const;
+    std::vector<EquipmentItem*>
+        items_to_update;                         /**< Items whose script defines on_update(). */
+    bool items_to_update_valid;                  /**< Whether items_to_update is up to date. */
+    uint64_t items_to_update_revision;           /**< Revision of userdata fields when
+                                                  * items_to_update was built. */
+    bool items_to_update_from_metatable;         /**< Whether on_update() was defined in the
+                                                  * item metatable when items_to_update was built. */
+
+    void update_items_to_update();
+
+    const SavegameKey& get_ability_savegame_variable(Ability ability) const;
+    const SavegameKey& get_item_slot_savegame_variable(int slot) const;
 
 };
 
@@ -18,10 +18,15 @@
 #define SOLARUS_FONT_RESOURCE_H
 
 #include "solarus/core/Common.h"
+#include "solarus/graphics/Color.h"
 #include "solarus/graphics/SurfacePtr.h"
+#include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <SDL_ttf.h>
 
 namespace Solarus {
@@ -42,6 +47,55 @@ class FontResource {
     static SurfacePtr get_bitmap_font(const std::string& font_id);
     static TTF_Font& get_outline_font(const std::string& font_id, int size);
 
+    /**
+     * \brief A character of an outline font rendered alone.
+     */
+    struct Glyph {
+      SurfacePtr image;             /**< The character rendered alone, or nullptr if it has no pixels. */
+      int min_x;                    /**< Left of the image relative to the pen position. */
+      int max_x;                    /**< Right of the character relative to the pen position. */
+      int advance;                  /**< Horizontal distance to the next pen position. */
+    };
+
+    /**
+     * \brief Glyphs of an outline font rendered with a size, a rendering mode
+     * and a color.
+     *
+     * Glyphs are rendered the first time they are requested and kept with
+     * their metrics, so that texts can be composed without asking SDL_ttf
+     * to render them again.
+     */
+    class GlyphAtlas {
+
+      public:
+
+        GlyphAtlas(TTF_Font& font, bool antialiasing, const Color& color);
+
+        const Glyph* get_glyph(uint32_t code_point);
+        int get_kerning(uint32_t previous_code_point, uint32_t code_point) const;
+        int get_height() const;
+        size_t get_memory_size() const;
+
+      private:
+
+        TTF_Font& font;                 /**< The font at the size of this atlas. */
+        bool antialiasing;              /**< Whether glyphs are rendered blended or solid. */
+        Color color;                    /**< Color of the glyphs. */
+        std::unordered_map<uint32_t, Glyph>
+            glyphs;                     /**< Glyphs rendered so far, by code point. */
+        size_t memory_size;             /**< Bytes used by the images of the glyphs. */
+
+    };
+
+    using GlyphAtlasPtr = std::shared_ptr<GlyphAtlas>;
+
+    static GlyphAtlasPtr get_glyph_atlas(
+        const std::string& font_id,
+        int size,
+        bool antialiasing,
+        const Color& color
+    );
+
   private:
 
     struct SDL_RWops_Deleter {
@@ -79,10 +133,20 @@ class FontResource {
                                                        * Only used for outline fonts. */
     };
 
+    /**
+     * Font id, size, antialiasing and color of a glyph atlas.
+     */
+    using GlyphAtlasKey = std::tuple<std::string, int, bool, uint32_t>;
+
     static void load_fonts();
+    static void shrink_glyph_atlases();
 
     static bool fonts_loaded;
     static std::map<std::string, FontFile> fonts;
+    static std::list<std::pair<GlyphAtlasKey, GlyphAtlasPtr>>
+        glyph_atlases;                                /**< Glyph atlases from the most recently used one. */
+    static std::map<GlyphAtlasKey, std::list<std::pair<GlyphAtlasKey, GlyphAtlasPtr>>::iterator>
+        glyph_atlases_by_key;                         /**< Position of each glyph atlas in the list. */
 
 };
 
@@ -23,12 +23,15 @@
 #include "solarus/core/GameCommand.h"
 #include "solarus/core/GameCommands.h"
 #include "solarus/core/Point.h"
+#include "solarus/core/Rectangle.h"
 #include "solarus/entities/HeroPtr.h"
 #include "solarus/entities/NonAnimatedRegions.h"
 #include "solarus/graphics/SurfacePtr.h"
 #include "solarus/graphics/Transition.h"
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Solarus {
 
@@ -167,6 +170,11 @@ private:
         transition_style;      /**< the transition style between the current map and the next one */
     std::unique_ptr<Transition>
         transition;            /**< the transition currently shown, or nullptr if no transition is playing */
+    std::weak_ptr<Map>
+        preloading_map;        /**< the map whose teletransporters are in map_preloading_targets */
+    std::vector<std::pair<Rectangle, std::string>>
+        map_preloading_targets;/**< position and destination map of teletransporters of preloading_map
+                                * whose destination map is not preloaded yet */
 
     // world (i.e. the current set of maps)
     bool crystal_state;        /**< indicates that a crystal has been enabled (i.e. the orange blocks are raised) */
@@ -175,8 +183,12 @@ private:
     void update_commands_effects();
     void update_transitions();
     void update_gameover_sequence();
+    void update_map_preloading();
     void notify_map_changed();
 
+    // draw functions
+    bool is_screen_covered_by_camera(const Surface& dst_surface) const;
+
 };
 
 }
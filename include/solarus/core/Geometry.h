@@ -75,6 +75,10 @@ double get_angle(double x1, double y1, double x2, double y2);
 double get_angle(const Point& point1, const Point& point2);
 Point get_xy(double angle, int distance);
 Point get_xy(const Point& point1, double angle, int distance);
+double get_sin_degrees(int angle);
+double get_cos_degrees(int angle);
+Point get_xy_degrees(int angle, int distance);
+Point get_xy_degrees(const Point& point1, int angle, int distance);
 
 /**
  * \brief Returns the distance between two points.
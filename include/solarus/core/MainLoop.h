@@ -17,12 +17,14 @@
 #ifndef SOLARUS_MAIN_LOOP_H
 #define SOLARUS_MAIN_LOOP_H
 
+#include "solarus/containers/SpscQueue.h"
 #include "solarus/core/Common.h"
 #include "solarus/core/ResourceProvider.h"
 #include "solarus/graphics/SurfacePtr.h"
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -42,6 +44,16 @@ class SOLARUS_API MainLoop {
 
   public:
 
+    /**
+     * \brief Outcome of a Lua command executed by the console.
+     */
+    struct LuaCommandResult {
+      int id;                           /**< Number identifying the command. */
+      bool success;                     /**< Whether the command ran without error. */
+      std::vector<std::string> values;  /**< Values returned by the command converted to
+                                         * strings, or the error message. */
+    };
+
     explicit MainLoop(const Arguments& args);
     ~MainLoop();
 
@@ -56,18 +68,50 @@ class SOLARUS_API MainLoop {
     void set_game(Game* game);
     ResourceProvider& get_resource_provider();
     int push_lua_command(const std::string& command);
+    bool pop_lua_command_result(LuaCommandResult& result);
 
     LuaContext& get_lua_context();
 
   private:
 
+    /**
+     * \brief A Lua command waiting to be executed.
+     */
+    struct LuaCommand {
+      int id;                           /**< Number identifying the command. */
+      std::string code;                 /**< The Lua string to execute. */
+      bool keep_result;                 /**< Whether the result should be sent back
+                                         * on the channel. */
+    };
+
+    /**
+     * \brief Lock-free link between one console transport and the main loop.
+     *
+     * The transport thread is the only producer of commands and the only
+     * consumer of results, the main loop is the only consumer of commands
+     * and the only producer of results.
+     */
+    struct LuaCommandChannel {
+      explicit LuaCommandChannel(size_t capacity);
+
+      SpscQueue<LuaCommand> commands;   /**< Commands to run. */
+      SpscQueue<LuaCommandResult>
+          results;                      /**< Results of commands already run. */
+      int num_commands_pushed;          /**< Number of commands accepted so far,
+                                         * used as the id of the next one.
+                                         * Only accessed by the producer. */
+    };
+
+    int queue_lua_command(const std::string& command, bool keep_result);
     void check_input();
+    void run_lua_commands(LuaCommandChannel& channel, int& budget, bool print_banners);
     void notify_input(const InputEvent& event);
     void draw();
     void update();
 
     void load_quest_properties();
     void initialize_lua_console();
+    void initialize_lua_console_socket(const std::string& socket_path);
     void quit_lua_console();
 
     std::unique_ptr<LuaContext>
@@ -84,12 +128,17 @@ class SOLARUS_API MainLoop {
                                    * rather than following real time. */
 
     std::thread stdin_thread;     /**< Separate thread that reads Lua commands on stdin. */
-    std::vector<std::string>
-        lua_commands;             /**< Lua commands to run next cycle. */
+    std::thread socket_thread;    /**< Separate thread that serves Lua commands
+                                   * on a local socket. */
+    LuaCommandChannel
+        lua_commands;             /**< Commands from stdin and push_lua_command(). */
     std::mutex
-        lua_commands_mutex;       /**< Lock for the list of scheduled Lua commands. */
-    int num_lua_commands_pushed;  /**< Counter of Lua commands requested. */
-    int num_lua_commands_done;    /**< Counter of Lua commands executed. */
+        lua_commands_mutex;       /**< Makes the transport side of lua_commands safe
+                                   * when several threads push or pop. */
+    LuaCommandChannel
+        socket_lua_commands;      /**< Commands from the local socket. */
+    int lua_commands_budget;      /**< Maximum number of Lua commands to run
+                                   * per cycle (0 means no limit). */
 
 };
 
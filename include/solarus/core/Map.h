@@ -36,6 +36,7 @@ namespace Solarus {
 class Destination;
 class InputEvent;
 class LuaContext;
+class MapSnapshot;
 class Tileset;
 class Sprite;
 
@@ -55,6 +56,7 @@ class SOLARUS_API Map: public ExportableToLua {
 
     // creation and destruction
     explicit Map(const std::string& id);
+    ~Map();
 
     // map properties
     const std::string& get_id() const;
@@ -97,6 +99,8 @@ class SOLARUS_API Map: public ExportableToLua {
     // entities
     Entities& get_entities();
     const Entities& get_entities() const;
+    void save_snapshot();
+    bool restore_snapshot();
 
     // presence of the hero
     bool is_started() const;
@@ -130,6 +134,18 @@ class SOLARUS_API Map: public ExportableToLua {
         const Rectangle& collision_box,
         Entity& entity_to_check
     );
+    bool test_collision_with_obstacles(
+        int layer,
+        const Rectangle& collision_box,
+        Entity& entity_to_check,
+        const std::vector<Entity*>& candidate_obstacles
+    );
+    void get_candidate_obstacles(
+        int layer,
+        const Rectangle& area,
+        const Entity& entity_to_check,
+        std::vector<Entity*>& result
+    );
     bool test_collision_with_obstacles(
         int layer,
         int x,
@@ -165,6 +181,8 @@ class SOLARUS_API Map: public ExportableToLua {
     void check_collision_with_detectors(Entity& entity, Sprite& sprite);
     void check_collision_from_detector(Entity& detector);
     void check_collision_from_detector(Entity& detector, Sprite& detector_sprite);
+    uint64_t get_num_detector_candidates() const;
+    uint64_t get_num_detector_checks() const;
 
     // main loop
     bool notify_input(const InputEvent& event);
@@ -180,7 +198,11 @@ class SOLARUS_API Map: public ExportableToLua {
   private:
 
     void set_suspended(bool suspended);
-    void build_background_surface();
+    bool test_collision_with_ground(
+        int layer,
+        const Rectangle& collision_box,
+        const Entity& entity_to_check
+    ) const;
     void build_foreground_surface();
     void draw_background(const SurfacePtr& dst_surface);
     void draw_foreground(const SurfacePtr& dst_surface);
@@ -212,8 +234,6 @@ class SOLARUS_API Map: public ExportableToLua {
                                    * This is used to correctly scroll between adjacent maps. */
 
     // Quest screen
-    SurfacePtr
-        background_surface;       /**< A surface filled with the background color of the tileset. */
     SurfacePtr
         foreground_surface;       /**< A surface with black bars when the map is smaller than the screen. */
 
@@ -228,7 +248,15 @@ class SOLARUS_API Map: public ExportableToLua {
 
     std::unique_ptr<Entities>
         entities;                 /**< The entities on the map. */
+    std::unique_ptr<MapSnapshot>
+        snapshot;                 /**< State of the entities saved by save_snapshot(), or nullptr. */
     bool suspended;               /**< Whether the game is suspended. */
+
+    // statistics
+    uint64_t num_detector_candidates;
+                                  /**< Number of detectors found near moving entities. */
+    uint64_t num_detector_checks; /**< Number of those detectors that were enabled
+                                   * and not suspended, so actually checked. */
 };
 
 /**
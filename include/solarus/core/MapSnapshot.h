@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_MAP_SNAPSHOT_H
+#define SOLARUS_MAP_SNAPSHOT_H
+
+#include "solarus/core/Common.h"
+#include "solarus/core/Point.h"
+#include "solarus/entities/EntityPtr.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Solarus {
+
+class Map;
+
+/**
+ * \brief Captures the state of the entities of a map to restore it later.
+ *
+ * The state of each entity includes its position, layer, direction,
+ * enabled state and the animation, direction, frame and pause state of
+ * its sprites.
+ * Movements, timers, custom states and Lua data are not captured:
+ * scripts can save and restore them from the map:on_snapshot() and
+ * map:on_restore_snapshot() events.
+ *
+ * Entities created after the snapshot are kept as they are by restore(),
+ * and entities removed since the snapshot are not recreated.
+ */
+class SOLARUS_API MapSnapshot {
+
+  public:
+
+    explicit MapSnapshot(Map& map);
+
+    const std::string& get_map_id() const;
+    size_t get_num_entities() const;
+
+    void restore(Map& map) const;
+
+  private:
+
+    /**
+     * \brief State of a sprite of an entity.
+     */
+    struct SpriteState {
+      std::string animation;            /**< Current animation. */
+      int direction;                    /**< Current direction. */
+      int frame;                        /**< Current frame. */
+      bool paused;                      /**< Whether the animation is paused. */
+    };
+
+    /**
+     * \brief State of an entity.
+     */
+    struct EntityState {
+      std::weak_ptr<Entity> entity;     /**< The entity. */
+      Point xy;                         /**< Position of its origin point. */
+      int layer;                        /**< Layer on the map. */
+      int direction;                    /**< Direction of the entity. */
+      bool enabled;                     /**< Whether the entity is enabled. */
+      std::vector<SpriteState> sprites; /**< State of each sprite, in order. */
+    };
+
+    std::string map_id;                 /**< Id of the map captured. */
+    std::vector<EntityState> entities;  /**< State of each entity of the map. */
+
+};
+
+}
+
+#endif
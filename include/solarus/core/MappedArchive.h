@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_MAPPED_ARCHIVE_H
+#define SOLARUS_MAPPED_ARCHIVE_H
+
+#include "solarus/core/Common.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+namespace Solarus {
+
+/**
+ * \brief Read-only memory mapping of a zip archive.
+ *
+ * Gives direct access to the entries of the archive that are stored
+ * without compression. Such entries can be read in place, without any copy
+ * and without going through the zip decompressor.
+ * Compressed entries are ignored: they must be read through PhysFS.
+ *
+ * Memory mapping is only available on POSIX systems for now.
+ * Elsewhere, open() always fails and everything is read through PhysFS.
+ */
+class SOLARUS_API MappedArchive {
+
+  public:
+
+    MappedArchive();
+    ~MappedArchive();
+
+    MappedArchive(const MappedArchive& other) = delete;
+    MappedArchive& operator=(const MappedArchive& other) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const;
+    const std::string& get_path() const;
+
+    size_t get_num_entries() const;
+    bool get_entry(const std::string& name, const char*& data, size_t& size) const;
+
+  private:
+
+    /**
+     * \brief Location of an uncompressed entry in the archive.
+     */
+    struct Entry {
+      size_t offset;          /**< Position of the data in the archive. */
+      size_t size;            /**< Size of the data. */
+    };
+
+    bool parse_central_directory();
+
+    std::string path;         /**< Path of the archive file, empty if not open. */
+    const char* data;         /**< The mapped archive, or nullptr. */
+    size_t size;              /**< Size of the mapped archive. */
+    std::unordered_map<std::string, Entry>
+        entries;              /**< Uncompressed entries by file name. */
+
+};
+
+}
+
+#endif
+
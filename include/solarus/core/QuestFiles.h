@@ -22,6 +22,7 @@
 #include <vector>
 
 struct lua_State;
+struct SDL_RWops;
 
 namespace Solarus {
 
@@ -71,10 +72,18 @@ SOLARUS_API std::string data_file_read(
     const std::string& file_name,
     bool language_specific = false
 );
+SOLARUS_API SDL_RWops* data_file_open_rw(
+    const std::string& file_name,
+    bool language_specific = false
+);
 SOLARUS_API void data_file_save(
     const std::string& file_name,
     const std::string& buffer
 );
+SOLARUS_API void data_file_save_async(
+    const std::string& file_name,
+    std::string buffer
+);
 SOLARUS_API bool data_file_delete(const std::string& file_name);
 SOLARUS_API bool data_file_mkdir(const std::string& dir_name);
 
@@ -18,11 +18,15 @@
 #define SOLARUS_RESOURCE_PROVIDER_H
 
 #include "solarus/core/Common.h"
+#include "solarus/core/MapData.h"
 #include "solarus/core/ResourceType.h"
 #include "solarus/entities/Tileset.h"
 #include "solarus/entities/TilePattern.h"
+#include <future>
+#include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 
 namespace Solarus {
@@ -40,13 +44,37 @@ class SOLARUS_API ResourceProvider {
     ResourceProvider();
 
     const Tileset& get_tileset(const std::string& tileset_id);
+    std::shared_ptr<const MapData> get_map_data(const std::string& map_id);
+    void preload_map(const std::string& map_id);
     // TODO other types of resources
 
+    void update();
+    void finish_all_map_preloading();
     void invalidate_resource_element(ResourceType resource_type, const std::string& element_id);
 
   private:
 
+    /**
+     * \brief Resources of a map loaded in background.
+     */
+    struct PreloadedMap {
+      std::shared_ptr<const MapData> map_data;   /**< The map data, or nullptr if it could not be loaded. */
+      std::unique_ptr<Tileset> tileset;          /**< Its tileset, or nullptr if it was already loaded. */
+    };
+
+    static PreloadedMap load_map_in_background(
+        const std::string& map_id,
+        const std::set<std::string>& loaded_tileset_ids
+    );
+    void finish_map_preloading(const std::string& map_id);
+    std::shared_ptr<const MapData> load_map_data(const std::string& map_id);
+    void add_map_data(const std::string& map_id, const std::shared_ptr<const MapData>& data);
+
     std::map<std::string, std::unique_ptr<Tileset>> tileset_cache;          /**< Cache of loaded tilesets. */
+    std::map<std::string, std::shared_ptr<const MapData>> map_data_cache;   /**< Cache of recently loaded map data. */
+    std::list<std::string> map_data_order;                                  /**< Ids of cached map data,
+                                                                             * most recently used first. */
+    std::map<std::string, std::future<PreloadedMap>> map_preloads;          /**< Maps being loaded in background. */
 };
 
 }
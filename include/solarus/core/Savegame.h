@@ -18,10 +18,13 @@
 #define SOLARUS_SAVEGAME_H
 
 #include "solarus/core/Common.h"
+#include "solarus/core/EnumInfo.h"
 #include "solarus/core/Equipment.h"
+#include "solarus/core/SavegameKey.h"
 #include "solarus/lua/ExportableToLua.h"
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 struct lua_State;
 
@@ -30,6 +33,21 @@ namespace Solarus {
 class LuaContext;
 class MainLoop;
 
+/**
+ * \brief File formats of savegames.
+ */
+enum class SavegameFormat {
+  TEXT,      /**< Lua source code, readable and editable by humans. */
+  BINARY     /**< Compact binary format, faster to load and save. */
+};
+
+template <>
+struct SOLARUS_API EnumInfoTraits<SavegameFormat> {
+  static const std::string pretty_name;
+
+  static const EnumInfo<SavegameFormat>::names_type names;
+};
+
 /**
  * \brief Manages the game data saved.
  *
@@ -40,50 +58,51 @@ class SOLARUS_API Savegame: public ExportableToLua {
   public:
 
     static const int SAVEGAME_VERSION;  /**< Version number of the savegame file format. */
+    static const int BINARY_FORMAT_VERSION;  /**< Version number of the binary encoding. */
 
     // Keys to built-in values saved.
-    static const std::string KEY_SAVEGAME_VERSION;
-    static const std::string KEY_STARTING_MAP;
-    static const std::string KEY_STARTING_POINT;
-    static const std::string KEY_KEYBOARD_ACTION;
-    static const std::string KEY_KEYBOARD_ATTACK;
-    static const std::string KEY_KEYBOARD_ITEM_1;
-    static const std::string KEY_KEYBOARD_ITEM_2;
-    static const std::string KEY_KEYBOARD_PAUSE;
-    static const std::string KEY_KEYBOARD_RIGHT;
-    static const std::string KEY_KEYBOARD_UP;
-    static const std::string KEY_KEYBOARD_LEFT;
-    static const std::string KEY_KEYBOARD_DOWN;
-    static const std::string KEY_JOYPAD_ACTION;
-    static const std::string KEY_JOYPAD_ATTACK;
-    static const std::string KEY_JOYPAD_ITEM_1;
-    static const std::string KEY_JOYPAD_ITEM_2;
-    static const std::string KEY_JOYPAD_PAUSE;
-    static const std::string KEY_JOYPAD_RIGHT;
-    static const std::string KEY_JOYPAD_UP;
-    static const std::string KEY_JOYPAD_LEFT;
-    static const std::string KEY_JOYPAD_DOWN;
-    static const std::string KEY_CURRENT_LIFE;
-    static const std::string KEY_CURRENT_MONEY;
-    static const std::string KEY_CURRENT_MAGIC;
-    static const std::string KEY_MAX_LIFE;
-    static const std::string KEY_MAX_MONEY;
-    static const std::string KEY_MAX_MAGIC;
-    static const std::string KEY_ITEM_SLOT_1;
-    static const std::string KEY_ITEM_SLOT_2;
-    static const std::string KEY_ABILITY_TUNIC;
-    static const std::string KEY_ABILITY_SWORD;
-    static const std::string KEY_ABILITY_SWORD_KNOWLEDGE;
-    static const std::string KEY_ABILITY_SHIELD;
-    static const std::string KEY_ABILITY_LIFT;
-    static const std::string KEY_ABILITY_SWIM;
-    static const std::string KEY_ABILITY_JUMP_OVER_WATER;
-    static const std::string KEY_ABILITY_RUN;
-    static const std::string KEY_ABILITY_PUSH;
-    static const std::string KEY_ABILITY_GRAB;
-    static const std::string KEY_ABILITY_PULL;
-    static const std::string KEY_ABILITY_DETECT_WEAK_WALLS;
-    static const std::string KEY_ABILITY_GET_BACK_FROM_DEATH;
+    static const SavegameKey KEY_SAVEGAME_VERSION;
+    static const SavegameKey KEY_STARTING_MAP;
+    static const SavegameKey KEY_STARTING_POINT;
+    static const SavegameKey KEY_KEYBOARD_ACTION;
+    static const SavegameKey KEY_KEYBOARD_ATTACK;
+    static const SavegameKey KEY_KEYBOARD_ITEM_1;
+    static const SavegameKey KEY_KEYBOARD_ITEM_2;
+    static const SavegameKey KEY_KEYBOARD_PAUSE;
+    static const SavegameKey KEY_KEYBOARD_RIGHT;
+    static const SavegameKey KEY_KEYBOARD_UP;
+    static const SavegameKey KEY_KEYBOARD_LEFT;
+    static const SavegameKey KEY_KEYBOARD_DOWN;
+    static const SavegameKey KEY_JOYPAD_ACTION;
+    static const SavegameKey KEY_JOYPAD_ATTACK;
+    static const SavegameKey KEY_JOYPAD_ITEM_1;
+    static const SavegameKey KEY_JOYPAD_ITEM_2;
+    static const SavegameKey KEY_JOYPAD_PAUSE;
+    static const SavegameKey KEY_JOYPAD_RIGHT;
+    static const SavegameKey KEY_JOYPAD_UP;
+    static const SavegameKey KEY_JOYPAD_LEFT;
+    static const SavegameKey KEY_JOYPAD_DOWN;
+    static const SavegameKey KEY_CURRENT_LIFE;
+    static const SavegameKey KEY_CURRENT_MONEY;
+    static const SavegameKey KEY_CURRENT_MAGIC;
+    static const SavegameKey KEY_MAX_LIFE;
+    static const SavegameKey KEY_MAX_MONEY;
+    static const SavegameKey KEY_MAX_MAGIC;
+    static const SavegameKey KEY_ITEM_SLOT_1;
+    static const SavegameKey KEY_ITEM_SLOT_2;
+    static const SavegameKey KEY_ABILITY_TUNIC;
+    static const SavegameKey KEY_ABILITY_SWORD;
+    static const SavegameKey KEY_ABILITY_SWORD_KNOWLEDGE;
+    static const SavegameKey KEY_ABILITY_SHIELD;
+    static const SavegameKey KEY_ABILITY_LIFT;
+    static const SavegameKey KEY_ABILITY_SWIM;
+    static const SavegameKey KEY_ABILITY_JUMP_OVER_WATER;
+    static const SavegameKey KEY_ABILITY_RUN;
+    static const SavegameKey KEY_ABILITY_PUSH;
+    static const SavegameKey KEY_ABILITY_GRAB;
+    static const SavegameKey KEY_ABILITY_PULL;
+    static const SavegameKey KEY_ABILITY_DETECT_WEAK_WALLS;
+    static const SavegameKey KEY_ABILITY_GET_BACK_FROM_DEATH;
 
     // creation and destruction
     Savegame(MainLoop& main_loop, const std::string& file_name);
@@ -93,8 +112,22 @@ class SOLARUS_API Savegame: public ExportableToLua {
     void initialize();
     void save();
     const std::string& get_file_name() const;
+    SavegameFormat get_format() const;
+    void set_format(SavegameFormat format);
 
     // data
+    bool is_string(const SavegameKey& key) const;
+    std::string get_string(const SavegameKey& key) const;
+    void set_string(const SavegameKey& key, const std::string& value);
+    bool is_integer(const SavegameKey& key) const;
+    int get_integer(const SavegameKey& key) const;
+    void set_integer(const SavegameKey& key, int value);
+    bool is_boolean(const SavegameKey& key) const;
+    bool get_boolean(const SavegameKey& key) const;
+    void set_boolean(const SavegameKey& key, bool value);
+    bool is_set(const SavegameKey& key) const;
+    void unset(const SavegameKey& key);
+
     bool is_string(const std::string& key) const;
     std::string get_string(const std::string& key) const;
     void set_string(const std::string& key, const std::string& value);
@@ -129,6 +162,7 @@ class SOLARUS_API Savegame: public ExportableToLua {
     struct SavedValue {
 
       enum {
+        VALUE_UNSET,
         VALUE_STRING,
         VALUE_INTEGER,
         VALUE_BOOLEAN
@@ -138,15 +172,24 @@ class SOLARUS_API Savegame: public ExportableToLua {
       int int_data;  // Also used for boolean
     };
 
-    std::map<std::string, SavedValue> saved_values;
+    std::unordered_map<size_t, SavedValue>
+        saved_values;        /**< Values set, indexed by key index. */
 
     bool empty;
     std::string file_name;   /**< Savegame file name relative to the quest write directory. */
+    SavegameFormat format;   /**< Format to use when saving. */
     MainLoop& main_loop;
     Equipment equipment;
     Game* game;              /**< nullptr if this savegame is not currently running */
 
+    const SavedValue* find_value(const SavegameKey& key) const;
+    SavedValue& get_value_to_set(const SavegameKey& key);
+    std::vector<SavegameKey> get_sorted_keys() const;
+
     void import_from_file();
+    void import_from_binary(const std::string& buffer);
+    std::string export_to_text() const;
+    std::string export_to_binary() const;
     static int l_newindex(lua_State* l);
 
 };
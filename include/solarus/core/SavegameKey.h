@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_SAVEGAME_KEY_H
+#define SOLARUS_SAVEGAME_KEY_H
+
+#include "solarus/core/Common.h"
+#include <cstddef>
+#include <string>
+
+namespace Solarus {
+
+/**
+ * \brief Interned name of a savegame variable.
+ *
+ * Creating a key from a name hashes the name once and gives it a small
+ * integer index, shared by all savegames. The index never changes for the
+ * rest of the execution, so keys can be created in advance (like the
+ * built-in keys of Savegame) and then used for direct lookups.
+ *
+ * Keys must only be created from the main thread.
+ * Interned names are never forgotten, so only names of values actually
+ * stored should be interned: use find() to look up other names.
+ */
+class SOLARUS_API SavegameKey {
+
+  public:
+
+    SavegameKey();
+    explicit SavegameKey(const std::string& name);
+
+    static bool find(const std::string& name, SavegameKey& key);
+    static SavegameKey from_index(size_t index);
+    static size_t get_num_keys();
+
+    size_t get_index() const;
+    const std::string& get_name() const;
+    bool is_valid_name() const;
+
+    bool operator==(const SavegameKey& other) const;
+    bool operator!=(const SavegameKey& other) const;
+
+  private:
+
+    size_t index;      /**< Index of this name in the table of interned names. */
+
+};
+
+/**
+ * \brief Returns the index of this key.
+ *
+ * Indexes are consecutive integers starting at zero.
+ *
+ * \return The index.
+ */
+inline size_t SavegameKey::get_index() const {
+  return index;
+}
+
+/**
+ * \brief Returns whether two keys have the same name.
+ * \param other Another key.
+ * \return \c true if both keys are the same.
+ */
+inline bool SavegameKey::operator==(const SavegameKey& other) const {
+  return index == other.index;
+}
+
+/**
+ * \brief Returns whether two keys have different names.
+ * \param other Another key.
+ * \return \c true if the keys are different.
+ */
+inline bool SavegameKey::operator!=(const SavegameKey& other) const {
+  return index != other.index;
+}
+
+}
+
+#endif
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_ANIMATED_REGIONS_H
+#define SOLARUS_ANIMATED_REGIONS_H
+
+#include "solarus/core/Common.h"
+#include "solarus/containers/Grid.h"
+#include "solarus/entities/TilePtr.h"
+#include "solarus/graphics/SurfacePtr.h"
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+namespace Solarus {
+
+class Map;
+
+/**
+ * \brief Manages the tiles that are in animated regions.
+ *
+ * These are the animated tiles and the non-animated tiles overlapping them.
+ * When all tiles of a cell of the map only depend on the frame counter of
+ * animated tile patterns, the cell is drawn once per animation frame on an
+ * intermediate surface, lazily when the camera shows it.
+ * Other tiles are drawn individually at each frame.
+ *
+ * The memory used by cached cells is limited: the least recently drawn ones
+ * are discarded first.
+ */
+class AnimatedRegions {
+
+  public:
+
+    AnimatedRegions(Map& map, int layer);
+
+    void build(const std::vector<TilePtr>& tiles);
+    void notify_tileset_changed();
+    void draw_on_map();
+
+  private:
+
+    /**
+     * \brief A cached animation frame of a cell: cell index and frame index.
+     */
+    using CellFrame = std::pair<int, int>;
+
+    /**
+     * \brief Cached drawings of a cell of the grid.
+     */
+    struct Cell {
+      bool cached = false;                  /**< Whether this cell contains tiles drawn from
+                                             * cached surfaces. */
+      int frame_period = 1;                 /**< Number of different frames of the cell. */
+      std::vector<SurfacePtr> frames;       /**< Cached surface of each frame or nullptr. */
+      std::vector<std::list<CellFrame>::iterator>
+          lru_positions;                    /**< Position of each cached frame in the LRU list. */
+    };
+
+    void draw_cell(int cell_index, const Point& dst_position);
+    void build_cell_frame(int cell_index, int frame);
+    void discard_cell_frame(CellFrame cell_frame);
+
+    Map& map;                               /**< The map. */
+    int layer;                              /**< Layer of the map managed by this object. */
+    Grid<TilePtr> cached_tiles;             /**< Tiles drawn from cached cell surfaces. */
+    std::vector<Cell> cells;                /**< Cache of each cell of the grid. */
+    std::vector<TilePtr> individual_tiles;  /**< Tiles drawn individually at each frame. */
+    std::list<CellFrame> lru_frames;        /**< Cached frames, most recently drawn first. */
+    size_t cached_memory_size;              /**< Bytes used by cached frame surfaces. */
+
+};
+
+}
+
+#endif
@@ -48,6 +48,7 @@ class AnimatedTilePattern: public TilePattern {
     static void initialize();
     static void update();
     static void quit();
+    static int get_frame_counter();
 
     virtual void draw(
         const SurfacePtr& dst_surface,
@@ -56,6 +57,7 @@ class AnimatedTilePattern: public TilePattern {
         const Point& viewport
     ) const override;
     virtual bool is_drawn_at_its_position() const override;
+    virtual int get_frame_period() const override;
 
   private:
 
@@ -18,6 +18,7 @@
 #define SOLARUS_ENTITIES_H
 
 #include "solarus/core/Common.h"
+#include "solarus/containers/Grid.h"
 #include "solarus/containers/Quadtree.h"
 #include "solarus/graphics/Transition.h"
 #include "solarus/entities/Camera.h"
@@ -37,10 +38,13 @@
 
 namespace Solarus {
 
+class AnimatedRegions;
 class Destination;
+class EntityData;
 class Hero;
 class Map;
 class MapData;
+class Movement;
 class NonAnimatedRegions;
 class Rectangle;
 class Tileset;
@@ -67,6 +71,7 @@ class SOLARUS_API Entities {
 
     // Creation and destruction.
     Entities(Game& game, Map& map);
+    ~Entities();
 
     // Get entities.
     Hero& get_hero();
@@ -84,6 +89,7 @@ class SOLARUS_API Entities {
     EntityVector get_entities_with_prefix(EntityType type, const std::string& prefix);
     EntityVector get_entities_with_prefix_sorted(EntityType type, const std::string& prefix);
     bool has_entity_with_prefix(const std::string& prefix) const;
+    int get_num_entities_with_prefix(const std::string& prefix) const;
 
     // By type.
     EntitySet get_entities_by_type(EntityType type);
@@ -105,6 +111,7 @@ class SOLARUS_API Entities {
     void get_entities_in_rectangle(const Rectangle& rectangle, EntityVector& result);
     void get_entities_in_rectangle_sorted(const Rectangle& rectangle, ConstEntityVector& result) const;
     void get_entities_in_rectangle_sorted(const Rectangle& rectangle, EntityVector& result);
+    void get_detectors_in_rectangle(const Rectangle& rectangle, int layer, EntityVector& result);
 
     // By separator region.
     void get_entities_in_region(const Point& xy, EntityVector& result);
@@ -112,7 +119,7 @@ class SOLARUS_API Entities {
     Rectangle get_region_box(const Point& point) const;
 
     // Handle entities.
-    void create_entities(const MapData& data);
+    void create_entities(const std::shared_ptr<const MapData>& data);
     void add_tile_info(const TileInfo& tile);
     void add_entity(const EntityPtr& entity);
     void add_tile(const TilePtr& entity);
@@ -124,6 +131,7 @@ class SOLARUS_API Entities {
     void bring_to_back(Entity& entity);
     void set_entity_layer(Entity& entity, int layer);
     void notify_entity_bounding_box_changed(Entity& entity);
+    void notify_entity_detector_changed(Entity& entity);
 
     // Specific to some entity types.
     bool overlaps_raised_blocks(int layer, const Rectangle& rectangle) ;
@@ -163,6 +171,8 @@ class SOLARUS_API Entities {
 
         int get_z(const ConstEntityPtr& entity) const;
         void add(const ConstEntityPtr& entity);
+        void add(const ConstEntityPtr& entity, int z);
+        int reserve();
         void remove(const ConstEntityPtr& entity);
         void bring_to_front(const ConstEntityPtr& entity);
         void bring_to_back(const ConstEntityPtr& entity);
@@ -174,11 +184,35 @@ class SOLARUS_API Entities {
         int max;
     };
 
+    /**
+     * \brief An entity of the map data file whose creation is delayed.
+     */
+    struct DormantEntity {
+      const EntityData* data;   /**< Description of the entity in the map data. */
+      int z;                    /**< Z order reserved for the entity on its layer. */
+    };
+
+    /**
+     * \brief A movement updated before the entities, with others of its type.
+     */
+    struct BatchedMovement {
+      EntityPtr entity;                     /**< Entity moved at the start of the batch. */
+      std::shared_ptr<Movement> movement;   /**< The movement. */
+    };
+
     void initialize_layers();
+    void create_dormant_entities(const Rectangle& where);
+    void create_all_dormant_entities();
+    void create_dormant_entity(const DormantEntity& dormant_entity);
+
+    EntityTree& get_detector_tree(const Entity& entity);
+    void add_detector(const EntityPtr& entity);
+    void remove_detector(const EntityPtr& entity);
     void set_tile_ground(int layer, int x8, int y8, Ground ground);
     void remove_marked_entities();
     void notify_entity_removed(Entity& entity);
     void update_crystal_blocks();
+    void update_batched_movements();
 
     // map
     Game& game;                                     /**< The game running this map */
@@ -195,8 +229,9 @@ class SOLARUS_API Entities {
     ByLayer<std::unique_ptr<NonAnimatedRegions>>
         non_animated_regions;                       /**< For each layer, all non-animated tiles are managed
                                                      * here for performance. */
-    ByLayer<std::vector<TilePtr>>
-        tiles_in_animated_regions;                  /**< For each layer, animated tiles and tiles overlapping them. */
+    ByLayer<std::unique_ptr<AnimatedRegions>>
+        animated_regions;                           /**< For each layer, animated tiles and tiles overlapping
+                                                     * them are managed here for performance. */
 
     // dynamic entities
     HeroPtr hero;                                   /**< The hero, also stored in Game because
@@ -211,6 +246,11 @@ class SOLARUS_API Entities {
 
     EntityTree quadtree;                            /**< All map entities except tiles.
                                                      * Optimized for fast spatial search. */
+    ByLayer<std::unique_ptr<EntityTree>>
+        detectors;                                  /**< For each layer, entities of quadtree that detect
+                                                     * collisions with entities of their layer. */
+    EntityTree layer_independent_detectors;         /**< Entities of quadtree that detect collisions
+                                                     * with entities of any layer. */
     ByLayer<ZCache> z_caches;                       /**< For each layer, tracks the relative Z order of entities. */
     ByLayer<EntityVector>
         entities_drawn_not_at_their_position;       /**< For each layer, entities to draw even if there position
@@ -218,10 +258,25 @@ class SOLARUS_API Entities {
     ByLayer<EntitiesToDraw> entities_to_draw;       /**< For each layer, entities to be drawn at this cycle. */
 
     EntityList entities_to_remove;                  /**< List of entities that need to be removed right now. */
+    std::vector<BatchedMovement>
+        batched_straight_movements;                 /**< Straight movements updated in a batch at this cycle. */
+    std::vector<BatchedMovement>
+        batched_circle_movements;                   /**< Circle movements updated in a batch at this cycle. */
+    std::vector<BatchedMovement>
+        batched_pixel_movements;                    /**< Pixel movements updated in a batch at this cycle. */
 
     std::shared_ptr<Destination>
         default_destination;                        /**< Default destination of this map or nullptr. */
 
+    // entities not created yet
+    std::shared_ptr<const MapData> map_data;        /**< Map data file, kept while there are dormant entities. */
+    Grid<DormantEntity> dormant_entities;           /**< Unnamed destructibles of the map data file, created
+                                                     * only when something may see them. */
+    std::vector<bool> are_dormant_cells_created;    /**< Whether each cell of dormant_entities was created. */
+    size_t num_dormant_entities;                    /**< Number of dormant entities not created yet. */
+    const DormantEntity*
+        dormant_entity_being_created;               /**< Dormant entity currently being created or nullptr. */
+
 };
 
 /**
@@ -263,6 +318,11 @@ std::set<std::shared_ptr<const T>> Entities::get_entities_by_type() const {
   std::set<std::shared_ptr<const T>> result;
 
   const EntityType type = T::ThisType;
+  if (type == EntityType::DESTRUCTIBLE) {
+    // Creating dormant entities does not change the content of the map
+    // as seen from outside.
+    const_cast<Entities*>(this)->create_all_dormant_entities();
+  }
   const auto& it = entities_by_type.find(type);
   if (it == entities_by_type.end()) {
     return result;
@@ -286,6 +346,9 @@ std::set<std::shared_ptr<T>> Entities::get_entities_by_type() {
   std::set<std::shared_ptr<T>> result;
 
   const EntityType type = T::ThisType;
+  if (type == EntityType::DESTRUCTIBLE) {
+    create_all_dormant_entities();
+  }
   const auto& it = entities_by_type.find(type);
   if (it == entities_by_type.end()) {
     return result;
@@ -310,6 +373,11 @@ std::set<std::shared_ptr<const T>> Entities::get_entities_by_type(int layer) con
   std::set<std::shared_ptr<const T>> result;
 
   const EntityType type = T::ThisType;
+  if (type == EntityType::DESTRUCTIBLE) {
+    // Creating dormant entities does not change the content of the map
+    // as seen from outside.
+    const_cast<Entities*>(this)->create_all_dormant_entities();
+  }
   const auto& it = entities_by_type.find(type);
   if (it == entities_by_type.end()) {
     return result;
@@ -337,6 +405,9 @@ std::set<std::shared_ptr<T>> Entities::get_entities_by_type(int layer) {
   std::set<std::shared_ptr<T>> result;
 
   const EntityType type = T::ThisType;
+  if (type == EntityType::DESTRUCTIBLE) {
+    create_all_dormant_entities();
+  }
   const auto& it = entities_by_type.find(type);
   if (it == entities_by_type.end()) {
     return result;
@@ -184,6 +184,7 @@ class SOLARUS_API Entity: public ExportableToLua {
 
     bool is_enabled() const;
     void set_enabled(bool enable);
+    bool set_enabled_state(bool enabled);
     virtual void notify_enabled(bool enabled);
 
     // Properties.
@@ -31,6 +31,7 @@
 namespace Solarus {
 
 class Color;
+class Rectangle;
 class Size;
 class SoftwarePixelFilter;
 class Surface;
@@ -91,7 +92,10 @@ class Surface: public Drawable {
     bool is_pixel_transparent(int index) const;
 
     std::string get_pixels() const;
+    std::string get_pixels(const Rectangle& region) const;
     void set_pixels(const std::string& buffer);
+    void set_pixels(const std::string& buffer, const Rectangle& region);
+    bool is_region_valid(const Rectangle& region) const;
 
     void apply_pixel_filter(const SoftwarePixelFilter& pixel_filter, Surface& dst_surface);
 
@@ -114,6 +118,18 @@ class Surface: public Drawable {
 
   private:
 
+    /**
+     * \brief Whether all pixels of a surface are opaque.
+     */
+    enum class OpaqueState {
+      UNKNOWN,     /**< Not computed since the last change of pixels. */
+      OPAQUE,      /**< All pixels are opaque. */
+      NOT_OPAQUE   /**< Some pixels are transparent or translucent. */
+    };
+
+    bool is_opaque() const;
+    void notify_pixels_changed();
+
     uint32_t get_pixel(int index) const;
     uint32_t get_color_value(const Color& color) const;
     SDL_BlendMode get_sdl_blend_mode() const;
@@ -127,6 +143,7 @@ class Surface: public Drawable {
     SDL_Surface_UniquePtr
         alpha_color_surface;              /**< Intermediate surface needed to fill with non-opaque colors. */
     uint8_t opacity;                      /**< Opacity (0: transparent, 255: opaque). */
+    mutable OpaqueState opaque_state;     /**< Whether all pixels are opaque, computed on demand. */
 };
 
 }
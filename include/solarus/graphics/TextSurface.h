@@ -21,6 +21,7 @@
 #include "solarus/core/Point.h"
 #include "solarus/graphics/Color.h"
 #include "solarus/graphics/Drawable.h"
+#include <cstdint>
 #include <map>
 #include <string>
 #include <SDL_ttf.h>
@@ -117,9 +118,26 @@ class TextSurface: public Drawable {
 
   private:
 
+    /**
+     * \brief Pen state after composing the text from cached glyphs.
+     *
+     * Kept so that characters appended to the text can be composed
+     * without laying out the previous ones again.
+     */
+    struct GlyphLayout {
+      bool valid = false;                             /**< Whether the surface was composed from glyphs. */
+      int min_x = 0;                                  /**< Left of the text relative to the initial pen position. */
+      int max_x = 0;                                  /**< Right of the text relative to the initial pen position. */
+      int pen_x = 0;                                  /**< Current pen position. */
+      uint32_t last_code_point = 0;                   /**< Last character composed, for kerning. */
+    };
+
     void rebuild();
     void rebuild_bitmap();
     void rebuild_ttf();
+    void append_bitmap(const std::string& chars);
+    bool append_ttf(const std::string& chars);
+    void update_text_position();
 
     std::string font_id;                              /**< id of the font of the current text surface */
     HorizontalAlignment horizontal_alignment;         /**< horizontal alignment of the current text surface */
@@ -135,6 +153,8 @@ class TextSurface: public Drawable {
     Point text_position;                              /**< position of the top-left corner of the surface on the screen */
 
     std::string text;                                 /**< the string to draw (only one line) */
+    int num_chars;                                    /**< number of characters drawn with a bitmap font */
+    GlyphLayout glyph_layout;                         /**< layout of the text drawn with an outline font */
 
 };
 
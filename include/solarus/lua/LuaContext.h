@@ -76,6 +76,7 @@ class Pickable;
 class Point;
 class RandomMovement;
 class RandomPathMovement;
+class SavegameKey;
 class Sensor;
 class Separator;
 class Shader;
@@ -203,6 +204,15 @@ class LuaContext {
         const ExportableToLua& userdata,
         const std::string& key
     ) const;
+    bool userdata_has_metafield(
+        const ExportableToLua& userdata,
+        const char* key
+    ) const;
+    bool metatable_has_field(
+        const std::string& type_name,
+        const char* key
+    ) const;
+    uint64_t get_userdata_fields_revision() const;
     void notify_userdata_destroyed(ExportableToLua& userdata);
     void userdata_close_lua();
 
@@ -368,6 +378,8 @@ class LuaContext {
     bool map_on_input(Map& map, const InputEvent& event);
     bool map_on_command_pressed(Map& map, GameCommand command);
     bool map_on_command_released(Map& map, GameCommand command);
+    void map_on_snapshot(Map& map);
+    void map_on_restore_snapshot(Map& map);
 
     // Map entity events.
     void entity_on_update(Entity& entity);
@@ -460,6 +472,7 @@ class LuaContext {
       audio_api_set_sound_volume,
       audio_api_play_sound,
       audio_api_preload_sounds,
+      audio_api_get_sound_voices,
       audio_api_get_music_volume,
       audio_api_set_music_volume,
       audio_api_play_music,
@@ -625,6 +638,8 @@ class LuaContext {
       movement_api_start,
       movement_api_stop,
       movement_api_get_direction4,
+      movement_api_is_swept,
+      movement_api_set_swept,
       straight_movement_api_get_speed,
       straight_movement_api_set_speed,
       straight_movement_api_get_angle,
@@ -655,6 +670,7 @@ class LuaContext {
       path_movement_api_set_loop,
       path_movement_api_get_snap_to_grid,
       path_movement_api_set_snap_to_grid,
+      path_movement_api_fast_forward,
       random_path_movement_api_get_speed,
       random_path_movement_api_set_speed,
       random_path_movement_api_get_angle,
@@ -697,6 +713,8 @@ class LuaContext {
       game_api_delete,
       game_api_load,
       game_api_save,  // TODO allow to change the file name (e.g. to copy)
+      game_api_get_save_format,
+      game_api_set_save_format,
       game_api_start,
       game_api_is_started,
       game_api_is_suspended,
@@ -825,6 +843,9 @@ class LuaContext {
       map_api_get_hero,
       map_api_set_entities_enabled,
       map_api_remove_entities,
+      map_api_save_snapshot,
+      map_api_restore_snapshot,
+      map_api_get_detector_stats,
       map_api_create_entity,  // Same function used for all entity types.
 
       // Map entity API.
@@ -1070,8 +1091,6 @@ class LuaContext {
     };
 
     // Executing Lua code.
-    bool userdata_has_metafield(
-        const ExportableToLua& userdata, const char* key) const;
     bool find_method(int index, const char* function_name);
     bool find_method(const char* function_name);
     void print_stack(lua_State* l);
@@ -1124,7 +1143,9 @@ class LuaContext {
     static void push_game(lua_State* l, Savegame& game);
     static void push_map(lua_State* l, Map& map);
     static void push_entity(lua_State* l, Entity& entity);
-    static void push_entity_iterator(lua_State* l, const EntityVector& entities);
+    static void push_entity_iterator(lua_State* l, EntityVector&& entities);
+    EntityVector get_unused_entity_vector();
+    void set_entity_vector_unused(EntityVector&& entities);
     static void push_named_sprite_iterator(
         lua_State* l,
         const std::vector<Entity::NamedSprite>& sprites
@@ -1195,6 +1216,9 @@ class LuaContext {
     static std::shared_ptr<PixelMovement> check_pixel_movement(lua_State* l, int index);
     static bool is_game(lua_State* l, int index);
     static std::shared_ptr<Savegame> check_game(lua_State* l, int index);
+    static SavegameKey check_savegame_key(lua_State* l, int index);
+    static bool find_savegame_key(lua_State* l, int index, SavegameKey& key);
+    static void cache_savegame_key(lua_State* l, int index, const SavegameKey& key);
     static bool is_map(lua_State* l, int index);
     static std::shared_ptr<Map> check_map(lua_State* l, int index);
     static bool is_entity(lua_State* l, int index);
@@ -1272,6 +1296,8 @@ class LuaContext {
     void on_opening_transition_finished(Destination* destination);
     void on_obtaining_treasure(const Treasure& treasure);
     void on_obtained_treasure(const Treasure& treasure);
+    void on_snapshot();
+    void on_restore_snapshot();
     void on_state_changed(const std::string& state_name);
     bool on_taking_damage(int damage);
     void on_activating();
@@ -1389,6 +1415,17 @@ class LuaContext {
                                         * userdata with our __newindex. This is
                                         * only for performance, to avoid Lua
                                         * lookups for callbacks like on_update. */
+    uint64_t userdata_fields_revision; /**< Incremented whenever a string key
+                                        * of userdata_fields is added or removed. */
+    std::vector<std::shared_ptr<Movement>>
+        movements_on_points_to_update; /**< Movements applied to x,y points,
+                                        * collected before updating them. */
+    uint64_t movements_on_points_stopped;
+                                       /**< Number of times a movement stopped
+                                        * moving an x,y point. */
+    std::vector<EntityVector>
+        entity_vectors_unused;         /**< Empty lists left by finished entity
+                                        * iterators, kept to reuse their memory. */
     std::set<std::string>
         warning_deprecated_functions;  /**< Names of deprecated functions of
                                         * the API for which a warning was emitted. */
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SOLARUS_LUA_DATA_CACHE_H
+#define SOLARUS_LUA_DATA_CACHE_H
+
+#include "solarus/core/Common.h"
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace Solarus {
+
+/**
+ * \brief Cache of compiled Lua data files.
+ *
+ * Parsing big data files like maps, tilesets and sprites is the slow part
+ * of loading them. At startup, worker threads compile the quest data files
+ * in advance, each with its own Lua state, and this cache keeps the
+ * compiled chunks in memory until the files are loaded.
+ * The memory kept for files not loaded yet is bounded: past the limit,
+ * the remaining files are only compiled when loaded.
+ *
+ * Chunks are only used if the file content is exactly the one compiled,
+ * so modified data files are never loaded from a stale chunk.
+ * Compiled chunks are never written to or read from disk: Lua does not
+ * verify them, so loading one from a writable directory would be unsafe.
+ */
+namespace LuaDataCache {
+
+SOLARUS_API void initialize();
+SOLARUS_API void quit();
+
+SOLARUS_API void preparse(const std::vector<std::string>& file_names);
+SOLARUS_API size_t get_retained_size();
+SOLARUS_API int load_buffer(
+    lua_State* l,
+    const std::string& buffer,
+    const std::string& file_name
+);
+
+}
+
+}
+
+#endif
+
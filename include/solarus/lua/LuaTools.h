@@ -24,6 +24,7 @@
 #include "solarus/lua/LuaException.h"
 #include <map>
 #include <string>
+#include <vector>
 #include <lua.hpp>
 
 namespace Solarus {
@@ -58,6 +59,12 @@ bool do_string(
     const std::string& code,
     const std::string& chunk_name
 );
+bool do_string(
+    lua_State* l,
+    const std::string& code,
+    const std::string& chunk_name,
+    std::vector<std::string>& results
+);
 
 // Error handling.
 template<typename Callable>
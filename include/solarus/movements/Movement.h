@@ -23,6 +23,7 @@
 #include "solarus/lua/ScopedLuaRef.h"
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Solarus {
 
@@ -87,6 +88,16 @@ class SOLARUS_API Movement: public ExportableToLua {
     bool are_obstacles_ignored() const;
     void set_ignore_obstacles(bool ignore_obstacles);
     void restore_default_ignore_obstacles();
+    bool is_swept() const;
+    void set_swept(bool swept);
+
+    // batched updates
+    bool is_batchable() const;
+    void set_batchable(bool batchable);
+    void start_batched_update();
+    bool finish_batched_update();
+    bool is_updated_in_batch() const;
+    void set_updated_in_batch(bool updated_in_batch);
 
     // displaying moving objects
     virtual int get_displayed_direction4() const;
@@ -109,6 +120,12 @@ class SOLARUS_API Movement: public ExportableToLua {
 
     // obstacles (only when the movement is applied to an entity)
     void set_default_ignore_obstacles(bool ignore_obstacles);
+    size_t get_num_free_offsets(const std::vector<Point>& offsets) const;
+
+    // swept steps
+    uint64_t get_num_changes() const;
+    void increment_num_changes();
+    bool can_continue_free_steps(const Point& expected_xy, uint64_t expected_num_changes) const;
 
   private:
 
@@ -132,6 +149,17 @@ class SOLARUS_API Movement: public ExportableToLua {
 
     bool default_ignore_obstacles;               /**< Indicates that this movement normally ignores obstacles. */
     bool current_ignore_obstacles;               /**< Indicates that this movement currently ignores obstacles. */
+    bool swept;                                  /**< Whether subclasses that support it should test obstacles
+                                                  * along the whole way of an update at once. */
+    uint64_t num_changes;                        /**< Incremented whenever the speed, direction or path of the
+                                                  * movement changes, to detect changes made by callbacks. */
+    bool batchable;                              /**< Whether this movement may be updated in a batch
+                                                  * before its entity. */
+    bool updated_in_batch;                       /**< Whether the entity should skip the next update
+                                                  * because a batch already did it. */
+    bool position_notifications_deferred;        /**< Whether position changes are only notified
+                                                  * at the end of the current batch. */
+    bool position_changed_in_batch;              /**< Whether the position changed during the current batch. */
 
     ScopedLuaRef finished_callback_ref;          /**< Lua ref to a function to call when this movement finishes. */
 
@@ -19,15 +19,16 @@
 
 #include "solarus/core/Common.h"
 #include "solarus/core/Point.h"
+#include "solarus/core/Rectangle.h"
 #include <list>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Solarus {
 
 class Map;
 class Entity;
-class Rectangle;
 
 /**
  * \brief Implementation of the A* algorithm to compute a path.
@@ -75,6 +76,7 @@ class SOLARUS_API PathFinding {
     };
 
     int get_square_index(const Point& location) const;
+    void collect_candidate_obstacles(const Point& target);
     bool is_node_transition_valid(const Node& node, int direction) const;
     void add_index_sorted(Node* node);
     std::string rebuild_path(const Node* final_node);
@@ -86,10 +88,17 @@ class SOLARUS_API PathFinding {
     Entity& source_entity;             /**< the entity to move */
     Entity& target_entity;             /**< the target point */
 
-    std::map<int, Node> closed_list;   /**< the closed list, indexed by the node locations on the map */
-    std::map<int, Node> open_list;     /**< the open list, indexed by the node locations on the map */
+    std::unordered_map<int, Node>
+        closed_list;                   /**< the closed list, indexed by the node locations on the map */
+    std::unordered_map<int, Node>
+        open_list;                     /**< the open list, indexed by the node locations on the map */
     std::list<int> open_list_indices;  /**< indices of the open list elements, sorted by priority */
 
+    Rectangle obstacles_area;          /**< area that the search can reach */
+    std::vector<std::vector<Entity*>>
+        obstacle_cells;                /**< entities that may be obstacles for transitions
+                                        * starting in each cell of obstacles_area */
+
 };
 
 }
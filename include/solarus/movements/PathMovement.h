@@ -68,6 +68,8 @@ class SOLARUS_API PathMovement: public PixelMovement {
     int get_total_distance_covered() const;
     virtual int get_displayed_direction4() const override;
 
+    int fast_forward(int num_moves);
+
     static std::string create_random_path();
 
     virtual const std::string& get_lua_type_name() const override;
@@ -79,6 +81,7 @@ class SOLARUS_API PathMovement: public PixelMovement {
   private:
 
     static uint32_t speed_to_delay(int speed, int direction);
+    static const std::shared_ptr<const std::list<Point>>& get_elementary_move(int direction);
 
     void start_next_elementary_move();
     bool is_current_elementary_move_finished() const;
@@ -89,7 +92,7 @@ class SOLARUS_API PathMovement: public PixelMovement {
 
     std::string initial_path;          /**< the path: each character is a direction ('0' to '7')
                                         * and corresponds to a trajectory of 8 pixels (performed by PixelMovement) */
-    std::string remaining_path;        /**< the remaining part of the path */
+    size_t next_direction_index;       /**< index in the path of the next trajectory to do */
     int current_direction;             /**< current element in the path (0 to 7) */
     int total_distance_covered;        /**< total number of pixels covered (each element of the path counts for 8) */
     bool stopped_by_obstacle;          /**< true if the movement was stopped by an obstacle */
@@ -102,9 +105,6 @@ class SOLARUS_API PathMovement: public PixelMovement {
     bool snapping;                     /**< indicates that the entity is currently being aligned to the grid */
     uint32_t stop_snapping_date;       /**< date when we stop trying to snap the entity if it is unsuccessful */
 
-    static const std::string
-        elementary_moves[];            /**< 8 pixel trajectory (in the PixelMovement sense) for each direction (0 to 7) */
-
 };
 
 }
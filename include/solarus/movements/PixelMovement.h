@@ -22,6 +22,7 @@
 #include "solarus/movements/Movement.h"
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <string>
 
 namespace Solarus {
@@ -39,6 +40,7 @@ class SOLARUS_API PixelMovement: public Movement {
     // properties
     const std::list<Point>& get_trajectory() const;
     void set_trajectory(const std::list<Point>& trajectory);
+    void set_trajectory(const std::shared_ptr<const std::list<Point>>& trajectory);
     void set_trajectory(const std::string &trajectory_string);
     uint32_t get_delay() const;
     void set_delay(uint32_t delay);
@@ -49,6 +51,7 @@ class SOLARUS_API PixelMovement: public Movement {
     virtual bool is_started() const override;
     virtual bool is_finished() const override;
     int get_length() const;
+    int get_nb_steps_done() const;
 
     virtual void update() override;
     virtual void set_suspended(bool suspended) override;
@@ -62,12 +65,15 @@ class SOLARUS_API PixelMovement: public Movement {
   private:
 
     void make_next_step();
+    void make_free_steps();
     void restart();
 
     // movement properties
 
-    std::list<Point> trajectory;       /**< The trajectory. Each element of the
-                                        * represents a move in pixels. */
+    std::shared_ptr<const std::list<Point>>
+        trajectory;                    /**< The trajectory. Each element of the
+                                        * represents a move in pixels.
+                                        * It may be shared with other movements. */
     std::string trajectory_string;     /**< String representation of the trajectory, like "dx1 dy1  dx2 dy2  dx3 dy3 ..." */
     uint32_t next_move_date;           /**< Date of the next move */
     uint32_t delay;                    /**< Delay in milliseconds between two translations. */
@@ -75,7 +81,7 @@ class SOLARUS_API PixelMovement: public Movement {
 
     // current state
 
-    std::list<Point>::iterator
+    std::list<Point>::const_iterator
         trajectory_iterator;           /**< Current element of the trajectory. */
     int nb_steps_done;                 /**< Number of steps already done in the trajectory */
     bool finished;                     /**< Indicates whether the object has reached the end of the trajectory
@@ -74,8 +74,13 @@ class StraightMovement: public Movement {
 
     void update_non_smooth_xy();
 
+    void update_swept_xy();
+
   private:
 
+    void update_x_speed(double x_speed);
+    void update_y_speed(double y_speed);
+
     // speed vector
     double angle;                /**< angle between the speed vector and the horizontal axis in radians */
     double x_speed;              /**< X speed of the object to move in pixels per second.
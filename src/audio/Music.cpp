@@ -557,10 +557,8 @@ bool Music::start() {
 
     case OGG:
 
-      sound_buffer = QuestFiles::data_file_read(file_name);
-
-      // Give the OGG data to the OGG decoder.
-      success = ogg_decoder->load(std::move(sound_buffer), this->loop);
+      // Stream the OGG data from the file rather than loading it all.
+      success = ogg_decoder->load(QuestFiles::data_file_open_rw(file_name), this->loop);
       if (success) {
         for (int i = 0; i < nb_buffers; i++) {
           decode_ogg(buffers[i], 16384);
@@ -18,6 +18,7 @@
 #include "solarus/core/QuestFiles.h"
 #include "solarus/audio/OggDecoder.h"
 #include <al.h>
+#include <SDL.h>
 #include <sstream>
 #include <vector>
 
@@ -27,12 +28,23 @@ namespace Solarus {
  * \brief Creates an Ogg decoder.
  */
 OggDecoder::OggDecoder():
-  ogg_file(),
   ogg_mem(),
+  ogg_stream(),
+  ogg_file(),
   ogg_info(nullptr),
   loop_start_pcm(-1),
   loop_end_pcm(-1) {
 
+  ogg_stream.rw = nullptr;
+  ogg_stream.loop = false;
+}
+
+/**
+ * \brief Destroys the Ogg decoder.
+ */
+OggDecoder::~OggDecoder() {
+
+  unload();
 }
 
 /**
@@ -43,14 +55,51 @@ OggDecoder::OggDecoder():
  */
 bool OggDecoder::load(std::string&& ogg_data, bool loop) {
 
-  ogg_file = OggFileUniquePtr(new OggVorbis_File());
+  unload();
 
   ogg_mem.position = 0;
   ogg_mem.loop = loop;
-  ogg_mem.data = ogg_data;
+  ogg_mem.data = std::move(ogg_data);
   // Now, ogg_mem contains the encoded data.
 
-  int error = ov_open_callbacks(&ogg_mem, ogg_file.get(), nullptr, 0, Sound::ogg_callbacks);
+  return open(&ogg_mem, Sound::ogg_callbacks);
+}
+
+/**
+ * \brief Loads an OGG file that will be read progressively while decoding.
+ *
+ * Only the part of the file being decoded is kept in memory.
+ *
+ * \param ogg_stream The stream to read. The decoder takes ownership of it
+ * and closes it when unloading, even in case of failure.
+ * \param loop Whether the music should loop if reaching the end.
+ * \return \c true in case of success.
+ */
+bool OggDecoder::load(SDL_RWops* ogg_stream, bool loop) {
+
+  unload();
+
+  if (ogg_stream == nullptr) {
+    return false;
+  }
+
+  this->ogg_stream.rw = ogg_stream;
+  this->ogg_stream.loop = loop;
+
+  return open(&this->ogg_stream, Sound::ogg_stream_callbacks);
+}
+
+/**
+ * \brief Opens the OGG data source previously set and reads its header.
+ * \param datasource The data source to give to the vorbisfile lib.
+ * \param callbacks How the vorbisfile lib should read the data source.
+ * \return \c true in case of success.
+ */
+bool OggDecoder::open(void* datasource, const ov_callbacks& callbacks) {
+
+  ogg_file = OggFileUniquePtr(new OggVorbis_File());
+
+  int error = ov_open_callbacks(datasource, ogg_file.get(), nullptr, 0, callbacks);
 
   if (error != 0) {
     return false;
@@ -99,11 +148,15 @@ bool OggDecoder::load(std::string&& ogg_data, bool loop) {
 }
 
 /**
- * \brief Unloads the OGG data from memory.
+ * \brief Unloads the OGG data from memory and closes the stream if any.
  */
 void OggDecoder::unload() {
   ogg_file = nullptr;
   ogg_mem.data.clear();
+  if (ogg_stream.rw != nullptr) {
+    SDL_RWclose(ogg_stream.rw);
+    ogg_stream.rw = nullptr;
+  }
   ogg_info = nullptr;
   loop_start_pcm = -1;
   loop_end_pcm = -1;
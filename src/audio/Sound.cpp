@@ -25,7 +25,13 @@
 #include "solarus/core/String.h"
 #include "solarus/audio/Music.h"
 #include "solarus/audio/Sound.h"
+#include "solarus/audio/SoundPool.h"
+#include <SDL.h>
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace Solarus {
 
@@ -34,8 +40,51 @@ ALCcontext* Sound::context = nullptr;
 bool Sound::initialized = false;
 bool Sound::sounds_preloaded = false;
 float Sound::volume = 1.0;
-std::list<Sound*> Sound::current_sounds;
+std::vector<Sound::Voice> Sound::voices;
 std::map<std::string, Sound> Sound::all_sounds;
+size_t Sound::cache_size = 0;
+uint64_t Sound::next_play_order = 0;
+
+namespace {
+
+/**
+ * \brief Maximum number of sounds that can be played at the same time.
+ */
+constexpr int max_voices = 32;
+
+/**
+ * \brief Maximum total size of decoded sounds kept in memory.
+ */
+constexpr size_t max_cache_size = 64 * 1024 * 1024;
+
+/**
+ * \brief State of a sound decoded in background.
+ */
+enum class DecodingState {
+  PENDING,      /**< Waiting for the decoder thread. */
+  DECODING,     /**< The decoder thread is decoding it. */
+  DONE          /**< Decoded, or failed. */
+};
+
+/**
+ * \brief A sound decoded in background.
+ */
+struct Decoding {
+  DecodingState state;
+  bool success;                 /**< Whether decoding succeeded (when done). */
+  std::vector<char> samples;    /**< Decoded 16-bit stereo samples. */
+  ALsizei sample_rate;          /**< Sample rate of the decoded samples. */
+};
+
+std::map<std::string, Decoding> decodings_;          /**< Sounds decoded in background, by id. */
+std::deque<std::string> pending_decodings_;          /**< Sounds waiting for the decoder thread. */
+std::deque<std::string> finished_decodings_;         /**< Sounds decoded but not in an OpenAL buffer yet. */
+std::thread decoder_;
+std::mutex decoder_mutex_;                           /**< Protects the decoding lists. */
+std::condition_variable decoding_done_condition_;
+bool decoder_stopping_ = false;
+
+}  // Anonymous namespace.
 
 namespace {
 
@@ -123,6 +172,77 @@ long cb_tell(void* datasource) {
   return mem->position;
 }
 
+/**
+ * \brief Loads an encoded sound from a stream.
+ *
+ * This function respects the prototype specified by libvorbisfile.
+ *
+ * \param ptr pointer to a buffer to load
+ * \param size size
+ * \param nb_bytes number of bytes to load
+ * \param datasource source of the data to read
+ * \return number of bytes loaded
+ */
+size_t cb_stream_read(void* ptr, size_t /* size */, size_t nb_bytes, void* datasource) {
+
+  Sound::SoundFromStream* stream = static_cast<Sound::SoundFromStream*>(datasource);
+
+  size_t bytes_read = SDL_RWread(stream->rw, ptr, 1, nb_bytes);
+  if (bytes_read == 0 && nb_bytes > 0 && stream->loop) {
+    SDL_RWseek(stream->rw, 0, RW_SEEK_SET);
+    bytes_read = SDL_RWread(stream->rw, ptr, 1, nb_bytes);
+  }
+
+  return bytes_read;
+}
+
+/**
+ * \brief Seeks the sound stream to the specified offset.
+ *
+ * This function respects the prototype specified by libvorbisfile.
+ *
+ * \param datasource Source of the data to read.
+ * \param offset Where to seek.
+ * \param whence How to seek: SEEK_SET, SEEK_CUR or SEEK_END.
+ * \return 0 in case of success, -1 in case of error.
+ */
+int cb_stream_seek(void* datasource, ogg_int64_t offset, int whence) {
+
+  Sound::SoundFromStream* stream = static_cast<Sound::SoundFromStream*>(datasource);
+
+  int rw_whence = RW_SEEK_SET;
+  switch (whence) {
+
+  case SEEK_SET:
+    rw_whence = RW_SEEK_SET;
+    break;
+
+  case SEEK_CUR:
+    rw_whence = RW_SEEK_CUR;
+    break;
+
+  case SEEK_END:
+    rw_whence = RW_SEEK_END;
+    break;
+  }
+
+  return SDL_RWseek(stream->rw, offset, rw_whence) < 0 ? -1 : 0;
+}
+
+/**
+ * \brief Returns the current position in a sound stream.
+ *
+ * This function respects the prototype specified by libvorbisfile.
+ *
+ * \param datasource Source of the data to read.
+ * \return The current position.
+ */
+long cb_stream_tell(void* datasource) {
+
+  Sound::SoundFromStream* stream = static_cast<Sound::SoundFromStream*>(datasource);
+  return static_cast<long>(SDL_RWtell(stream->rw));
+}
+
 }  // Anonymous namespace.
 
 ov_callbacks Sound::ogg_callbacks = {
@@ -132,13 +252,12 @@ ov_callbacks Sound::ogg_callbacks = {
     cb_tell,
 };
 
-/**
- * \brief Creates a new Ogg Vorbis sound.
- */
-Sound::Sound():
-  Sound(std::string("")) {
-
-}
+ov_callbacks Sound::ogg_stream_callbacks = {
+    cb_stream_read,
+    cb_stream_seek,
+    nullptr,  // close: the owner of the stream closes it
+    cb_stream_tell,
+};
 
 /**
  * \brief Creates a new Ogg Vorbis sound.
@@ -147,7 +266,9 @@ Sound::Sound():
  */
 Sound::Sound(const std::string& sound_id):
   id(sound_id),
-  buffer(AL_NONE) {
+  buffer(AL_NONE),
+  buffer_size(0),
+  last_play_order(0) {
 
 }
 
@@ -156,16 +277,8 @@ Sound::Sound(const std::string& sound_id):
  */
 Sound::~Sound() {
 
-  if (is_initialized() && buffer != AL_NONE) {
-
-    // stop the sources where this buffer is attached
-    for (ALuint source: sources) {
-      alSourceStop(source);
-      alSourcei(source, AL_BUFFER, 0);
-      alDeleteSources(1, &source);
-    }
-    alDeleteBuffers(1, &buffer);
-    current_sounds.remove(this);
+  if (is_initialized()) {
+    unload();
   }
 }
 
@@ -210,6 +323,24 @@ void Sound::initialize(const Arguments& args) {
 
   alGenBuffers(0, nullptr);  // Necessary on some systems to avoid errors with the first sound loaded.
 
+  // Create the voices, as many as the device allows up to max_voices.
+  // Keep one source of the device for the music, which creates it later.
+  for (int i = 0; i < max_voices + 1; ++i) {
+    ALuint source = AL_NONE;
+    alGenSources(1, &source);
+    if (alGetError() != AL_NO_ERROR) {
+      break;
+    }
+    voices.push_back({ source, nullptr, 0, 0 });
+  }
+  if (!voices.empty()) {
+    alDeleteSources(1, &voices.back().source);
+    voices.pop_back();
+  }
+  if (voices.size() < static_cast<size_t>(max_voices)) {
+    Logger::info("Sound voices: " + String::to_string(voices.size()));
+  }
+
   initialized = true;
   set_volume(100);
 
@@ -230,7 +361,14 @@ void Sound::quit() {
     Music::quit();
 
     // clear the sounds
+    stop_decoder();
     all_sounds.clear();
+    for (Voice& voice: voices) {
+      stop_voice(voice);
+      alDeleteSources(1, &voice.source);
+    }
+    voices.clear();
+    cache_size = 0;
 
     // uninitialize OpenAL
 
@@ -254,7 +392,10 @@ bool Sound::is_initialized() {
 }
 
 /**
- * \brief Loads and decodes all sounds listed in the game database.
+ * \brief Starts decoding all sounds listed in the game database.
+ *
+ * Sounds are decoded in background.
+ * A sound played before being decoded is decoded immediately.
  */
 void Sound::load_all() {
 
@@ -262,12 +403,23 @@ void Sound::load_all() {
 
     const std::map<std::string, std::string>& sound_elements =
         CurrentQuest::get_resources(ResourceType::SOUND);
-    for (const auto& kvp: sound_elements) {
-      const std::string& sound_id = kvp.first;
+    {
+      std::lock_guard<std::mutex> lock(decoder_mutex_);
+      for (const auto& kvp: sound_elements) {
+        const std::string& sound_id = kvp.first;
+
+        const Sound& sound = all_sounds.emplace(sound_id, sound_id).first->second;
+        if (sound.buffer == AL_NONE &&
+            decodings_.emplace(sound_id, Decoding{ DecodingState::PENDING, false, {}, 0 }).second) {
+          pending_decodings_.push_back(sound_id);
+        }
+      }
+    }
 
-      all_sounds[sound_id] = Sound(sound_id);
-      all_sounds[sound_id].load();
+    if (decoder_.joinable()) {
+      decoder_.join();
     }
+    decoder_ = std::thread(run_decoder);
 
     sounds_preloaded = true;
   }
@@ -288,14 +440,17 @@ bool Sound::exists(const std::string& sound_id) {
 /**
  * \brief Starts playing the specified sound.
  * \param sound_id id of the sound to play
+ * \param priority Priority of the sound. When all voices are busy, the sound
+ * replaces a sound of lower or equal priority, if any.
  */
-void Sound::play(const std::string& sound_id) {
+void Sound::play(const std::string& sound_id, int priority) {
 
-  if (all_sounds.find(sound_id) == all_sounds.end()) {
-    all_sounds[sound_id] = Sound(sound_id);
+  auto it = all_sounds.find(sound_id);
+  if (it == all_sounds.end()) {
+    it = all_sounds.emplace(sound_id, sound_id).first;
   }
 
-  all_sounds[sound_id].start();
+  it->second.start(priority);
 }
 
 /**
@@ -318,6 +473,35 @@ void Sound::set_volume(int volume) {
   Logger::info(std::string("Sound volume: ") + String::to_string(get_volume()));
 }
 
+/**
+ * \brief Returns the number of sounds that can be played at the same time.
+ * \return The number of voices.
+ */
+int Sound::get_num_voices() {
+
+  return static_cast<int>(voices.size());
+}
+
+/**
+ * \brief Returns the number of sounds currently playing.
+ * \return The number of voices in use.
+ */
+int Sound::get_num_voices_playing() {
+
+  int num_playing = 0;
+  for (const Voice& voice: voices) {
+    if (voice.sound == nullptr) {
+      continue;
+    }
+    ALint status;
+    alGetSourcei(voice.source, AL_SOURCE_STATE, &status);
+    if (status == AL_PLAYING) {
+      ++num_playing;
+    }
+  }
+  return num_playing;
+}
+
 /**
  * \brief Updates the audio (music and sound) system.
  *
@@ -325,48 +509,43 @@ void Sound::set_volume(int volume) {
  */
 void Sound::update() {
 
-  // update the playing sounds
-  std::list<Sound*> sounds_to_remove;
-  for (Sound* sound: current_sounds) {
-    if (!sound->update_playing()) {
-      sounds_to_remove.push_back(sound);
+  // Release the voices whose sound is finished.
+  for (Voice& voice: voices) {
+    if (voice.sound == nullptr) {
+      continue;
+    }
+    ALint status;
+    alGetSourcei(voice.source, AL_SOURCE_STATE, &status);
+    if (status != AL_PLAYING) {
+      stop_voice(voice);
     }
   }
 
-  for (Sound* sound: sounds_to_remove) {
-    current_sounds.remove(sound);
-  }
+  // Get the sounds decoded in background.
+  create_decoded_buffers();
 
   // also update the music
   Music::update();
 }
 
 /**
- * \brief Updates this sound when it is playing.
- * \return true if the sound is still playing, false if it is finished.
+ * \brief Returns the data file of a sound.
+ * \param sound_id Id of a sound.
+ * \return The file name, relative to the data directory.
  */
-bool Sound::update_playing() {
+std::string Sound::get_file_name(const std::string& sound_id) {
 
-  // See if this sound is still playing.
-  if (sources.empty()) {
-    return false;
-  }
-
-  ALuint source = *sources.begin();
-  ALint status;
-  alGetSourcei(source, AL_SOURCE_STATE, &status);
-
-  if (status != AL_PLAYING) {
-    sources.pop_front();
-    alSourcei(source, AL_BUFFER, 0);
-    alDeleteSources(1, &source);
+  std::string file_name = std::string("sounds/" + sound_id);
+  if (sound_id.find(".") == std::string::npos) {
+    file_name += ".ogg";
   }
-
-  return !sources.empty();
+  return file_name;
 }
 
 /**
  * \brief Loads and decodes the sound into memory.
+ *
+ * If the sound is being decoded in background, waits for the result.
  */
 void Sound::load() {
 
@@ -374,102 +553,426 @@ void Sound::load() {
     Debug::error("Previous audio error not cleaned");
   }
 
-  std::string file_name = std::string("sounds/" + id);
-  if (id.find(".") == std::string::npos) {
-    file_name += ".ogg";
+  std::vector<char> samples;
+  ALsizei sample_rate = 0;
+  if (!take_decoded_samples(id, samples, sample_rate) &&
+      !decode_file(get_file_name(id), samples, sample_rate, true)) {
+    return;
   }
 
   // Create an OpenAL buffer with the sound decoded by the library.
-  buffer = decode_file(file_name);
+  create_buffer(samples, sample_rate);
 
-  // buffer is now AL_NONE if there was an error.
+  // buffer is still AL_NONE if there was an error.
+}
+
+/**
+ * \brief Creates the OpenAL buffer of this sound.
+ * \param samples Decoded 16-bit stereo samples.
+ * \param sample_rate Sample rate of the samples.
+ */
+void Sound::create_buffer(const std::vector<char>& samples, ALsizei sample_rate) {
+
+  ALuint new_buffer = AL_NONE;
+  alGenBuffers(1, &new_buffer);
+  if (alGetError() != AL_NO_ERROR) {
+    Debug::error("Failed to generate audio buffer");
+    return;
+  }
+
+  alBufferData(new_buffer,
+      AL_FORMAT_STEREO16,
+      reinterpret_cast<const ALshort*>(samples.data()),
+      ALsizei(samples.size()),
+      sample_rate);
+  ALenum error = alGetError();
+  if (error != AL_NO_ERROR) {
+    std::ostringstream oss;
+    oss << "Cannot copy the sound samples of '"
+        << get_file_name(id) << "' into buffer " << new_buffer
+        << ": error " << error;
+    Debug::error(oss.str());
+    alDeleteBuffers(1, &new_buffer);
+    return;
+  }
+
+  buffer = new_buffer;
+  buffer_size = samples.size();
+  cache_size += buffer_size;
+}
+
+/**
+ * \brief Stops this sound and frees its decoded data.
+ */
+void Sound::unload() {
+
+  if (buffer == AL_NONE) {
+    return;
+  }
+
+  for (Voice& voice: voices) {
+    if (voice.sound == this) {
+      stop_voice(voice);
+    }
+  }
+
+  alDeleteBuffers(1, &buffer);
+  buffer = AL_NONE;
+  cache_size -= buffer_size;
+  buffer_size = 0;
+}
+
+/**
+ * \brief Returns whether a voice is currently attached to this sound.
+ * \return \c true if this sound is playing.
+ */
+bool Sound::is_used_by_voice() const {
+
+  for (const Voice& voice: voices) {
+    if (voice.sound == this) {
+      return true;
+    }
+  }
+  return false;
 }
 
 /**
  * \brief Plays the sound.
- * \return true if the sound was loaded successfully, false otherwise
+ * \param priority Priority of the sound. When all voices are busy, the sound
+ * replaces a sound of lower or equal priority, if any.
+ * \return true if the sound was loaded and started successfully, false otherwise
  */
-bool Sound::start() {
+bool Sound::start(int priority) {
 
-  bool success = false;
+  if (!is_initialized()) {
+    return false;
+  }
 
-  if (is_initialized()) {
+  if (buffer == AL_NONE) { // first time or unloaded: load and decode the file
+    load();
+    if (buffer == AL_NONE) {
+      return false;
+    }
+  }
+
+  last_play_order = next_play_order++;
+  shrink_cache(this);
+
+  Voice* voice = get_voice(priority);
+  if (voice == nullptr) {
+    // All voices are playing more important sounds.
+    return false;
+  }
+
+  alSourcei(voice->source, AL_BUFFER, buffer);
+  alSourcef(voice->source, AL_GAIN, volume);
+
+  // play the sound
+  int error = alGetError();
+  if (error != AL_NO_ERROR) {
+    std::ostringstream oss;
+    oss << "Cannot attach buffer " << buffer
+        << " to the source to play sound '" << id << "': error " << error;
+    Debug::error(oss.str());
+    alSourcei(voice->source, AL_BUFFER, 0);
+    return false;
+  }
+
+  voice->sound = this;
+  voice->priority = priority;
+  voice->play_order = last_play_order;
+  alSourcePlay(voice->source);
+  error = alGetError();
+  if (error != AL_NO_ERROR) {
+    std::ostringstream oss;
+    oss << "Cannot play sound '" << id << "': error " << error;
+    Debug::error(oss.str());
+    return false;
+  }
+  return true;
+}
 
-    if (buffer == AL_NONE) { // first time: load and decode the file
-      load();
+/**
+ * \brief Finds a voice to play a new sound.
+ *
+ * If all voices are busy, the oldest sound of the lowest priority is stopped
+ * to make room, provided that its priority is not higher than the new one.
+ *
+ * \param priority Priority of the new sound.
+ * \return A free voice, or nullptr if all voices play more important sounds.
+ */
+Sound::Voice* Sound::get_voice(int priority) {
+
+  std::vector<SoundPool::VoiceState> voice_states;
+  voice_states.reserve(voices.size());
+  for (Voice& voice: voices) {
+    if (voice.sound != nullptr) {
+      ALint status;
+      alGetSourcei(voice.source, AL_SOURCE_STATE, &status);
+      if (status != AL_PLAYING) {
+        stop_voice(voice);
+      }
     }
+    voice_states.push_back({ voice.sound == nullptr, voice.priority, voice.play_order });
+  }
+
+  const int index = SoundPool::choose_voice(voice_states, priority);
+  if (index == -1) {
+    return nullptr;
+  }
+
+  Voice& voice = voices[index];
+  if (voice.sound != nullptr) {
+    stop_voice(voice);
+  }
+  return &voice;
+}
+
+/**
+ * \brief Stops the sound of a voice and makes the voice free.
+ * \param voice The voice to stop.
+ */
+void Sound::stop_voice(Voice& voice) {
+
+  alSourceStop(voice.source);
+  alSourcei(voice.source, AL_BUFFER, 0);
+  voice.sound = nullptr;
+}
+
+/**
+ * \brief Unloads the least recently played sounds while decoded sounds take
+ * too much memory.
+ *
+ * Sounds that are playing are never unloaded.
+ *
+ * \param sound_to_keep A sound not to unload, or nullptr.
+ */
+void Sound::shrink_cache(const Sound* sound_to_keep) {
+
+  if (cache_size <= max_cache_size) {
+    return;
+  }
+
+  std::vector<Sound*> loaded_sounds;
+  std::vector<SoundPool::CachedSound> cached_sounds;
+  for (auto& kvp: all_sounds) {
+    Sound& sound = kvp.second;
+    if (sound.buffer == AL_NONE) {
+      continue;
+    }
+    loaded_sounds.push_back(&sound);
+    cached_sounds.push_back({
+        sound.buffer_size,
+        sound.last_play_order,
+        &sound != sound_to_keep && !sound.is_used_by_voice()
+    });
+  }
+
+  for (size_t index: SoundPool::choose_sounds_to_unload(cached_sounds, max_cache_size)) {
+    loaded_sounds[index]->unload();
+  }
+}
 
-    if (buffer != AL_NONE) {
-
-      // create a source
-      ALuint source;
-      alGenSources(1, &source);
-      alSourcei(source, AL_BUFFER, buffer);
-      alSourcef(source, AL_GAIN, volume);
-
-      // play the sound
-      int error = alGetError();
-      if (error != AL_NO_ERROR) {
-        std::ostringstream oss;
-        oss << "Cannot attach buffer " << buffer
-            << " to the source to play sound '" << id << "': error " << error;
-        Debug::error(oss.str());
-        alDeleteSources(1, &source);
+/**
+ * \brief Function executed by the decoder thread.
+ *
+ * Decodes pending sounds until there are none left.
+ * No OpenAL function is called here: buffers are created later by the main
+ * thread.
+ */
+void Sound::run_decoder() {
+
+  while (true) {
+
+    std::string sound_id;
+    {
+      std::lock_guard<std::mutex> lock(decoder_mutex_);
+      if (decoder_stopping_ || pending_decodings_.empty()) {
+        break;
       }
-      else {
-        sources.push_back(source);
-        current_sounds.remove(this); // to avoid duplicates
-        current_sounds.push_back(this);
-        alSourcePlay(source);
-        error = alGetError();
-        if (error != AL_NO_ERROR) {
-          std::ostringstream oss;
-          oss << "Cannot play sound '" << id << "': error " << error;
-          Debug::error(oss.str());
-        }
-        else {
-          success = true;
-        }
+      sound_id = pending_decodings_.front();
+      pending_decodings_.pop_front();
+
+      auto it = decodings_.find(sound_id);
+      if (it == decodings_.end() || it->second.state != DecodingState::PENDING) {
+        // The main thread already took care of it.
+        continue;
       }
+      it->second.state = DecodingState::DECODING;
     }
+
+    // Errors are not reported here:
+    // they will be when the sound is played.
+    std::vector<char> samples;
+    ALsizei sample_rate = 0;
+    const bool success = decode_file(get_file_name(sound_id), samples, sample_rate, false);
+
+    {
+      std::lock_guard<std::mutex> lock(decoder_mutex_);
+      Decoding& decoding = decodings_[sound_id];
+      decoding.state = DecodingState::DONE;
+      decoding.success = success;
+      decoding.samples = std::move(samples);
+      decoding.sample_rate = sample_rate;
+      finished_decodings_.push_back(sound_id);
+    }
+    decoding_done_condition_.notify_all();
+  }
+}
+
+/**
+ * \brief Stops the decoder thread and forgets sounds decoded in background.
+ */
+void Sound::stop_decoder() {
+
+  {
+    std::lock_guard<std::mutex> lock(decoder_mutex_);
+    decoder_stopping_ = true;
   }
+  if (decoder_.joinable()) {
+    decoder_.join();
+  }
+
+  std::lock_guard<std::mutex> lock(decoder_mutex_);
+  decodings_.clear();
+  pending_decodings_.clear();
+  finished_decodings_.clear();
+  decoder_stopping_ = false;
+}
+
+/**
+ * \brief Gets the samples of a sound decoded in background.
+ *
+ * If the sound is being decoded, waits for the decoder thread.
+ * If it is still waiting for the decoder thread, it is removed from the
+ * pending sounds so that the caller can decode it now.
+ *
+ * \param sound_id Id of the sound.
+ * \param[out] samples The decoded samples.
+ * \param[out] sample_rate The sample rate.
+ * \return \c true if decoded samples were available.
+ */
+bool Sound::take_decoded_samples(
+    const std::string& sound_id,
+    std::vector<char>& samples,
+    ALsizei& sample_rate) {
+
+  std::unique_lock<std::mutex> lock(decoder_mutex_);
+  auto it = decodings_.find(sound_id);
+  if (it == decodings_.end()) {
+    return false;
+  }
+
+  if (it->second.state == DecodingState::PENDING) {
+    decodings_.erase(it);
+    return false;
+  }
+
+  decoding_done_condition_.wait(lock, [&]() {
+    return it->second.state == DecodingState::DONE;
+  });
+
+  const bool success = it->second.success;
+  samples = std::move(it->second.samples);
+  sample_rate = it->second.sample_rate;
+  decodings_.erase(it);
   return success;
 }
 
 /**
- * \brief Loads the specified sound file and decodes its content into an OpenAL buffer.
- * \param file_name name of the file to open
- * \return the buffer created, or AL_NONE if the sound could not be loaded
+ * \brief Creates OpenAL buffers for the sounds decoded in background.
+ *
+ * Sounds that would exceed the cache size are dropped:
+ * they will be decoded again when played.
  */
-ALuint Sound::decode_file(const std::string& file_name) {
+void Sound::create_decoded_buffers() {
 
-  ALuint buffer = AL_NONE;
+  while (true) {
+
+    std::string sound_id;
+    Decoding decoding;
+    {
+      std::lock_guard<std::mutex> lock(decoder_mutex_);
+      if (finished_decodings_.empty()) {
+        return;
+      }
+      sound_id = finished_decodings_.front();
+      finished_decodings_.pop_front();
+
+      auto it = decodings_.find(sound_id);
+      if (it == decodings_.end() || it->second.state != DecodingState::DONE) {
+        // Already taken by the main thread.
+        continue;
+      }
+      decoding = std::move(it->second);
+      decodings_.erase(it);
+    }
+
+    if (!decoding.success ||
+        cache_size + decoding.samples.size() > max_cache_size) {
+      continue;
+    }
+
+    const auto& it = all_sounds.find(sound_id);
+    if (it == all_sounds.end() || it->second.buffer != AL_NONE) {
+      continue;
+    }
+    it->second.create_buffer(decoding.samples, decoding.sample_rate);
+  }
+}
+
+/**
+ * \brief Loads the specified sound file and decodes its content.
+ *
+ * This function does not use OpenAL and can be called from any thread.
+ *
+ * \param[in] file_name Name of the file to open.
+ * \param[out] samples The decoded 16-bit stereo samples.
+ * \param[out] sample_rate Sample rate of the samples.
+ * \param[in] report_errors Whether to report errors.
+ * \return \c true in case of success.
+ */
+bool Sound::decode_file(
+    const std::string& file_name,
+    std::vector<char>& samples,
+    ALsizei& sample_rate,
+    bool report_errors) {
 
   if (!QuestFiles::data_file_exists(file_name)) {
-    Debug::error(std::string("Cannot find sound file '") + file_name + "'");
-    return AL_NONE;
+    if (report_errors) {
+      Debug::error(std::string("Cannot find sound file '") + file_name + "'");
+    }
+    return false;
   }
 
-  // load the sound file
-  SoundFromMemory mem;
-  mem.loop = false;
-  mem.position = 0;
-  mem.data = QuestFiles::data_file_read(file_name);
+  // Read the sound file progressively.
+  SoundFromStream stream;
+  stream.rw = QuestFiles::data_file_open_rw(file_name);
+  stream.loop = false;
+  if (stream.rw == nullptr) {
+    if (report_errors) {
+      Debug::error(std::string("Cannot open sound file '") + file_name + "'");
+    }
+    return false;
+  }
 
+  bool success = false;
   OggVorbis_File file;
-  int error = ov_open_callbacks(&mem, &file, nullptr, 0, ogg_callbacks);
+  int error = ov_open_callbacks(&stream, &file, nullptr, 0, ogg_stream_callbacks);
 
   if (error) {
-    std::ostringstream oss;
-    oss << "Cannot load sound file '" << file_name
-        << "' from memory: error " << error;
-    Debug::error(oss.str());
+    if (report_errors) {
+      std::ostringstream oss;
+      oss << "Cannot load sound file '" << file_name
+          << "': error " << error;
+      Debug::error(oss.str());
+    }
   }
   else {
 
     // read the encoded sound properties
     vorbis_info* info = ov_info(&file, -1);
-    ALsizei sample_rate = ALsizei(info->rate);
+    sample_rate = ALsizei(info->rate);
 
     ALenum format = AL_NONE;
     if (info->channels == 1) {
@@ -480,27 +983,29 @@ ALuint Sound::decode_file(const std::string& file_name) {
     }
 
     if (format == AL_NONE) {
-      Debug::error(std::string("Invalid audio format for sound file '")
-          + file_name + "'");
+      if (report_errors) {
+        Debug::error(std::string("Invalid audio format for sound file '")
+            + file_name + "'");
+      }
     }
     else {
       // decode the sound with vorbisfile
-      std::vector<char> samples;
+      success = true;
       int bitstream;
       long bytes_read;
-      long total_bytes_read = 0;
       const int buffer_size = 16384;
       char samples_buffer[buffer_size];
       do {
         bytes_read = ov_read(&file, samples_buffer, buffer_size, 0, 2, 1, &bitstream);
         if (bytes_read < 0) {
-          std::ostringstream oss;
-          oss << "Error while decoding ogg chunk in sound file '"
-              << file_name << "': " << bytes_read;
-          Debug::error(oss.str());
+          if (report_errors) {
+            std::ostringstream oss;
+            oss << "Error while decoding ogg chunk in sound file '"
+                << file_name << "': " << bytes_read;
+            Debug::error(oss.str());
+          }
         }
         else {
-          total_bytes_read += bytes_read;
           if (format == AL_FORMAT_STEREO16) {
             samples.insert(samples.end(), samples_buffer, samples_buffer + bytes_read);
           }
@@ -512,39 +1017,17 @@ ALuint Sound::decode_file(const std::string& file_name) {
               samples.insert(samples.end(), samples_buffer + i, samples_buffer + i + 2);
               samples.insert(samples.end(), samples_buffer + i, samples_buffer + i + 2);
             }
-            total_bytes_read += bytes_read;
           }
         }
       }
       while (bytes_read > 0);
-
-      // copy the samples into an OpenAL buffer
-      alGenBuffers(1, &buffer);
-      if (alGetError() != AL_NO_ERROR) {
-          Debug::error("Failed to generate audio buffer");
-      }
-      alBufferData(buffer,
-          AL_FORMAT_STEREO16,
-          reinterpret_cast<ALshort*>(samples.data()),
-          ALsizei(total_bytes_read),
-          sample_rate);
-      ALenum error = alGetError();
-      if (error != AL_NO_ERROR) {
-        std::ostringstream oss;
-        oss << "Cannot copy the sound samples of '"
-            << file_name << "' into buffer " << buffer
-            << ": error " << error;
-        Debug::error(oss.str());
-        buffer = AL_NONE;
-      }
     }
     ov_clear(&file);
   }
 
-  mem.data.clear();
+  SDL_RWclose(stream.rw);
 
-  return buffer;
+  return success;
 }
 
 }
-
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/audio/SoundPool.h"
+#include <algorithm>
+
+namespace Solarus {
+
+namespace SoundPool {
+
+/**
+ * \brief Chooses the voice to play a new sound.
+ *
+ * A free voice is used if any.
+ * Otherwise, the oldest sound of the lowest priority is replaced,
+ * provided that its priority is not higher than the new one.
+ *
+ * \param voices State of each voice.
+ * \param priority Priority of the new sound.
+ * \return Index of the voice to use, or -1 if all voices play more
+ * important sounds.
+ */
+int choose_voice(const std::vector<VoiceState>& voices, int priority) {
+
+  int stolen_index = -1;
+  for (size_t i = 0; i < voices.size(); ++i) {
+
+    const VoiceState& voice = voices[i];
+    if (voice.free) {
+      return static_cast<int>(i);
+    }
+
+    if (voice.priority > priority) {
+      continue;
+    }
+    if (stolen_index == -1) {
+      stolen_index = static_cast<int>(i);
+      continue;
+    }
+    const VoiceState& stolen_voice = voices[stolen_index];
+    if (voice.priority < stolen_voice.priority ||
+        (voice.priority == stolen_voice.priority && voice.play_order < stolen_voice.play_order)) {
+      stolen_index = static_cast<int>(i);
+    }
+  }
+  return stolen_index;
+}
+
+/**
+ * \brief Chooses the decoded sounds to unload so that they fit in the cache.
+ *
+ * The least recently played sounds are unloaded first.
+ * Sounds that cannot be unloaded are kept even if they don't fit.
+ *
+ * \param sounds The decoded sounds.
+ * \param max_cache_size Maximum total size of decoded sounds in bytes.
+ * \return Indexes of the sounds to unload.
+ */
+std::vector<size_t> choose_sounds_to_unload(
+    const std::vector<CachedSound>& sounds,
+    size_t max_cache_size
+) {
+  size_t cache_size = 0;
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < sounds.size(); ++i) {
+    cache_size += sounds[i].size;
+    if (sounds[i].can_unload) {
+      candidates.push_back(i);
+    }
+  }
+
+  std::vector<size_t> sounds_to_unload;
+  if (cache_size <= max_cache_size) {
+    return sounds_to_unload;
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [&sounds](size_t a, size_t b) {
+    return sounds[a].last_play_order < sounds[b].last_play_order;
+  });
+  for (size_t index : candidates) {
+    if (cache_size <= max_cache_size) {
+      break;
+    }
+    sounds_to_unload.push_back(index);
+    cache_size -= sounds[index].size;
+  }
+  return sounds_to_unload;
+}
+
+}
+
+}
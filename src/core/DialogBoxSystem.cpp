@@ -19,13 +19,13 @@
 #include "solarus/core/CurrentQuest.h"
 #include "solarus/core/Game.h"
 #include "solarus/core/Map.h"
+#include "solarus/core/String.h"
 #include "solarus/entities/Hero.h"
 #include "solarus/graphics/TextSurface.h"
 #include "solarus/graphics/Video.h"
 #include "solarus/lua/LuaContext.h"
 #include "solarus/lua/LuaTools.h"
 #include <lua.hpp>
-#include <sstream>
 
 namespace Solarus {
 
@@ -37,6 +37,8 @@ DialogBoxSystem::DialogBoxSystem(Game& game):
   game(game),
   callback_ref(),
   built_in(false),
+  lines(),
+  next_line_index(0),
   is_question(false),
   selected_first_answer(true) {
 
@@ -50,6 +52,27 @@ DialogBoxSystem::DialogBoxSystem(Game& game):
   }
 }
 
+/**
+ * \brief Splits the text of a dialog into the lines shown by the built-in
+ * dialog box.
+ * \param text The text of a dialog.
+ * \return Its lines, without the newline characters.
+ */
+std::vector<std::string> DialogBoxSystem::split_lines(const std::string& text) {
+
+  std::vector<std::string> lines;
+  size_t line_start = 0;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string::npos) {
+      line_end = text.size();
+    }
+    lines.emplace_back(text, line_start, line_end - line_start);
+    line_start = line_end + 1;
+  }
+  return lines;
+}
+
 /**
  * \brief Returns the game where this dialog box is displayed.
  * \return the current game
@@ -131,18 +154,13 @@ void DialogBoxSystem::open(
         info_ref.push();
         int price = LuaTools::check_int(l, -1);
         lua_pop(l, -1);
-        std::ostringstream oss;
-        oss << price;
-        text = text.replace(index, 2, oss.str());
+        text = text.replace(index, 2, String::to_string(price));
       }
     }
 
-    remaining_lines.clear();
-    std::istringstream iss(text);
-    std::string line;
-    while (std::getline(iss, line)) {
-      remaining_lines.push_back(line);
-    }
+    // Split the lines once: pages then only move an index.
+    lines = split_lines(text);
+    next_line_index = 0;
 
     // Determine the position.
     bool top = false;
@@ -197,7 +215,7 @@ void DialogBoxSystem::close(const ScopedLuaRef& status_ref) {
  * \return \c true if there are more lines.
  */
 bool DialogBoxSystem::has_more_lines() const {
-  return !remaining_lines.empty();
+  return next_line_index < lines.size();
 }
 
 /**
@@ -235,8 +253,8 @@ void DialogBoxSystem::show_more_lines() {
     line_surfaces[i]->set_text_color(Color::white);
 
     if (has_more_lines()) {
-      line_surfaces[i]->set_text(*remaining_lines.begin());
-      remaining_lines.pop_front();
+      line_surfaces[i]->set_text(lines[next_line_index]);
+      ++next_line_index;
     }
     else {
       line_surfaces[i]->set_text("");
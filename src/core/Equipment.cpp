@@ -25,8 +25,8 @@
 #include "solarus/core/Savegame.h"
 #include "solarus/core/System.h"
 #include "solarus/entities/Hero.h"
+#include "solarus/lua/LuaContext.h"
 #include <algorithm>
-#include <sstream>
 
 namespace Solarus {
 
@@ -36,7 +36,11 @@ namespace Solarus {
  */
 Equipment::Equipment(Savegame& savegame):
   savegame(savegame),
-  suspended(true) {
+  suspended(true),
+  items_to_update(),
+  items_to_update_valid(false),
+  items_to_update_revision(0),
+  items_to_update_from_metatable(false) {
 
 }
 
@@ -60,6 +64,8 @@ Game* Equipment::get_game() {
  * \brief Notifies the equipment that the game has just started.
  */
 void Equipment::notify_game_started() {
+
+  items_to_update_valid = false;
 }
 
 /**
@@ -108,11 +114,46 @@ void Equipment::update() {
     set_suspended(game_suspended);
   }
 
-  // Update item scripts.
+  // Update item scripts that define on_update().
+  update_items_to_update();
+  for (EquipmentItem* item: items_to_update) {
+    item->update();
+  }
+}
+
+/**
+ * \brief Rebuilds the list of items whose script defines on_update() if
+ * methods were added or removed since the last call.
+ */
+void Equipment::update_items_to_update() {
+
+  if (items.empty()) {
+    items_to_update.clear();
+    return;
+  }
+
+  LuaContext& lua_context = savegame.get_lua_context();
+  const uint64_t revision = lua_context.get_userdata_fields_revision();
+  const bool from_metatable = lua_context.userdata_has_metafield(
+      *items.begin()->second, "on_update"
+  );
+  if (items_to_update_valid &&
+      revision == items_to_update_revision &&
+      from_metatable == items_to_update_from_metatable) {
+    // Nothing changed.
+    return;
+  }
+
+  items_to_update.clear();
   for (const auto& kvp: items) {
     EquipmentItem& item = *kvp.second;
-    item.update();
+    if (lua_context.userdata_has_field(item, "on_update")) {
+      items_to_update.push_back(&item);
+    }
   }
+  items_to_update_valid = true;
+  items_to_update_revision = revision;
+  items_to_update_from_metatable = from_metatable;
 }
 
 /**
@@ -394,6 +435,7 @@ void Equipment::load_items() {
     item->set_name(item_id);
     items[item_id] = item;
   }
+  items_to_update_valid = false;
 
   // Load the item scripts.
   for (const auto& kvp: items) {
@@ -456,9 +498,7 @@ EquipmentItem* Equipment::get_item_assigned(int slot) {
   Debug::check_assertion(slot >= 1 && slot <= 2,
       "Invalid item slot");
 
-  char savegame_variable[] = "_item_slot_0";
-  savegame_variable[11] = '0' + slot;
-  const std::string& item_name = savegame.get_string(savegame_variable);
+  const std::string& item_name = savegame.get_string(get_item_slot_savegame_variable(slot));
 
   EquipmentItem* item = nullptr;
   if (!item_name.empty()) {
@@ -477,9 +517,7 @@ const EquipmentItem* Equipment::get_item_assigned(int slot) const {
   Debug::check_assertion(slot >= 1 && slot <= 2,
       "Invalid item slot");
 
-  std::ostringstream oss;
-  oss << "_item_slot_" << slot;
-  const std::string& item_name = savegame.get_string(oss.str());
+  const std::string& item_name = savegame.get_string(get_item_slot_savegame_variable(slot));
 
   const EquipmentItem* item = nullptr;
   if (!item_name.empty()) {
@@ -502,8 +540,7 @@ void Equipment::set_item_assigned(int slot, EquipmentItem* item) {
   Debug::check_assertion(slot >= 1 && slot <= 2,
       "Invalid item slot");
 
-  std::ostringstream oss;
-  oss << "_item_slot_" << slot;
+  const SavegameKey& savegame_variable = get_item_slot_savegame_variable(slot);
 
   if (item != nullptr) {
     Debug::check_assertion(item->get_variant() > 0,
@@ -512,13 +549,23 @@ void Equipment::set_item_assigned(int slot, EquipmentItem* item) {
     Debug::check_assertion(item->is_assignable(),
         std::string("The item '") + item->get_name()
         + "' cannot be assigned");
-    savegame.set_string(oss.str(), item->get_name());
+    savegame.set_string(savegame_variable, item->get_name());
   }
   else {
-    savegame.set_string(oss.str(), "");
+    savegame.set_string(savegame_variable, "");
   }
 }
 
+/**
+ * \brief Returns the savegame variable that stores the item assigned to a slot.
+ * \param slot Slot of the item (1 or 2).
+ * \return Key of the string savegame variable that stores this slot.
+ */
+const SavegameKey& Equipment::get_item_slot_savegame_variable(int slot) const {
+
+  return slot == 1 ? Savegame::KEY_ITEM_SLOT_1 : Savegame::KEY_ITEM_SLOT_2;
+}
+
 /**
  * \brief Returns the slot (1 or 2) where the specified item is currently assigned.
  * \param item The item to find.
@@ -541,9 +588,9 @@ int Equipment::get_item_slot(const EquipmentItem& item) const {
 /**
  * \brief Returns the savegame variable that stores the specified ability.
  * \param ability An ability.
- * \return Name of the integer savegame variable that stores this ability.
+ * \return Key of the integer savegame variable that stores this ability.
  */
-std::string Equipment::get_ability_savegame_variable(Ability ability) const {
+const SavegameKey& Equipment::get_ability_savegame_variable(Ability ability) const {
 
   switch (ability) {
 
@@ -19,12 +19,52 @@
 #include "solarus/core/FontResource.h"
 #include "solarus/core/QuestFiles.h"
 #include "solarus/graphics/Surface.h"
+#include "solarus/graphics/Video.h"
+#include <algorithm>
 #include <utility>
 
 namespace Solarus {
 
+namespace {
+
+/**
+ * \brief Maximum number of bytes used by glyph images of all atlases.
+ *
+ * Least recently used atlases are discarded above this limit.
+ */
+constexpr size_t max_glyph_atlases_size = 4 * 1024 * 1024;
+
+/**
+ * \brief Encodes a code point in UTF-8.
+ * \param code_point A code point of the basic multilingual plane.
+ * \return The UTF-8 string of this character.
+ */
+std::string encode_utf8(uint32_t code_point) {
+
+  std::string result;
+  if (code_point < 0x80) {
+    result += static_cast<char>(code_point);
+  }
+  else if (code_point < 0x800) {
+    result += static_cast<char>(0xC0 | (code_point >> 6));
+    result += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+  else {
+    result += static_cast<char>(0xE0 | (code_point >> 12));
+    result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    result += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+  return result;
+}
+
+}  // Anonymous namespace.
+
 bool FontResource::fonts_loaded = false;
 std::map<std::string, FontResource::FontFile> FontResource::fonts;
+std::list<std::pair<FontResource::GlyphAtlasKey, FontResource::GlyphAtlasPtr>>
+    FontResource::glyph_atlases;
+std::map<FontResource::GlyphAtlasKey, std::list<std::pair<FontResource::GlyphAtlasKey, FontResource::GlyphAtlasPtr>>::iterator>
+    FontResource::glyph_atlases_by_key;
 
 /**
  * \brief Initializes the font system.
@@ -39,6 +79,8 @@ void FontResource::initialize() {
  */
 void FontResource::quit() {
 
+  glyph_atlases_by_key.clear();
+  glyph_atlases.clear();
   fonts.clear();
   fonts_loaded = false;
   TTF_Quit();
@@ -218,5 +260,179 @@ TTF_Font& FontResource::get_outline_font(const std::string& font_id, int size) {
   return *outline_fonts.at(size).outline_font;
 }
 
+/**
+ * \brief Returns the glyphs of an outline font with the specified size,
+ * rendering mode and color.
+ *
+ * Atlases are kept between calls until they use too much memory,
+ * in which case the least recently used ones are discarded.
+ *
+ * \param font_id Id of the outline font to get. It must exist.
+ * \param size Size to use.
+ * \param antialiasing \c true to render glyphs blended, \c false to render
+ * them solid.
+ * \param color Color of the glyphs.
+ * \return The glyph atlas.
+ */
+FontResource::GlyphAtlasPtr FontResource::get_glyph_atlas(
+    const std::string& font_id,
+    int size,
+    bool antialiasing,
+    const Color& color
+) {
+  uint8_t r, g, b, a;
+  color.get_components(r, g, b, a);
+  const GlyphAtlasKey key(
+      font_id,
+      size,
+      antialiasing,
+      (uint32_t(r) << 24) | (uint32_t(g) << 16) | (uint32_t(b) << 8) | a
+  );
+
+  const auto& it = glyph_atlases_by_key.find(key);
+  if (it != glyph_atlases_by_key.end()) {
+    // Move it to the front of the list.
+    glyph_atlases.splice(glyph_atlases.begin(), glyph_atlases, it->second);
+    shrink_glyph_atlases();
+    return glyph_atlases.front().second;
+  }
+
+  TTF_Font& font = get_outline_font(font_id, size);
+  GlyphAtlasPtr atlas = std::make_shared<GlyphAtlas>(font, antialiasing, color);
+  glyph_atlases.emplace_front(key, atlas);
+  glyph_atlases_by_key[key] = glyph_atlases.begin();
+  shrink_glyph_atlases();
+  return atlas;
 }
 
+/**
+ * \brief Discards the least recently used glyph atlases until the memory
+ * they use is below the limit.
+ *
+ * The most recently used atlas is always kept.
+ */
+void FontResource::shrink_glyph_atlases() {
+
+  size_t total_size = 0;
+  for (const auto& kvp : glyph_atlases) {
+    total_size += kvp.second->get_memory_size();
+  }
+
+  while (total_size > max_glyph_atlases_size && glyph_atlases.size() > 1) {
+    const auto& kvp = glyph_atlases.back();
+    total_size -= kvp.second->get_memory_size();
+    glyph_atlases_by_key.erase(kvp.first);
+    glyph_atlases.pop_back();
+  }
+}
+
+/**
+ * \brief Creates an empty glyph atlas.
+ * \param font The font at the size of this atlas.
+ * \param antialiasing \c true to render glyphs blended, \c false to render
+ * them solid.
+ * \param color Color of the glyphs.
+ */
+FontResource::GlyphAtlas::GlyphAtlas(
+    TTF_Font& font, bool antialiasing, const Color& color):
+  font(font),
+  antialiasing(antialiasing),
+  color(color),
+  memory_size(0) {
+
+}
+
+/**
+ * \brief Returns a character of this atlas, rendering it if necessary.
+ * \param code_point Unicode code point of the character.
+ * \return The glyph, or nullptr if it cannot be rendered as a single
+ * glyph by SDL_ttf. The text should then be rendered as a whole.
+ */
+const FontResource::Glyph* FontResource::GlyphAtlas::get_glyph(uint32_t code_point) {
+
+  const auto& it = glyphs.find(code_point);
+  if (it != glyphs.end()) {
+    return &it->second;
+  }
+
+  if (code_point == 0 || code_point > 0xFFFF) {
+    // SDL_ttf glyphs are limited to the basic multilingual plane.
+    return nullptr;
+  }
+
+  int min_x = 0, max_x = 0, min_y = 0, max_y = 0, advance = 0;
+  if (TTF_GlyphMetrics(&font, static_cast<Uint16>(code_point),
+      &min_x, &max_x, &min_y, &max_y, &advance) != 0) {
+    return nullptr;
+  }
+
+  // Render the character alone: the result has the height of the font
+  // and starts at the pen position or at the left of the glyph.
+  SDL_Color internal_color;
+  color.get_components(
+      internal_color.r, internal_color.g, internal_color.b, internal_color.a);
+  const std::string text = encode_utf8(code_point);
+  Surface::SDL_Surface_UniquePtr rendered_surface(antialiasing ?
+      TTF_RenderUTF8_Blended(&font, text.c_str(), internal_color) :
+      TTF_RenderUTF8_Solid(&font, text.c_str(), internal_color)
+  );
+
+  Glyph glyph;
+  glyph.min_x = std::min(0, min_x);
+  glyph.max_x = std::max(advance, max_x);
+  glyph.advance = advance;
+  if (rendered_surface != nullptr &&
+      rendered_surface->w > 0 &&
+      rendered_surface->h > 0) {
+    // Use the format of surfaces so that glyphs can be copied directly.
+    SDL_Surface* converted_surface = SDL_ConvertSurface(
+        rendered_surface.get(), Video::get_pixel_format(), 0);
+    Debug::check_assertion(converted_surface != nullptr,
+        std::string("Failed to convert glyph surface: ") + SDL_GetError());
+    glyph.image = std::make_shared<Surface>(converted_surface);
+    memory_size += converted_surface->h * converted_surface->pitch;
+  }
+
+  return &glyphs.emplace(code_point, std::move(glyph)).first->second;
+}
+
+/**
+ * \brief Returns the kerning between two characters of this atlas.
+ * \param previous_code_point The character before, or 0.
+ * \param code_point The character after.
+ * \return The horizontal adjustment of the pen position between them.
+ */
+int FontResource::GlyphAtlas::get_kerning(
+    uint32_t previous_code_point, uint32_t code_point) const {
+
+  if (previous_code_point == 0 ||
+      previous_code_point > 0xFFFF ||
+      code_point > 0xFFFF ||
+      TTF_GetFontKerning(&font) == 0) {
+    return 0;
+  }
+
+  return TTF_GetFontKerningSizeGlyphs(
+      &font,
+      static_cast<Uint16>(previous_code_point),
+      static_cast<Uint16>(code_point)
+  );
+}
+
+/**
+ * \brief Returns the height of texts rendered with this atlas.
+ * \return The font height.
+ */
+int FontResource::GlyphAtlas::get_height() const {
+  return TTF_FontHeight(&font);
+}
+
+/**
+ * \brief Returns the memory used by the images of this atlas.
+ * \return The size in bytes.
+ */
+size_t FontResource::GlyphAtlas::get_memory_size() const {
+  return memory_size;
+}
+
+}
@@ -22,6 +22,7 @@
 #include "solarus/core/Game.h"
 #include "solarus/core/MainLoop.h"
 #include "solarus/core/Map.h"
+#include "solarus/core/ResourceProvider.h"
 #include "solarus/core/Savegame.h"
 #include "solarus/core/Treasure.h"
 #include "solarus/entities/Destination.h"
@@ -30,6 +31,7 @@
 #include "solarus/entities/Hero.h"
 #include "solarus/entities/NonAnimatedRegions.h"
 #include "solarus/entities/StartingLocationMode.h"
+#include "solarus/entities/Teletransporter.h"
 #include "solarus/entities/TilePattern.h"
 #include "solarus/entities/Tileset.h"
 #include "solarus/graphics/Color.h"
@@ -37,6 +39,7 @@
 #include "solarus/graphics/TransitionFade.h"
 #include "solarus/graphics/Video.h"
 #include "solarus/lua/LuaContext.h"
+#include <algorithm>
 #include <map>
 
 namespace Solarus {
@@ -62,6 +65,8 @@ Game::Game(MainLoop& main_loop, const std::shared_ptr<Savegame>& savegame):
   previous_map_surface(nullptr),
   transition_style(Transition::Style::IMMEDIATE),
   transition(nullptr),
+  preloading_map(),
+  map_preloading_targets(),
   crystal_state(false) {
 
   // notify objects
@@ -368,6 +373,76 @@ void Game::update() {
   // Update the equipment and HUD.
   get_equipment().update();
   update_commands_effects();
+
+  // Prepare the maps the hero may go to soon.
+  update_map_preloading();
+}
+
+/**
+ * \brief Loads in advance the maps that teletransporters close to the camera
+ * lead to.
+ *
+ * The data file and the tileset of these maps are loaded in background
+ * and are then already in the resource provider when the hero takes the
+ * teletransporter.
+ * At most one map starts being preloaded per cycle.
+ */
+void Game::update_map_preloading() {
+
+  get_resource_provider().update();
+
+  if (current_map == nullptr ||
+      !current_map->is_started() ||
+      next_map != nullptr) {
+    return;
+  }
+
+  if (preloading_map.lock() != current_map) {
+    // The map has changed: find its teletransporters.
+    preloading_map = current_map;
+    map_preloading_targets.clear();
+    const std::string& current_map_id = current_map->get_id();
+    for (const std::shared_ptr<Teletransporter>& teletransporter :
+        current_map->get_entities().get_entities_by_type<Teletransporter>()) {
+      const std::string& map_id = teletransporter->get_destination_map_id();
+      if (map_id != current_map_id) {
+        map_preloading_targets.emplace_back(teletransporter->get_bounding_box(), map_id);
+      }
+    }
+  }
+
+  if (map_preloading_targets.empty()) {
+    return;
+  }
+
+  const CameraPtr& camera = current_map->get_camera();
+  if (camera == nullptr) {
+    return;
+  }
+
+  // Preload the first map whose teletransporter is near the camera.
+  constexpr int margin = 160;
+  const Rectangle& camera_box = camera->get_bounding_box();
+  const Rectangle area(
+      camera_box.get_x() - margin,
+      camera_box.get_y() - margin,
+      camera_box.get_width() + 2 * margin,
+      camera_box.get_height() + 2 * margin
+  );
+  for (const auto& target : map_preloading_targets) {
+    if (area.overlaps(target.first)) {
+      const std::string map_id = target.second;
+      get_resource_provider().preload_map(map_id);
+      map_preloading_targets.erase(std::remove_if(
+          map_preloading_targets.begin(),
+          map_preloading_targets.end(),
+          [&map_id](const std::pair<Rectangle, std::string>& other) {
+            return other.second == map_id;
+          }
+      ), map_preloading_targets.end());
+      return;
+    }
+  }
 }
 
 /**
@@ -572,8 +647,10 @@ void Game::draw(const SurfacePtr& dst_surface) {
 
   // Draw the map.
   if (current_map->is_loaded()) {
-    dst_surface->fill_with_color(current_map->get_tileset().get_background_color());
     current_map->draw();
+    if (!is_screen_covered_by_camera(*dst_surface)) {
+      dst_surface->fill_with_color(current_map->get_tileset().get_background_color());
+    }
     const CameraPtr& camera = current_map->get_camera();
     if (camera != nullptr) {
       const SurfacePtr& camera_surface = camera->get_surface();
@@ -592,6 +669,47 @@ void Game::draw(const SurfacePtr& dst_surface) {
   get_lua_context().game_on_draw(*this, dst_surface);
 }
 
+/**
+ * \brief Returns whether the camera surface will entirely hide the screen.
+ *
+ * The map fills the camera surface with the opaque background color of the
+ * tileset before drawing anything, so in this case it is useless to also
+ * fill the screen with that color first.
+ *
+ * \param dst_surface The surface where the game is drawn.
+ * \return \c true if nothing drawn before the camera would remain visible.
+ */
+bool Game::is_screen_covered_by_camera(const Surface& dst_surface) const {
+
+  if (transition != nullptr) {
+    // Transitions may make the camera surface partially transparent.
+    return false;
+  }
+
+  const CameraPtr& camera = current_map->get_camera();
+  if (camera == nullptr) {
+    return false;
+  }
+
+  const SurfacePtr& camera_surface = camera->get_surface();
+  if (camera_surface == nullptr ||
+      camera_surface->get_opacity() != 255) {
+    return false;
+  }
+
+  const BlendMode blend_mode = camera_surface->get_blend_mode();
+  if (blend_mode != BlendMode::BLEND && blend_mode != BlendMode::NONE) {
+    return false;
+  }
+
+  if (current_map->get_tileset().get_background_color().get_alpha() != 255) {
+    return false;
+  }
+
+  const Rectangle camera_rectangle(camera->get_position_on_screen(), camera_surface->get_size());
+  return camera_rectangle.contains(Rectangle(Point(0, 0), dst_surface.get_size()));
+}
+
 /**
  * \brief Returns whether there is a current map in this game.
  *
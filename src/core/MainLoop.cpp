@@ -32,12 +32,22 @@
 #include "solarus/graphics/Surface.h"
 #include "solarus/graphics/Video.h"
 #include "solarus/lua/LuaContext.h"
+#include "solarus/lua/LuaDataCache.h"
 #include "solarus/lua/LuaTools.h"
 #include <lua.hpp>
+#include <cerrno>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <thread>
 
+#ifndef _WIN32
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#endif
+
 namespace Solarus {
 
 namespace {
@@ -114,8 +124,111 @@ std::string get_quest_path(const Arguments& args) {
   return SOLARUS_DEFAULT_QUEST;
 }
 
+/**
+ * \brief Maximum number of pending commands of each Lua console transport.
+ */
+constexpr size_t lua_commands_capacity = 1024;
+
+/**
+ * \brief Default maximum number of Lua console commands run per cycle.
+ */
+constexpr int default_lua_commands_budget = 64;
+
+/**
+ * \brief Formats the result of a Lua command as a line of the socket console.
+ *
+ * The line has the form "id<TAB>ok|error[<TAB>value]...".
+ * Tabulations, newlines and backslashes in values are escaped.
+ *
+ * \param result The result to format.
+ * \return The corresponding line, including the final newline.
+ */
+std::string lua_command_result_to_line(const MainLoop::LuaCommandResult& result) {
+
+  std::ostringstream oss;
+  oss << result.id << '\t' << (result.success ? "ok" : "error");
+  for (const std::string& value : result.values) {
+    oss << '\t';
+    for (char c : value) {
+      switch (c) {
+
+      case '\\':
+        oss << "\\\\";
+        break;
+
+      case '\t':
+        oss << "\\t";
+        break;
+
+      case '\n':
+        oss << "\\n";
+        break;
+
+      case '\r':
+        oss << "\\r";
+        break;
+
+      default:
+        oss << c;
+        break;
+      }
+    }
+  }
+  oss << '\n';
+  return oss.str();
+}
+
+#ifndef _WIN32
+/**
+ * \brief Writes a whole string to a socket.
+ * \param fd The socket.
+ * \param data What to write.
+ * \return \c false if the connection is broken.
+ */
+bool send_all(int fd, const std::string& data) {
+
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+
+  size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t result = send(fd, data.data() + sent, data.size() - sent, flags);
+    if (result <= 0) {
+      return false;
+    }
+    sent += static_cast<size_t>(result);
+  }
+  return true;
+}
+#endif
+
+/**
+ * \brief Removes trailing whitespaces of a console line.
+ * \param line The line to modify.
+ */
+void trim_lua_command_line(std::string& line) {
+
+  while (!line.empty() && std::isspace(line.at(line.size() - 1))) {
+    line.erase(line.size() - 1);
+  }
+}
+
 }  // Anonymous namespace.
 
+/**
+ * \brief Creates the queues of a Lua console transport.
+ * \param capacity Maximum number of pending commands and of pending results.
+ */
+MainLoop::LuaCommandChannel::LuaCommandChannel(size_t capacity):
+  commands(capacity),
+  results(capacity),
+  num_commands_pushed(0) {
+
+}
+
 /**
  * \brief Initializes the game engine.
  * \param args Command-line arguments.
@@ -128,10 +241,10 @@ MainLoop::MainLoop(const Arguments& args):
   exiting(false),
   debug_lag(0),
   turbo(false),
-  lua_commands(),
+  lua_commands(lua_commands_capacity),
   lua_commands_mutex(),
-  num_lua_commands_pushed(0),
-  num_lua_commands_done(0) {
+  socket_lua_commands(lua_commands_capacity),
+  lua_commands_budget(default_lua_commands_budget) {
 
   Logger::info(std::string("Solarus ") + SOLARUS_VERSION);
 
@@ -162,6 +275,9 @@ MainLoop::MainLoop(const Arguments& args):
   // Read the quest general properties.
   load_quest_properties();
 
+  // Start parsing big data files in background.
+  LuaDataCache::initialize();
+
   // Create the quest surface.
   root_surface = Surface::create(
       Video::get_quest_size()
@@ -184,6 +300,25 @@ MainLoop::MainLoop(const Arguments& args):
     Logger::info("Lua console: no");
   }
 
+  const std::string& lua_console_budget_arg = args.get_argument_value("-lua-console-budget");
+  if (!lua_console_budget_arg.empty()) {
+    std::istringstream iss(lua_console_budget_arg);
+    int budget = -1;
+    if (iss >> budget && iss.eof() && budget >= 0) {
+      lua_commands_budget = budget;
+    }
+    else {
+      Logger::error("Invalid Lua console budget: '" + lua_console_budget_arg +
+                    "' (should be a positive number or 0), using " +
+                    String::to_string(lua_commands_budget));
+    }
+  }
+
+  const std::string& lua_console_socket_arg = args.get_argument_value("-lua-console-socket");
+  if (!lua_console_socket_arg.empty()) {
+    initialize_lua_console_socket(lua_console_socket_arg);
+  }
+
   if (turbo) {
     Logger::info("Turbo mode: yes");
   }
@@ -212,7 +347,9 @@ MainLoop::~MainLoop() {
   if (lua_context != nullptr) {
     lua_context->exit();
   }
+  resource_provider.finish_all_map_preloading();  // Still reading quest files.
   TilePattern::quit();
+  LuaDataCache::quit();
   CurrentQuest::quit();
   QuestFiles::close_quest();
   System::quit();
@@ -296,17 +433,55 @@ void MainLoop::set_game(Game* game) {
 /**
  * \brief Schedules a Lua command to be executed at the next cycle.
  *
- * This function is thread safe, it can be called from a separate thread
- * while the main loop is running.
+ * This function can be called from any thread while the main loop is
+ * running, including concurrently with the standard input console.
+ * Commands accepted get consecutive ids.
  *
  * \param command The Lua string to execute.
- * \return A number identifying your command.
+ * \return A number identifying your command,
+ * or -1 if too many commands are already pending.
  */
 int MainLoop::push_lua_command(const std::string& command) {
 
+  return queue_lua_command(command, true);
+}
+
+/**
+ * \brief Schedules a Lua command of the standard input or of
+ * push_lua_command() to be executed at the next cycle.
+ * \param command The Lua string to execute.
+ * \param keep_result Whether the result should be available to
+ * pop_lua_command_result() after the execution.
+ * \return A number identifying the command,
+ * or -1 if too many commands are already pending.
+ */
+int MainLoop::queue_lua_command(const std::string& command, bool keep_result) {
+
+  // Several producers may share this channel: serialize them.
   std::lock_guard<std::mutex> lock(lua_commands_mutex);
-  lua_commands.push_back(command);
-  return num_lua_commands_pushed++;
+  const int id = lua_commands.num_commands_pushed;
+  if (!lua_commands.commands.push(LuaCommand{ id, command, keep_result })) {
+    return -1;
+  }
+  ++lua_commands.num_commands_pushed;
+  return id;
+}
+
+/**
+ * \brief Returns the result of a Lua command pushed with push_lua_command().
+ *
+ * Results come in the order of execution of their commands.
+ * Like push_lua_command(), this function may be called from any thread.
+ * Results of commands read on the standard input are not kept.
+ * If too many results are pending, new ones are dropped with a warning.
+ *
+ * \param[out] result Receives the oldest result not retrieved yet.
+ * \return \c false if there is no result available.
+ */
+bool MainLoop::pop_lua_command_result(LuaCommandResult& result) {
+
+  std::lock_guard<std::mutex> lock(lua_commands_mutex);
+  return lua_commands.results.pop(result);
 }
 
 /**
@@ -439,23 +614,51 @@ void MainLoop::check_input() {
   }
 
   // Check Lua requests.
-  if (!lua_commands.empty()) {
-    std::lock_guard<std::mutex> lock(lua_commands_mutex);
-    for (const std::string& command : lua_commands) {
+  int budget = lua_commands_budget > 0 ? lua_commands_budget : -1;
+  run_lua_commands(lua_commands, budget, true);
+  run_lua_commands(socket_lua_commands, budget, false);
+}
+
+/**
+ * \brief Executes pending Lua commands of a console transport.
+ *
+ * The result of each command is sent back on the channel.
+ *
+ * \param channel The transport whose commands to run.
+ * \param budget Maximum number of commands to run (-1 means no limit).
+ * Decremented for each command executed.
+ * \param print_banners Whether to print begin and end delimiters around the
+ * output of each command.
+ */
+void MainLoop::run_lua_commands(LuaCommandChannel& channel, int& budget, bool print_banners) {
+
+  lua_State* l = get_lua_context().get_internal_state();
+  LuaCommand command;
+  while (budget != 0 && channel.commands.pop(command)) {
+
+    const std::string& id_string = String::to_string(command.id);
+    if (print_banners) {
       std::cout << "\n";  // To make sure that the command delimiter starts on a new line.
-      Logger::info("====== Begin Lua command #" + String::to_string(num_lua_commands_done) + " ======");
-      const bool success = LuaTools::do_string(get_lua_context().get_internal_state(), command, "Lua command");
-      if (success) {
-        std::cout << "\n";
-        Logger::info("====== End Lua command #" + String::to_string(num_lua_commands_done) + ": success ======");
-      }
-      else {
-        std::cout << "\n";
-        Logger::info("====== End Lua command #" + String::to_string(num_lua_commands_done) + ": error ======");
-      }
-      ++num_lua_commands_done;
+      Logger::info("====== Begin Lua command #" + id_string + " ======");
+    }
+
+    LuaCommandResult result;
+    result.id = command.id;
+    result.success = LuaTools::do_string(l, command.code, "Lua command", result.values);
+
+    if (print_banners) {
+      std::cout << "\n";
+      Logger::info("====== End Lua command #" + id_string + ": " +
+                   (result.success ? "success" : "error") + " ======");
+    }
+
+    if (command.keep_result && !channel.results.push(std::move(result))) {
+      Logger::warning("Too many pending Lua command results, dropping the result of command #" +
+                      id_string);
+    }
+    if (budget > 0) {
+      --budget;
     }
-    lua_commands.clear();
   }
 }
 
@@ -547,12 +750,13 @@ void MainLoop::initialize_lua_console() {
 
       if (std::getline(std::cin, line)) {
 
-        while (!line.empty() && std::isspace(line.at(line.size() - 1))) {
-          line.erase(line.size() - 1);
-        }
+        trim_lua_command_line(line);
 
         if (!line.empty()) {
-          push_lua_command(line);
+          // The result is already printed with the output of the command.
+          if (queue_lua_command(line, false) == -1) {
+            Logger::error("Too many pending Lua commands, ignoring '" + line + "'");
+          }
         }
       }
     }
@@ -560,12 +764,137 @@ void MainLoop::initialize_lua_console() {
   stdin_thread.detach();
 }
 
+/**
+ * \brief Enables accepting Lua commands on a local socket.
+ *
+ * One client can be connected at a time.
+ * Each line received is executed as a Lua command,
+ * and a line with the result of each command is sent back
+ * (see lua_command_result_to_line()).
+ *
+ * \param socket_path Path of the Unix domain socket to create.
+ */
+void MainLoop::initialize_lua_console_socket(const std::string& socket_path) {
+
+#ifndef _WIN32
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    Logger::error("Lua console socket path is too long: '" + socket_path + "'");
+    return;
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  const int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server_fd == -1) {
+    Logger::error("Failed to create the Lua console socket: " + std::string(std::strerror(errno)));
+    return;
+  }
+
+  unlink(socket_path.c_str());  // Remove a stale socket of a previous run.
+  if (bind(server_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+      listen(server_fd, 1) == -1) {
+    Logger::error("Failed to open the Lua console socket '" + socket_path + "': " +
+                  std::string(std::strerror(errno)));
+    close(server_fd);
+    return;
+  }
+  Logger::info("Lua console socket: " + socket_path);
+
+  // Serve the socket in a separate thread.
+  // The thread polls with a timeout so that results can be sent
+  // and so that it notices when the program is exiting.
+  socket_thread = std::thread([this, server_fd, socket_path]() {
+
+    int client_fd = -1;
+    int first_client_command_id = 0;
+    std::string buffer;
+    char chunk[4096];
+    LuaCommandResult result;
+
+    while (!is_exiting()) {
+
+      // Send back the results of commands executed since last time.
+      // Results of commands of a previous client are dropped.
+      while (socket_lua_commands.results.pop(result)) {
+        if (client_fd != -1 &&
+            result.id >= first_client_command_id &&
+            !send_all(client_fd, lua_command_result_to_line(result))) {
+          close(client_fd);
+          client_fd = -1;
+        }
+      }
+
+      pollfd poll_fd;
+      poll_fd.fd = (client_fd != -1) ? client_fd : server_fd;
+      poll_fd.events = POLLIN;
+      poll_fd.revents = 0;
+      if (poll(&poll_fd, 1, 10) <= 0) {
+        continue;
+      }
+
+      if (client_fd == -1) {
+        client_fd = accept(server_fd, nullptr, nullptr);
+        first_client_command_id = socket_lua_commands.num_commands_pushed;
+        buffer.clear();
+        continue;
+      }
+
+      const ssize_t num_read = recv(client_fd, chunk, sizeof(chunk), 0);
+      if (num_read <= 0) {
+        // The client disconnected.
+        close(client_fd);
+        client_fd = -1;
+        continue;
+      }
+      buffer.append(chunk, static_cast<size_t>(num_read));
+
+      size_t end_of_line = buffer.find('\n');
+      while (end_of_line != std::string::npos) {
+        std::string line = buffer.substr(0, end_of_line);
+        buffer.erase(0, end_of_line + 1);
+        trim_lua_command_line(line);
+
+        if (!line.empty()) {
+          const int id = socket_lua_commands.num_commands_pushed;
+          if (socket_lua_commands.commands.push(LuaCommand{ id, line, true })) {
+            ++socket_lua_commands.num_commands_pushed;
+          }
+          else {
+            // Rejected commands get no id.
+            LuaCommandResult full_result;
+            full_result.id = -1;
+            full_result.success = false;
+            full_result.values.push_back("Too many pending Lua commands");
+            send_all(client_fd, lua_command_result_to_line(full_result));
+          }
+        }
+        end_of_line = buffer.find('\n');
+      }
+    }
+
+    if (client_fd != -1) {
+      close(client_fd);
+    }
+    close(server_fd);
+    unlink(socket_path.c_str());
+  });
+#else
+  Logger::error("Lua console socket is not supported on this platform: '" + socket_path + "'");
+#endif
+}
+
 /**
  * \brief Cleans resources started by initialize_lua_console().
  */
 void MainLoop::quit_lua_console() {
 
   exiting = true;
+  if (socket_thread.joinable()) {
+    socket_thread.join();
+  }
+
   if (!stdin_thread.joinable()) {
       return;
   }
@@ -18,6 +18,7 @@
 #include "solarus/core/Debug.h"
 #include "solarus/core/Game.h"
 #include "solarus/core/Map.h"
+#include "solarus/core/MapSnapshot.h"
 #include "solarus/core/QuestFiles.h"
 #include "solarus/core/ResourceProvider.h"
 #include "solarus/core/Savegame.h"
@@ -30,7 +31,6 @@
 #include "solarus/entities/Tileset.h"
 #include "solarus/graphics/Sprite.h"
 #include "solarus/graphics/Surface.h"
-#include "solarus/graphics/Video.h"
 #include "solarus/lua/LuaContext.h"
 
 namespace Solarus {
@@ -49,16 +49,24 @@ Map::Map(const std::string& id):
   max_layer(0),
   tileset(nullptr),
   floor(MapData::NO_FLOOR),
-  background_surface(nullptr),
   foreground_surface(nullptr),
   loaded(false),
   started(false),
   destination_name(""),
   entities(nullptr),
-  suspended(false) {
+  snapshot(nullptr),
+  suspended(false),
+  num_detector_candidates(0),
+  num_detector_checks(0) {
 
 }
 
+/**
+ * \brief Destructor.
+ */
+Map::~Map() {
+}
+
 /**
  * \brief Returns the id of the map.
  * \return the map id
@@ -90,7 +98,6 @@ void Map::set_tileset(const std::string& tileset_id) {
   tileset = &resource_provider.get_tileset(tileset_id);
   get_entities().notify_tileset_changed();
   this->tileset_id = tileset_id;
-  build_background_surface();
 }
 
 /**
@@ -262,8 +269,8 @@ void Map::unload() {
 
   if (is_loaded()) {
     tileset = nullptr;
-    background_surface = nullptr;
     foreground_surface = nullptr;
+    snapshot = nullptr;
     entities = nullptr;
 
     loaded = false;
@@ -279,22 +286,13 @@ void Map::unload() {
  */
 void Map::load(Game& game) {
 
-  background_surface = Surface::create(
-      Video::get_quest_size()
-  );
-
-  // Read the map data file.
-  MapData data;
-  const std::string& file_name = std::string("maps/") + get_id() + ".dat";
-  bool success = data.import_from_quest_file(file_name);
-
-  if (!success) {
-    Debug::die("Failed to load map data file '" + file_name + "'");
-  }
+  // Read the map data file, or get it from the cache if it was preloaded.
+  ResourceProvider& resource_provider = game.get_resource_provider();
+  const std::shared_ptr<const MapData> map_data = resource_provider.get_map_data(get_id());
+  const MapData& data = *map_data;
 
   // Initialize the map from the data just read.
   this->game = &game;
-  ResourceProvider& resource_provider = game.get_resource_provider();
   location.set_xy(data.get_location());
   location.set_size(data.get_size());
   width8 = data.get_size().width / 8;
@@ -307,9 +305,8 @@ void Map::load(Game& game) {
   tileset_id = data.get_tileset_id();
   tileset = &resource_provider.get_tileset(tileset_id);
   entities = std::unique_ptr<Entities>(new Entities(game, *this));
-  entities->create_entities(data);
+  entities->create_entities(map_data);
 
-  build_background_surface();
   build_foreground_surface();
 
   loaded = true;
@@ -536,25 +533,17 @@ void Map::draw() {
   get_lua_context().map_on_draw(*this, camera_surface);
 }
 
-/**
- * \brief Builds or rebuilds the surface corresponding to the background of
- * the tileset.
- */
-void Map::build_background_surface() {
-
-  if (tileset != nullptr) {
-    background_surface->clear();
-    background_surface->fill_with_color(tileset->get_background_color());
-  }
-}
-
 /**
  * \brief Draws the background of the map.
+ *
+ * The background color of the tileset is filled directly on the destination
+ * surface rather than drawn from an intermediate surface.
+ *
  * \param dst_surface The surface where to draw.
  */
 void Map::draw_background(const SurfacePtr& dst_surface) {
 
-  background_surface->draw(dst_surface);
+  dst_surface->fill_with_color(tileset->get_background_color());
 }
 
 /**
@@ -712,6 +701,41 @@ void Map::leave() {
   this->entities->notify_map_finished();
 }
 
+/**
+ * \brief Captures the current state of the entities of this map.
+ *
+ * The previous snapshot, if any, is replaced.
+ * The map must be loaded.
+ * The Lua event map:on_snapshot() is then called so that scripts can save
+ * what the snapshot does not capture.
+ */
+void Map::save_snapshot() {
+
+  snapshot = std::unique_ptr<MapSnapshot>(new MapSnapshot(*this));
+  get_lua_context().map_on_snapshot(*this);
+}
+
+/**
+ * \brief Restores the entities of this map to the state captured by the
+ * last call to save_snapshot().
+ *
+ * The snapshot is kept and can be restored again.
+ * The Lua event map:on_restore_snapshot() is then called so that scripts
+ * can restore what the snapshot does not capture.
+ *
+ * \return \c false if there is no snapshot.
+ */
+bool Map::restore_snapshot() {
+
+  if (snapshot == nullptr) {
+    return false;
+  }
+
+  snapshot->restore(*this);
+  get_lua_context().map_on_restore_snapshot(*this);
+  return true;
+}
+
 /**
  * \brief Returns whether the map is started.
  *
@@ -879,18 +903,18 @@ bool Map::test_collision_with_entities(
 }
 
 /**
- * \brief Tests whether a rectangle collides with the map obstacles.
+ * \brief Tests whether a rectangle collides with the ground of the map.
  * \param layer Layer of the rectangle in the map.
  * \param collision_box The rectangle to check (its dimensions should be
  * multiples of 8).
- * \param entity_to_check The entity to check (used to decide what is
+ * \param entity_to_check The entity to check (used to decide what grounds are
  * considered as obstacle).
- * \return \c true if the rectangle is overlapping an obstacle.
+ * \return \c true if the rectangle is overlapping an obstacle ground.
  */
-bool Map::test_collision_with_obstacles(
+bool Map::test_collision_with_ground(
     int layer,
     const Rectangle& collision_box,
-    Entity& entity_to_check) {
+    const Entity& entity_to_check) const {
 
   // This function is called very often.
   // For performance reasons, we only check the border of the of the collision box.
@@ -947,10 +971,107 @@ bool Map::test_collision_with_obstacles(
     }
   }
 
+  return false;
+}
+
+/**
+ * \brief Tests whether a rectangle collides with the map obstacles.
+ * \param layer Layer of the rectangle in the map.
+ * \param collision_box The rectangle to check (its dimensions should be
+ * multiples of 8).
+ * \param entity_to_check The entity to check (used to decide what is
+ * considered as obstacle).
+ * \return \c true if the rectangle is overlapping an obstacle.
+ */
+bool Map::test_collision_with_obstacles(
+    int layer,
+    const Rectangle& collision_box,
+    Entity& entity_to_check) {
+
+  if (test_collision_with_ground(layer, collision_box, entity_to_check)) {
+    return true;
+  }
+
   // No collision with the terrain: check collisions with dynamic entities.
   return test_collision_with_entities(layer, collision_box, entity_to_check);
 }
 
+/**
+ * \brief Tests whether a rectangle collides with the map obstacles,
+ * knowing the entities that can be obstacles around it.
+ *
+ * This is equivalent to the other version but avoids a spatial search of
+ * entities when several rectangles are tested in the same area.
+ *
+ * \param layer Layer of the rectangle in the map.
+ * \param collision_box The rectangle to check (its dimensions should be
+ * multiples of 8).
+ * \param entity_to_check The entity to check (used to decide what is
+ * considered as obstacle).
+ * \param candidate_obstacles Entities that may be obstacles in an area
+ * that contains the rectangle, as returned by get_candidate_obstacles().
+ * They must still be valid: the result of get_candidate_obstacles() is
+ * outdated as soon as entities are added, removed, moved, enabled or
+ * disabled.
+ * \return \c true if the rectangle is overlapping an obstacle.
+ */
+bool Map::test_collision_with_obstacles(
+    int layer,
+    const Rectangle& collision_box,
+    Entity& entity_to_check,
+    const std::vector<Entity*>& candidate_obstacles) {
+
+  if (test_collision_with_ground(layer, collision_box, entity_to_check)) {
+    return true;
+  }
+
+  for (Entity* entity_nearby: candidate_obstacles) {
+    if (entity_nearby->overlaps(collision_box) &&
+        entity_nearby->is_obstacle_for(entity_to_check, collision_box)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * \brief Gets the entities that may be obstacles for an entity in an area.
+ *
+ * The result only depends on the presence, the position, the layer and the
+ * enabled state of entities.
+ * Whether each one is actually an obstacle is still to be tested with
+ * Entity::is_obstacle_for().
+ *
+ * \param layer Layer of the entity to check.
+ * \param area The rectangle where to search.
+ * \param entity_to_check The entity to check.
+ * \param[out] result The entities found.
+ */
+void Map::get_candidate_obstacles(
+    int layer,
+    const Rectangle& area,
+    const Entity& entity_to_check,
+    std::vector<Entity*>& result) {
+
+  result.clear();
+  if (!is_loaded()) {
+    return;
+  }
+
+  EntityVector entities_nearby;
+  get_entities().get_entities_in_rectangle(area, entities_nearby);
+  for (const EntityPtr& entity_nearby: entities_nearby) {
+    if (entity_nearby->overlaps(area) &&
+        (entity_nearby->get_layer() == layer || entity_nearby->has_layer_independent_collisions()) &&
+        entity_nearby->is_enabled() &&
+        !entity_nearby->is_being_removed() &&
+        entity_nearby.get() != &entity_to_check) {
+      result.push_back(entity_nearby.get());
+    }
+  }
+}
+
 /**
  * \brief Tests whether a point collides with the map obstacles.
  * \param layer Layer of point to check.
@@ -1283,23 +1404,20 @@ void Map::check_collision_with_detectors(Entity& entity) {
 
   // Extend the box because some collision tests work without overlapping.
   Rectangle box = entity.get_extended_bounding_box(8);
-  std::vector<EntityPtr> entities_nearby;
-  entities->get_entities_in_rectangle(box, entities_nearby);
-  for (const EntityPtr& entity_nearby: entities_nearby) {
+  std::vector<EntityPtr> detectors_nearby;
+  entities->get_detectors_in_rectangle(box, entity.get_layer(), detectors_nearby);
+  num_detector_candidates += detectors_nearby.size();
+  for (const EntityPtr& detector: detectors_nearby) {
 
     if (entity.is_being_removed()) {
       return;
     }
 
-    if (!entity_nearby->is_detector()) {
-      // Most entities are detectors anyway.
-      continue;
-    }
-
-    if (entity_nearby->is_enabled() &&
-        !entity_nearby->is_suspended() &&
-        !entity_nearby->is_being_removed()) {
-      entity_nearby->check_collision(entity);
+    if (detector->is_enabled() &&
+        !detector->is_suspended() &&
+        !detector->is_being_removed()) {
+      ++num_detector_checks;
+      detector->check_collision(entity);
     }
   }
 }
@@ -1418,26 +1536,47 @@ void Map::check_collision_with_detectors(Entity& entity, Sprite& sprite) {
 
   // Check each detector.
   Rectangle box = entity.get_max_bounding_box();
-  std::vector<EntityPtr> entities_nearby;
-  entities->get_entities_in_rectangle(box, entities_nearby);
-  for (const EntityPtr& entity_nearby: entities_nearby) {
+  std::vector<EntityPtr> detectors_nearby;
+  entities->get_detectors_in_rectangle(box, entity.get_layer(), detectors_nearby);
+  num_detector_candidates += detectors_nearby.size();
+  for (const EntityPtr& detector: detectors_nearby) {
 
     if (entity.is_being_removed()) {
       return;
     }
 
-    if (!entity_nearby->is_detector()) {
-      continue;
-    }
-
-    if (!entity_nearby->is_being_removed()
-        && !entity_nearby->is_suspended()
-        && entity_nearby->is_enabled()) {
-      entity_nearby->check_collision(entity, sprite);
+    if (!detector->is_being_removed()
+        && !detector->is_suspended()
+        && detector->is_enabled()) {
+      ++num_detector_checks;
+      detector->check_collision(entity, sprite);
     }
   }
 }
 
+/**
+ * \brief Returns the number of detectors found so far near entities
+ * that check collisions with detectors.
+ *
+ * Together with get_num_detector_checks(), this tells how well the
+ * detector index filters candidates.
+ * Scripts can get both with map:get_detector_stats().
+ *
+ * \return The number of detector candidates.
+ */
+uint64_t Map::get_num_detector_candidates() const {
+  return num_detector_candidates;
+}
+
+/**
+ * \brief Returns the number of detector candidates that were enabled and
+ * not suspended, and therefore actually checked.
+ * \return The number of detector checks.
+ */
+uint64_t Map::get_num_detector_checks() const {
+  return num_detector_checks;
+}
+
 /**
  * \brief Returns the name identifying this type in Lua.
  * \return The name identifying this type in Lua.
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/Map.h"
+#include "solarus/core/MapSnapshot.h"
+#include "solarus/entities/Entities.h"
+#include "solarus/entities/Entity.h"
+#include "solarus/graphics/Sprite.h"
+
+namespace Solarus {
+
+/**
+ * \brief Captures the current state of the entities of a map.
+ * \param map The map to capture. It must be loaded.
+ */
+MapSnapshot::MapSnapshot(Map& map):
+  map_id(map.get_id()) {
+
+  Debug::check_assertion(map.is_loaded(), "This map is not loaded");
+
+  const EntityVector& all_entities = map.get_entities().get_entities();
+  entities.reserve(all_entities.size());
+  for (const EntityPtr& entity : all_entities) {
+
+    if (entity->is_being_removed()) {
+      continue;
+    }
+
+    EntityState state;
+    state.entity = entity;
+    state.xy = entity->get_xy();
+    state.layer = entity->get_layer();
+    state.direction = entity->get_direction();
+    state.enabled = entity->is_enabled();
+
+    const std::vector<SpritePtr>& sprites = entity->get_sprites();
+    state.sprites.reserve(sprites.size());
+    for (const SpritePtr& sprite : sprites) {
+      SpriteState sprite_state;
+      sprite_state.animation = sprite->get_current_animation();
+      sprite_state.direction = sprite->get_current_direction();
+      sprite_state.frame = sprite->get_current_frame();
+      sprite_state.paused = sprite->is_paused();
+      state.sprites.push_back(sprite_state);
+    }
+
+    entities.push_back(std::move(state));
+  }
+}
+
+/**
+ * \brief Returns the id of the map that was captured.
+ * \return The map id.
+ */
+const std::string& MapSnapshot::get_map_id() const {
+  return map_id;
+}
+
+/**
+ * \brief Returns the number of entities captured.
+ * \return The number of entities.
+ */
+size_t MapSnapshot::get_num_entities() const {
+  return entities.size();
+}
+
+/**
+ * \brief Restores the entities of a map to the state of this snapshot.
+ *
+ * Entities that no longer exist are ignored.
+ * Sprites are restored only if the entity still has the same number of
+ * sprites.
+ * Enabled and disabled notifications and collisions only happen once all
+ * entities are restored, so that entities and their scripts never see
+ * each other in a half-restored state.
+ *
+ * \param map The map that was captured. It must be loaded.
+ */
+void MapSnapshot::restore(Map& map) const {
+
+  Debug::check_assertion(map.is_loaded(), "This map is not loaded");
+  Debug::check_assertion(map.get_id() == map_id,
+      "This snapshot belongs to map '" + map_id + "'");
+
+  // First put all entities back without notifying them.
+  Entities& map_entities = map.get_entities();
+  EntityVector restored_entities;
+  restored_entities.reserve(entities.size());
+  std::vector<bool> enabled_changed;
+  enabled_changed.reserve(entities.size());
+  for (const EntityState& state : entities) {
+
+    EntityPtr entity = state.entity.lock();
+    if (entity == nullptr ||
+        entity->is_being_removed() ||
+        !entity->is_on_map() ||
+        &entity->get_map() != &map) {
+      continue;
+    }
+
+    entity->set_xy(state.xy);
+    map_entities.set_entity_layer(*entity, state.layer);
+    entity->notify_bounding_box_changed();
+    entity->set_direction(state.direction);
+    restored_entities.push_back(entity);
+    enabled_changed.push_back(entity->set_enabled_state(state.enabled));
+
+    const std::vector<SpritePtr>& sprites = entity->get_sprites();
+    if (sprites.size() != state.sprites.size()) {
+      continue;
+    }
+    for (size_t i = 0; i < sprites.size(); ++i) {
+      Sprite& sprite = *sprites[i];
+      const SpriteState& sprite_state = state.sprites[i];
+      if (sprite.get_current_animation() != sprite_state.animation) {
+        sprite.set_current_animation(sprite_state.animation);
+      }
+      sprite.set_current_direction(sprite_state.direction);
+      sprite.set_current_frame(sprite_state.frame, false);
+      sprite.set_paused(sprite_state.paused);
+    }
+  }
+
+  // Then notify entities enabled or disabled by the restore.
+  for (size_t i = 0; i < restored_entities.size(); ++i) {
+    Entity& entity = *restored_entities[i];
+    if (enabled_changed[i] && !entity.is_being_removed()) {
+      entity.notify_enabled(entity.is_enabled());
+    }
+  }
+
+  // Finally check collisions from the restored positions.
+  for (const EntityPtr& entity : restored_entities) {
+    if (!entity->is_being_removed()) {
+      entity->notify_position_changed();
+    }
+  }
+}
+
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/MappedArchive.h"
+#include <cstdint>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Solarus {
+
+namespace {
+
+// Zip format constants.
+constexpr uint32_t end_of_central_directory_signature = 0x06054b50;
+constexpr uint32_t central_directory_signature = 0x02014b50;
+constexpr uint32_t local_header_signature = 0x04034b50;
+constexpr size_t end_of_central_directory_size = 22;
+constexpr size_t central_directory_header_size = 46;
+constexpr size_t local_header_size = 30;
+constexpr size_t max_comment_size = 0xFFFF;
+constexpr uint16_t method_stored = 0;
+constexpr uint16_t flag_encrypted = 0x0001;
+
+/**
+ * \brief Reads a 16-bit little-endian integer.
+ * \param data Where to read.
+ * \return The value.
+ */
+uint16_t read_uint16(const char* data) {
+
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+/**
+ * \brief Reads a 32-bit little-endian integer.
+ * \param data Where to read.
+ * \return The value.
+ */
+uint32_t read_uint32(const char* data) {
+
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return static_cast<uint32_t>(bytes[0]) |
+      (static_cast<uint32_t>(bytes[1]) << 8) |
+      (static_cast<uint32_t>(bytes[2]) << 16) |
+      (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+}  // Anonymous namespace.
+
+/**
+ * \brief Creates an archive mapping that is not open yet.
+ */
+MappedArchive::MappedArchive():
+  path(),
+  data(nullptr),
+  size(0),
+  entries() {
+
+}
+
+/**
+ * \brief Destructor. Unmaps the archive if it is open.
+ */
+MappedArchive::~MappedArchive() {
+
+  close();
+}
+
+/**
+ * \brief Maps a zip archive into memory and indexes its uncompressed entries.
+ * \param path Path of the archive file.
+ * \return \c true in case of success. In case of failure, the object is left
+ * closed and files of the archive should be read through PhysFS.
+ */
+bool MappedArchive::open(const std::string& path) {
+
+  close();
+
+#ifdef _WIN32
+  (void) path;
+  return false;
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat file_info;
+  if (fstat(fd, &file_info) != 0 || file_info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  const size_t file_size = static_cast<size_t>(file_info.st_size);
+  void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // The mapping stays valid.
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  this->path = path;
+  data = static_cast<const char*>(mapping);
+  size = file_size;
+
+  if (!parse_central_directory()) {
+    close();
+    return false;
+  }
+  return true;
+#endif
+}
+
+/**
+ * \brief Unmaps the archive.
+ */
+void MappedArchive::close() {
+
+#ifndef _WIN32
+  if (data != nullptr) {
+    munmap(const_cast<char*>(data), size);
+  }
+#endif
+  path.clear();
+  data = nullptr;
+  size = 0;
+  entries.clear();
+}
+
+/**
+ * \brief Returns whether an archive is currently mapped.
+ * \return \c true if the archive is open.
+ */
+bool MappedArchive::is_open() const {
+  return data != nullptr;
+}
+
+/**
+ * \brief Returns the path of the mapped archive.
+ * \return The path, or an empty string if no archive is open.
+ */
+const std::string& MappedArchive::get_path() const {
+  return path;
+}
+
+/**
+ * \brief Returns the number of uncompressed entries found.
+ * \return The number of entries that can be read in place.
+ */
+size_t MappedArchive::get_num_entries() const {
+  return entries.size();
+}
+
+/**
+ * \brief Gives direct access to an uncompressed entry of the archive.
+ *
+ * The memory stays valid until the archive is closed.
+ *
+ * \param[in] name Name of the entry in the archive.
+ * \param[out] data Start of the entry data in memory.
+ * \param[out] size Size of the entry data in bytes.
+ * \return \c false if there is no such entry or if it is compressed.
+ */
+bool MappedArchive::get_entry(const std::string& name, const char*& data, size_t& size) const {
+
+  const auto& it = entries.find(name);
+  if (it == entries.end()) {
+    return false;
+  }
+
+  data = this->data + it->second.offset;
+  size = it->second.size;
+  return true;
+}
+
+/**
+ * \brief Reads the central directory of the zip archive.
+ *
+ * Zip64 archives, encrypted entries and compressed entries are not supported:
+ * they are just not indexed.
+ *
+ * \return \c false if the file is not a valid zip archive.
+ */
+bool MappedArchive::parse_central_directory() {
+
+  if (size < end_of_central_directory_size) {
+    return false;
+  }
+
+  // The end of central directory record is at the end, before a comment.
+  const size_t search_end = size - end_of_central_directory_size;
+  const size_t search_start = search_end > max_comment_size ? search_end - max_comment_size : 0;
+  size_t end_record = search_end + 1;
+  for (size_t i = search_end + 1; i-- > search_start;) {
+    if (read_uint32(data + i) == end_of_central_directory_signature) {
+      end_record = i;
+      break;
+    }
+  }
+  if (end_record > search_end) {
+    return false;
+  }
+
+  const uint16_t num_records = read_uint16(data + end_record + 10);
+  const uint32_t directory_size = read_uint32(data + end_record + 12);
+  const uint32_t directory_offset = read_uint32(data + end_record + 16);
+  if (num_records == 0xFFFF || directory_offset == 0xFFFFFFFF) {
+    // Zip64.
+    return false;
+  }
+  if (static_cast<size_t>(directory_offset) + directory_size > end_record) {
+    return false;
+  }
+
+  size_t position = directory_offset;
+  for (uint16_t i = 0; i < num_records; ++i) {
+
+    if (position + central_directory_header_size > end_record ||
+        read_uint32(data + position) != central_directory_signature) {
+      return false;
+    }
+
+    const uint16_t flags = read_uint16(data + position + 8);
+    const uint16_t method = read_uint16(data + position + 10);
+    const uint32_t compressed_size = read_uint32(data + position + 20);
+    const uint32_t uncompressed_size = read_uint32(data + position + 24);
+    const uint16_t name_length = read_uint16(data + position + 28);
+    const uint16_t extra_length = read_uint16(data + position + 30);
+    const uint16_t comment_length = read_uint16(data + position + 32);
+    const uint32_t local_header_offset = read_uint32(data + position + 42);
+
+    const size_t name_position = position + central_directory_header_size;
+    if (name_position + name_length > end_record) {
+      return false;
+    }
+    const std::string name(data + name_position, name_length);
+    position = name_position + name_length + extra_length + comment_length;
+
+    if (method != method_stored ||
+        (flags & flag_encrypted) != 0 ||
+        compressed_size != uncompressed_size ||
+        name.empty() ||
+        name.back() == '/') {
+      // Compressed, encrypted or directory: not mappable.
+      continue;
+    }
+
+    // The data follows the local header, whose extra field may differ.
+    const size_t local_header = local_header_offset;
+    if (local_header + local_header_size > size ||
+        read_uint32(data + local_header) != local_header_signature) {
+      continue;
+    }
+    const size_t data_offset = local_header + local_header_size +
+        read_uint16(data + local_header + 26) +
+        read_uint16(data + local_header + 28);
+    if (data_offset + uncompressed_size > size) {
+      continue;
+    }
+
+    Entry entry;
+    entry.offset = data_offset;
+    entry.size = uncompressed_size;
+    entries.emplace(name, entry);
+  }
+
+  return true;
+}
+
+}
+
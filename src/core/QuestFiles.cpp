@@ -17,13 +17,22 @@
 #include "solarus/core/Arguments.h"
 #include "solarus/core/CurrentQuest.h"
 #include "solarus/core/Debug.h"
+#include "solarus/core/Logger.h"
+#include "solarus/core/MappedArchive.h"
 #include "solarus/core/QuestFiles.h"
 #include "solarus/core/QuestProperties.h"
 #include "solarus/lua/LuaContext.h"
 #include <physfs.h>
+#include <SDL.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <cstdlib>  // exit(), mkstemp(), tmpnam()
-#include <cstdio>   // remove()
+#include <cstdio>   // remove(), rename()
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>  // close()
 #endif
@@ -61,6 +70,126 @@ std::string quest_write_dir_;
  */
 std::vector<std::string> temporary_files_;
 
+/**
+ * \brief Memory mapping of the data archive, if the quest is an archive.
+ */
+MappedArchive mapped_archive_;
+
+/**
+ * \brief A file write scheduled by data_file_save_async().
+ */
+struct PendingSave {
+  std::string file_name;   /**< File name relative to the quest write directory. */
+  std::string full_path;   /**< Absolute path of the file to write. */
+  std::string buffer;      /**< Content to write. */
+};
+
+std::thread save_thread_;                     /**< Thread that writes pending saves. */
+std::mutex save_mutex_;                       /**< Lock for the pending saves. */
+std::condition_variable save_condition_;      /**< Signals changes of the pending saves. */
+std::deque<PendingSave> pending_saves_;       /**< Saves not finished yet, including the
+                                               * one being written (first element). */
+bool save_thread_stopping_ = false;           /**< Asks the save thread to stop. */
+
+/**
+ * \brief Writes a file to disk and then replaces the destination atomically.
+ *
+ * The content is first written to a temporary file next to the
+ * destination, which is then renamed.
+ * This way, a crash never leaves a truncated file.
+ *
+ * \param save The write to perform.
+ */
+void write_pending_save(const PendingSave& save) {
+
+  const std::string& temporary_path = save.full_path + ".tmp";
+  std::ofstream out(temporary_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out) {
+    Logger::error("Cannot open file '" + temporary_path + "' for writing");
+    return;
+  }
+
+  out.write(save.buffer.data(), save.buffer.size());
+  out.close();
+  if (!out) {
+    Logger::error("Cannot write file '" + temporary_path + "'");
+    std::remove(temporary_path.c_str());
+    return;
+  }
+
+#ifdef _WIN32
+  // rename() does not replace existing files on Windows.
+  std::remove(save.full_path.c_str());
+#endif
+  if (std::rename(temporary_path.c_str(), save.full_path.c_str()) != 0) {
+    Logger::error("Cannot replace file '" + save.full_path + "'");
+    std::remove(temporary_path.c_str());
+  }
+}
+
+/**
+ * \brief Main function of the save thread.
+ *
+ * Writes pending saves in order until stop_save_thread() is called.
+ */
+void run_save_thread() {
+
+  std::unique_lock<std::mutex> lock(save_mutex_);
+  while (true) {
+    save_condition_.wait(lock, [] {
+      return save_thread_stopping_ || !pending_saves_.empty();
+    });
+
+    if (pending_saves_.empty()) {
+      // Stopping and nothing left to write.
+      return;
+    }
+
+    // Keep the save in the queue while writing it
+    // so that readers of this file know they have to wait.
+    const PendingSave& save = pending_saves_.front();
+    lock.unlock();
+    write_pending_save(save);
+    lock.lock();
+
+    pending_saves_.pop_front();
+    save_condition_.notify_all();
+  }
+}
+
+/**
+ * \brief Blocks until there is no pending save of a file.
+ * \param file_name A file name relative to the quest write directory.
+ */
+void wait_pending_save(const std::string& file_name) {
+
+  std::unique_lock<std::mutex> lock(save_mutex_);
+  save_condition_.wait(lock, [&file_name] {
+    return std::none_of(pending_saves_.begin(), pending_saves_.end(),
+        [&file_name](const PendingSave& save) {
+      return save.file_name == file_name;
+    });
+  });
+}
+
+/**
+ * \brief Finishes all pending saves and stops the save thread.
+ */
+void stop_save_thread() {
+
+  if (!save_thread_.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(save_mutex_);
+    save_thread_stopping_ = true;
+  }
+  save_condition_.notify_all();
+  save_thread_.join();
+  save_thread_stopping_ = false;
+}
+
 /**
  * \brief Sets the directory where the engine can write files.
  *
@@ -102,6 +231,165 @@ void set_solarus_write_dir(const std::string& solarus_write_dir) {
   }
 }
 
+/**
+ * \brief Returns the full name of a data file and waits for it to be saved
+ * if it is being written.
+ * \param file_name Name of a data file.
+ * \param language_specific \c true if the file is specific to the current language.
+ * \return The file name relative to the search path.
+ */
+std::string get_data_file_full_name(
+    const std::string& file_name,
+    bool language_specific
+) {
+  if (language_specific) {
+    Debug::check_assertion(!CurrentQuest::get_language().empty(),
+        std::string("Cannot open language-specific file '") + file_name
+        + "': no language was set"
+    );
+    return std::string("languages/") +
+        CurrentQuest::get_language() + "/" + file_name;
+  }
+
+  wait_pending_save(file_name);
+  return file_name;
+}
+
+/**
+ * \brief Finds a data file in the mapped archive.
+ *
+ * Files of the write directory or of a data directory that hide the archive
+ * one are correctly ignored.
+ *
+ * \param[in] full_file_name Name of a data file relative to the search path.
+ * \param[out] data The file content in memory.
+ * \param[out] size Size of the file content.
+ * \return \c true if the file can be read from the mapped archive.
+ */
+bool get_mapped_data_file(
+    const std::string& full_file_name,
+    const char*& data,
+    size_t& size
+) {
+  if (!mapped_archive_.is_open()) {
+    return false;
+  }
+
+  const char* real_dir = PHYSFS_getRealDir(full_file_name.c_str());
+  if (real_dir == nullptr || mapped_archive_.get_path() != real_dir) {
+    return false;
+  }
+
+  return mapped_archive_.get_entry(full_file_name, data, size);
+}
+
+/**
+ * \brief Opens the memory mapping of the data archive if the quest is an archive.
+ */
+void open_mapped_archive() {
+
+  const char* real_dir = PHYSFS_getRealDir("quest.dat");
+  if (real_dir == nullptr) {
+    return;
+  }
+
+  const std::string path = real_dir;
+  if (path.rfind("data.solarus") != path.size() - 12 &&
+      path.rfind("data.solarus.zip") != path.size() - 16) {
+    // Not an archive.
+    return;
+  }
+
+  if (mapped_archive_.open(path)) {
+    std::ostringstream oss;
+    oss << "Data archive mapped in memory: " << mapped_archive_.get_num_entries()
+        << " uncompressed files";
+    Logger::info(oss.str());
+  }
+}
+
+/**
+ * \brief Returns the PhysFS file of an SDL_RWops created by data_file_open_rw().
+ * \param rw The SDL_RWops.
+ * \return The PhysFS file.
+ */
+PHYSFS_File* get_rw_physfs_file(SDL_RWops* rw) {
+  return static_cast<PHYSFS_File*>(rw->hidden.unknown.data1);
+}
+
+/**
+ * \brief SDL_RWops callback that returns the size of a PhysFS file.
+ */
+Sint64 physfs_rw_size(SDL_RWops* rw) {
+  return PHYSFS_fileLength(get_rw_physfs_file(rw));
+}
+
+/**
+ * \brief SDL_RWops callback that seeks in a PhysFS file.
+ */
+Sint64 physfs_rw_seek(SDL_RWops* rw, Sint64 offset, int whence) {
+
+  PHYSFS_File* file = get_rw_physfs_file(rw);
+  Sint64 position = 0;
+  switch (whence) {
+
+  case RW_SEEK_SET:
+    position = offset;
+    break;
+
+  case RW_SEEK_CUR:
+    position = PHYSFS_tell(file) + offset;
+    break;
+
+  case RW_SEEK_END:
+    position = PHYSFS_fileLength(file) + offset;
+    break;
+
+  default:
+    return -1;
+  }
+
+  if (position < 0 || !PHYSFS_seek(file, static_cast<PHYSFS_uint64>(position))) {
+    return -1;
+  }
+  return position;
+}
+
+/**
+ * \brief SDL_RWops callback that reads from a PhysFS file.
+ */
+size_t physfs_rw_read(SDL_RWops* rw, void* ptr, size_t size, size_t max_num) {
+
+  if (size == 0 || max_num == 0) {
+    return 0;
+  }
+
+  const PHYSFS_sint64 num_read = PHYSFS_read(
+      get_rw_physfs_file(rw),
+      ptr,
+      static_cast<PHYSFS_uint32>(size),
+      static_cast<PHYSFS_uint32>(max_num)
+  );
+  return num_read < 0 ? 0 : static_cast<size_t>(num_read);
+}
+
+/**
+ * \brief SDL_RWops callback for writing: data files are read-only.
+ */
+size_t physfs_rw_write(SDL_RWops* /* rw */, const void* /* ptr */, size_t /* size */, size_t /* num */) {
+  return 0;
+}
+
+/**
+ * \brief SDL_RWops callback that closes a PhysFS file.
+ */
+int physfs_rw_close(SDL_RWops* rw) {
+
+  const int success = PHYSFS_close(get_rw_physfs_file(rw));
+  SDL_FreeRW(rw);
+  return success ? 0 : -1;
+}
+
 } // Anonymous namespace
 
 /**
@@ -148,6 +436,8 @@ SOLARUS_API bool open_quest(const std::string& program_name, const std::string&
     return false;
   }
 
+  open_mapped_archive();
+
   // Set the quest write directory.
   CurrentQuest::initialize();
   set_quest_write_dir(CurrentQuest::get_properties().get_quest_write_dir());
@@ -166,7 +456,9 @@ SOLARUS_API void close_quest() {
 
   CurrentQuest::quit();
 
+  stop_save_thread();
   remove_temporary_files();
+  mapped_archive_.close();
 
   quest_path_ = "";
   solarus_write_dir_ = "";
@@ -264,6 +556,7 @@ SOLARUS_API bool data_file_exists(const std::string& file_name,
   }
   else {
     full_file_name = file_name;
+    wait_pending_save(file_name);
   }
 
   return PHYSFS_exists(full_file_name.c_str()) && !PHYSFS_isDirectory(full_file_name.c_str());
@@ -279,17 +572,13 @@ SOLARUS_API std::string data_file_read(
     const std::string& file_name,
     bool language_specific
 ) {
-  std::string full_file_name;
-  if (language_specific) {
-    Debug::check_assertion(!CurrentQuest::get_language().empty(),
-        std::string("Cannot open language-specific file '") + file_name
-        + "': no language was set"
-    );
-    full_file_name = std::string("languages/") +
-        CurrentQuest::get_language() + "/" + file_name;
-  }
-  else {
-    full_file_name = file_name;
+  const std::string& full_file_name = get_data_file_full_name(file_name, language_specific);
+
+  // Uncompressed files of the archive are already in memory.
+  const char* mapped_data = nullptr;
+  size_t mapped_size = 0;
+  if (get_mapped_data_file(full_file_name, mapped_data, mapped_size)) {
+    return std::string(mapped_data, mapped_size);
   }
 
   // open the file
@@ -311,6 +600,52 @@ SOLARUS_API std::string data_file_read(
   return std::string(buffer.data(), size);
 }
 
+/**
+ * \brief Opens a data file for reading it progressively.
+ *
+ * Unlike data_file_read(), the file is not loaded entirely into memory:
+ * it is read from the disk (or decompressed from the archive) as needed.
+ * Uncompressed files of a data archive are directly read from its memory
+ * mapping, without any copy.
+ *
+ * \param file_name Name of the file to open.
+ * \param language_specific \c true if the file is specific to the current language.
+ * \return An SDL_RWops to read the file, or nullptr if the file cannot be
+ * opened. Close it with SDL_RWclose() when you are done.
+ */
+SOLARUS_API SDL_RWops* data_file_open_rw(
+    const std::string& file_name,
+    bool language_specific
+) {
+  const std::string& full_file_name = get_data_file_full_name(file_name, language_specific);
+
+  const char* mapped_data = nullptr;
+  size_t mapped_size = 0;
+  if (get_mapped_data_file(full_file_name, mapped_data, mapped_size)) {
+    return SDL_RWFromConstMem(mapped_data, static_cast<int>(mapped_size));
+  }
+
+  PHYSFS_File* file = PHYSFS_openRead(full_file_name.c_str());
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  SDL_RWops* rw = SDL_AllocRW();
+  if (rw == nullptr) {
+    PHYSFS_close(file);
+    return nullptr;
+  }
+  rw->size = physfs_rw_size;
+  rw->seek = physfs_rw_seek;
+  rw->read = physfs_rw_read;
+  rw->write = physfs_rw_write;
+  rw->close = physfs_rw_close;
+  rw->type = SDL_RWOPS_UNKNOWN;
+  rw->hidden.unknown.data1 = file;
+  rw->hidden.unknown.data2 = nullptr;
+  return rw;
+}
+
 /**
  * \brief Saves a buffer into a data file.
  * \param file_name Name of the file to write, relative to Solarus write directory.
@@ -321,6 +656,8 @@ SOLARUS_API void data_file_save(
     const std::string& file_name,
     const std::string& buffer
 ) {
+  wait_pending_save(file_name);
+
   // open the file to write
   PHYSFS_file* file = PHYSFS_openWrite(file_name.c_str());
   if (file == nullptr) {
@@ -337,6 +674,42 @@ SOLARUS_API void data_file_save(
   PHYSFS_close(file);
 }
 
+/**
+ * \brief Saves a buffer into a data file from a separate thread.
+ *
+ * The file is written to a temporary file first and then renamed,
+ * so the previous content stays intact if the program stops in the middle.
+ * Other functions of this namespace that access the same file wait for the
+ * write to be finished, and pending writes are finished when the quest is
+ * closed.
+ *
+ * \param file_name Name of the file to write, relative to the quest write directory.
+ * \param buffer The buffer to save.
+ */
+SOLARUS_API void data_file_save_async(
+    const std::string& file_name,
+    std::string buffer
+) {
+  Debug::check_assertion(!get_quest_write_dir().empty(),
+      "Cannot save file '" + file_name + "': no quest write directory was set"
+  );
+
+  PendingSave save;
+  save.file_name = file_name;
+  save.full_path = get_full_quest_write_dir() + "/" + file_name;
+  save.buffer = std::move(buffer);
+
+  {
+    std::lock_guard<std::mutex> lock(save_mutex_);
+    pending_saves_.push_back(std::move(save));
+  }
+  save_condition_.notify_all();
+
+  if (!save_thread_.joinable()) {
+    save_thread_ = std::thread(run_save_thread);
+  }
+}
+
 /**
  * \brief Removes a file from the write directory.
  * \param file_name Name of the file to delete, relative to the Solarus
@@ -345,6 +718,8 @@ SOLARUS_API void data_file_save(
  */
 SOLARUS_API bool data_file_delete(const std::string& file_name) {
 
+  wait_pending_save(file_name);
+
   if (!PHYSFS_delete(file_name.c_str())) {
     return false;
   }
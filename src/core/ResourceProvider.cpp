@@ -14,10 +14,24 @@
  * You should have received a copy of the GNU General Public License along
  * with this program. If not, see <http://www.gnu.org/licenses/>.
  */
+#include "solarus/core/CurrentQuest.h"
+#include "solarus/core/Debug.h"
 #include "solarus/core/ResourceProvider.h"
+#include <chrono>
+#include <exception>
+#include <utility>
 
 namespace Solarus {
 
+namespace {
+
+/**
+ * \brief Maximum number of map data objects kept in the cache.
+ */
+constexpr size_t max_map_data_cache_size = 8;
+
+}
+
 /**
  * \brief Creates a resource provider.
  */
@@ -45,6 +59,202 @@ const Tileset& ResourceProvider::get_tileset(const std::string& tileset_id) {
   return tileset;
 }
 
+/**
+ * \brief Provides the data of the map with the given id.
+ *
+ * If the map is being preloaded, waits for the preloading to finish.
+ * Stops the program with an error message if the map data file cannot be
+ * loaded.
+ *
+ * \param map_id A map id.
+ * \return The corresponding map data.
+ */
+std::shared_ptr<const MapData> ResourceProvider::get_map_data(const std::string& map_id) {
+
+  finish_map_preloading(map_id);
+
+  std::shared_ptr<const MapData> data = load_map_data(map_id);
+  if (data == nullptr) {
+    Debug::die("Failed to load map data file 'maps/" + map_id + ".dat'");
+  }
+  return data;
+}
+
+/**
+ * \brief Starts loading in background the data and the tileset of a map
+ * that is likely to be started soon.
+ *
+ * Does nothing if the map is already loaded or being loaded.
+ * Errors are ignored here: they will be reported when the map is actually
+ * started.
+ *
+ * \param map_id A map id.
+ */
+void ResourceProvider::preload_map(const std::string& map_id) {
+
+  if (map_data_cache.find(map_id) != map_data_cache.end() ||
+      map_preloads.find(map_id) != map_preloads.end()) {
+    return;
+  }
+
+  if (!CurrentQuest::resource_exists(ResourceType::MAP, map_id)) {
+    return;
+  }
+
+  std::set<std::string> loaded_tileset_ids;
+  for (const auto& kvp : tileset_cache) {
+    loaded_tileset_ids.insert(kvp.first);
+  }
+  map_preloads.emplace(map_id, std::async(
+      std::launch::async,
+      &ResourceProvider::load_map_in_background,
+      map_id,
+      std::move(loaded_tileset_ids)
+  ));
+}
+
+/**
+ * \brief Stores in the cache the maps whose background loading is finished.
+ *
+ * This function should be called once per cycle.
+ */
+void ResourceProvider::update() {
+
+  auto it = map_preloads.begin();
+  while (it != map_preloads.end()) {
+    const std::string map_id = it->first;
+    const bool ready = it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    ++it;
+    if (ready) {
+      finish_map_preloading(map_id);
+    }
+  }
+}
+
+/**
+ * \brief Loads the data and the tileset of a map.
+ *
+ * This function runs in a separate thread: it only accesses quest files
+ * and its own objects.
+ * Tilesets only use software surfaces, so they can be loaded from any thread.
+ *
+ * \param map_id A map id.
+ * \param loaded_tileset_ids Tilesets that don't need to be loaded.
+ * \return The map data and its tileset if it had to be loaded.
+ * The map data is nullptr in case of error.
+ */
+ResourceProvider::PreloadedMap ResourceProvider::load_map_in_background(
+    const std::string& map_id,
+    const std::set<std::string>& loaded_tileset_ids
+) {
+  PreloadedMap preloaded_map;
+  try {
+    std::shared_ptr<MapData> data = std::make_shared<MapData>();
+    const std::string& file_name = "maps/" + map_id + ".dat";
+    if (!data->import_from_quest_file(file_name)) {
+      return preloaded_map;
+    }
+
+    const std::string& tileset_id = data->get_tileset_id();
+    if (loaded_tileset_ids.find(tileset_id) == loaded_tileset_ids.end() &&
+        CurrentQuest::resource_exists(ResourceType::TILESET, tileset_id)) {
+      preloaded_map.tileset = std::unique_ptr<Tileset>(new Tileset(tileset_id));
+      preloaded_map.tileset->load();
+    }
+    preloaded_map.map_data = data;
+  }
+  catch (const std::exception&) {
+    // The error will be reported again when the map is started.
+    preloaded_map = PreloadedMap();
+  }
+  return preloaded_map;
+}
+
+/**
+ * \brief Stores in the cache the result of the preloading of a map,
+ * waiting for it if necessary.
+ *
+ * Does nothing if the map is not being preloaded.
+ *
+ * \param map_id A map id.
+ */
+void ResourceProvider::finish_map_preloading(const std::string& map_id) {
+
+  const auto& it = map_preloads.find(map_id);
+  if (it == map_preloads.end()) {
+    return;
+  }
+
+  PreloadedMap preloaded_map = it->second.get();
+  map_preloads.erase(it);
+
+  if (preloaded_map.map_data != nullptr &&
+      map_data_cache.find(map_id) == map_data_cache.end()) {
+    add_map_data(map_id, preloaded_map.map_data);
+  }
+
+  if (preloaded_map.tileset != nullptr) {
+    // Keep the tileset already loaded in the meantime if any.
+    const std::string tileset_id = preloaded_map.tileset->get_id();
+    tileset_cache.emplace(tileset_id, std::move(preloaded_map.tileset));
+  }
+}
+
+/**
+ * \brief Waits for all maps being preloaded and stores them in the cache.
+ */
+void ResourceProvider::finish_all_map_preloading() {
+
+  while (!map_preloads.empty()) {
+    finish_map_preloading(map_preloads.begin()->first);
+  }
+}
+
+/**
+ * \brief Returns the data of a map from the cache, loading it if necessary.
+ *
+ * \param map_id A map id.
+ * \return The corresponding map data, or nullptr if it could not be loaded.
+ */
+std::shared_ptr<const MapData> ResourceProvider::load_map_data(const std::string& map_id) {
+
+  const auto& it = map_data_cache.find(map_id);
+  if (it != map_data_cache.end()) {
+    map_data_order.remove(map_id);
+    map_data_order.push_front(map_id);
+    return it->second;
+  }
+
+  std::shared_ptr<MapData> data = std::make_shared<MapData>();
+  const std::string& file_name = "maps/" + map_id + ".dat";
+  if (!data->import_from_quest_file(file_name)) {
+    return nullptr;
+  }
+
+  add_map_data(map_id, data);
+  return data;
+}
+
+/**
+ * \brief Adds map data to the cache.
+ *
+ * The least recently used map data is removed from the cache if it is full.
+ *
+ * \param map_id Id of a map that is not in the cache.
+ * \param data The data of this map.
+ */
+void ResourceProvider::add_map_data(
+    const std::string& map_id,
+    const std::shared_ptr<const MapData>& data
+) {
+  map_data_cache[map_id] = data;
+  map_data_order.push_front(map_id);
+  while (map_data_order.size() > max_map_data_cache_size) {
+    map_data_cache.erase(map_data_order.back());
+    map_data_order.pop_back();
+  }
+}
+
 /**
  * \brief Notifies the resource provider that cached data (if any) is no longer valid.
  *
@@ -60,9 +270,17 @@ void ResourceProvider::invalidate_resource_element(
   switch (resource_type) {
 
   case ResourceType::TILESET:
+    // A map being preloaded may have read the old tileset.
+    finish_all_map_preloading();
     tileset_cache.erase(element_id);
     break;
 
+  case ResourceType::MAP:
+    finish_map_preloading(element_id);
+    map_data_cache.erase(element_id);
+    map_data_order.remove(element_id);
+    break;
+
   default:
     break;
   }
@@ -23,58 +23,209 @@
 #include "solarus/lua/LuaContext.h"
 #include "solarus/lua/LuaTools.h"
 #include <lua.hpp>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 namespace Solarus {
 
-const int Savegame::SAVEGAME_VERSION = 2;
+const std::string EnumInfoTraits<SavegameFormat>::pretty_name = "savegame format";
+
+const EnumInfo<SavegameFormat>::names_type EnumInfoTraits<SavegameFormat>::names = {
+    { SavegameFormat::TEXT, "text" },
+    { SavegameFormat::BINARY, "binary" }
+};
+
+namespace {
+
+/**
+ * \brief Signature at the beginning of binary savegame files.
+ *
+ * It starts with a null character so that it can never be confused
+ * with a Lua text savegame or with the old format of Solarus 0.9.
+ */
+const char binary_magic[] = { '\0', 'S', 'O', 'L', 'S', 'A', 'V', '\n' };
+
+/**
+ * \brief Type tags of values in binary savegames.
+ */
+enum BinaryValueType : uint8_t {
+  BINARY_VALUE_STRING = 0,
+  BINARY_VALUE_INTEGER = 1,
+  BINARY_VALUE_BOOLEAN = 2
+};
 
-const std::string Savegame::KEY_SAVEGAME_VERSION = "_version";         /**< Format of this savegame file. */
-const std::string Savegame::KEY_STARTING_MAP = "_starting_map";        /**< Map id where to start the savegame. */
-const std::string Savegame::KEY_STARTING_POINT = "_starting_point";    /**< Destination name on the starting map. */
-const std::string Savegame::KEY_KEYBOARD_ACTION = "_keyboard_action";  /**< Keyboard key mapped to the action command. */
-const std::string Savegame::KEY_KEYBOARD_ATTACK = "_keyboard_attack";  /**< Keyboard key mapped to the attack command. */
-const std::string Savegame::KEY_KEYBOARD_ITEM_1 = "_keyboard_item_1";  /**< Keyboard key mapped to the item 1 command. */
-const std::string Savegame::KEY_KEYBOARD_ITEM_2 = "_keyboard_item_2";  /**< Keyboard key mapped to the item 2 command. */
-const std::string Savegame::KEY_KEYBOARD_PAUSE = "_keyboard_pause";    /**< Keyboard key mapped to the pause command. */
-const std::string Savegame::KEY_KEYBOARD_RIGHT = "_keyboard_right";    /**< Keyboard key mapped to the right command. */
-const std::string Savegame::KEY_KEYBOARD_UP = "_keyboard_up";          /**< Keyboard key mapped to the up command. */
-const std::string Savegame::KEY_KEYBOARD_LEFT = "_keyboard_left";      /**< Keyboard key mapped to the left command. */
-const std::string Savegame::KEY_KEYBOARD_DOWN = "_keyboard_down";      /**< Keyboard key mapped to the down command. */
-const std::string Savegame::KEY_JOYPAD_ACTION = "_joypad_action";      /**< Joypad string mapped to the action command. */
-const std::string Savegame::KEY_JOYPAD_ATTACK = "_joypad_attack";      /**< Joypad string mapped to the attack command. */
-const std::string Savegame::KEY_JOYPAD_ITEM_1 = "_joypad_item_1";      /**< Joypad string mapped to the item 1 command. */
-const std::string Savegame::KEY_JOYPAD_ITEM_2 = "_joypad_item_2";      /**< Joypad string mapped to the item 2 command. */
-const std::string Savegame::KEY_JOYPAD_PAUSE = "_joypad_pause";        /**< Joypad string mapped to the pause command. */
-const std::string Savegame::KEY_JOYPAD_RIGHT = "_joypad_right";        /**< Joypad string mapped to the right command. */
-const std::string Savegame::KEY_JOYPAD_UP = "_joypad_up_key";          /**< Joypad string mapped to the up command. */
-const std::string Savegame::KEY_JOYPAD_LEFT = "_joypad_left_key";      /**< Joypad string mapped to the left command. */
-const std::string Savegame::KEY_JOYPAD_DOWN = "_joypad_down_key";      /**< Joypad string mapped to the down command. */
-const std::string Savegame::KEY_CURRENT_LIFE = "_current_life";        /**< Number of life points. */
-const std::string Savegame::KEY_CURRENT_MONEY = "_current_money";      /**< Amount of money. */
-const std::string Savegame::KEY_CURRENT_MAGIC = "_current_magic";      /**< Number of magic points. */
-const std::string Savegame::KEY_MAX_LIFE = "_max_life";                /**< Maximum allowed life points. */
-const std::string Savegame::KEY_MAX_MONEY = "_max_money";              /**< Maximum allowed money. */
-const std::string Savegame::KEY_MAX_MAGIC = "_max_magic";              /**< Maximum allowed magic points. */
-const std::string Savegame::KEY_ITEM_SLOT_1 = "_item_slot_1";          /**< Name of the equipment item in slot 1. */
-const std::string Savegame::KEY_ITEM_SLOT_2 = "_item_slot_2";          /**< Name of the equipment item in slot 2. */
-const std::string Savegame::KEY_ABILITY_TUNIC = "_ability_tunic";      /**< Resistance level. */
-const std::string Savegame::KEY_ABILITY_SWORD = "_ability_sword";      /**< Attack level. */
-const std::string Savegame::KEY_ABILITY_SWORD_KNOWLEDGE =
-    "_ability_sword_knowledge";                                        /**< Super spin attack ability level. */
-const std::string Savegame::KEY_ABILITY_SHIELD = "_ability_shield";    /**< Protection level. */
-const std::string Savegame::KEY_ABILITY_LIFT = "_ability_lift";        /**< Lift level. */
-const std::string Savegame::KEY_ABILITY_SWIM = "_ability_swim";        /**< Swim level. */
-const std::string Savegame::KEY_ABILITY_JUMP_OVER_WATER =
-    "_ability_jump_over_water";                                        /**< Jump over water level. */
-const std::string Savegame::KEY_ABILITY_RUN = "_ability_run";          /**< Run level. */
-const std::string Savegame::KEY_ABILITY_PUSH = "_ability_push";        /**< Push level. */
-const std::string Savegame::KEY_ABILITY_GRAB = "_ability_grab";        /**< Grab level. */
-const std::string Savegame::KEY_ABILITY_PULL = "_ability_pull";        /**< Pull level. */
-const std::string Savegame::KEY_ABILITY_DETECT_WEAK_WALLS =
-    "_ability_detect_weak_walls";                                      /**< Weak walls detection level. */
-const std::string Savegame::KEY_ABILITY_GET_BACK_FROM_DEATH =
-    "_ability_get_back_from_death";                                    /**< Resurrection ability level. */
+/**
+ * \brief Returns whether a buffer holds a binary savegame.
+ * \param buffer Content of a savegame file.
+ * \return \c true if the buffer starts with the binary signature.
+ */
+bool is_binary_savegame(const std::string& buffer) {
+
+  return buffer.size() >= sizeof(binary_magic) &&
+      std::memcmp(buffer.data(), binary_magic, sizeof(binary_magic)) == 0;
+}
+
+/**
+ * \brief Returns the key of a name of value about to be stored.
+ *
+ * The name is validated before being interned,
+ * so that invalid names never end up in the table of keys.
+ *
+ * \param name Name of a savegame variable.
+ * \return The key of this name.
+ */
+SavegameKey get_key_to_set(const std::string& name) {
+
+  Debug::check_assertion(LuaTools::is_valid_lua_identifier(name),
+      std::string("Savegame variable '") + name + "' is not a valid key");
+  return SavegameKey(name);
+}
+
+/**
+ * \brief Computes the FNV-1a hash of some bytes.
+ * \param data The bytes to hash.
+ * \param size Number of bytes.
+ * \return The 32-bit hash.
+ */
+uint32_t compute_checksum(const char* data, size_t size) {
+
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * \brief Appends a 32-bit unsigned integer in little-endian order.
+ * \param out The buffer to write to.
+ * \param value The value to append.
+ */
+void write_uint32(std::string& out, uint32_t value) {
+
+  out.push_back(static_cast<char>(value & 0xFF));
+  out.push_back(static_cast<char>((value >> 8) & 0xFF));
+  out.push_back(static_cast<char>((value >> 16) & 0xFF));
+  out.push_back(static_cast<char>((value >> 24) & 0xFF));
+}
+
+/**
+ * \brief Reads a 32-bit unsigned integer stored in little-endian order.
+ * \param buffer The buffer to read from.
+ * \param position Index of the first byte. There must be 4 bytes available.
+ * \return The value read.
+ */
+uint32_t read_uint32_at(const std::string& buffer, size_t position) {
+
+  return static_cast<uint32_t>(static_cast<uint8_t>(buffer[position])) |
+      (static_cast<uint32_t>(static_cast<uint8_t>(buffer[position + 1])) << 8) |
+      (static_cast<uint32_t>(static_cast<uint8_t>(buffer[position + 2])) << 16) |
+      (static_cast<uint32_t>(static_cast<uint8_t>(buffer[position + 3])) << 24);
+}
+
+/**
+ * \brief Sequential reader of a binary savegame buffer with bound checks.
+ */
+class BinaryReader {
+
+  public:
+
+    BinaryReader(const std::string& buffer, size_t size):
+      buffer(buffer),
+      size(size),
+      position(sizeof(binary_magic)) {
+    }
+
+    bool read_uint8(uint8_t& value) {
+      if (position + 1 > size) {
+        return false;
+      }
+      value = static_cast<uint8_t>(buffer[position]);
+      ++position;
+      return true;
+    }
+
+    bool read_uint32(uint32_t& value) {
+      if (position + 4 > size) {
+        return false;
+      }
+      value = read_uint32_at(buffer, position);
+      position += 4;
+      return true;
+    }
+
+    bool read_string(std::string& value) {
+      uint32_t length = 0;
+      if (!read_uint32(length) || length > size - position) {
+        return false;
+      }
+      value.assign(buffer, position, length);
+      position += length;
+      return true;
+    }
+
+  private:
+
+    const std::string& buffer;
+    const size_t size;         /**< Number of bytes to read, excluding the checksum. */
+    size_t position;
+};
+
+}  // Anonymous namespace.
+
+const int Savegame::SAVEGAME_VERSION = 2;
+const int Savegame::BINARY_FORMAT_VERSION = 1;
+
+const SavegameKey Savegame::KEY_SAVEGAME_VERSION("_version");          /**< Format of this savegame file. */
+const SavegameKey Savegame::KEY_STARTING_MAP("_starting_map");         /**< Map id where to start the savegame. */
+const SavegameKey Savegame::KEY_STARTING_POINT("_starting_point");     /**< Destination name on the starting map. */
+const SavegameKey Savegame::KEY_KEYBOARD_ACTION("_keyboard_action");   /**< Keyboard key mapped to the action command. */
+const SavegameKey Savegame::KEY_KEYBOARD_ATTACK("_keyboard_attack");   /**< Keyboard key mapped to the attack command. */
+const SavegameKey Savegame::KEY_KEYBOARD_ITEM_1("_keyboard_item_1");   /**< Keyboard key mapped to the item 1 command. */
+const SavegameKey Savegame::KEY_KEYBOARD_ITEM_2("_keyboard_item_2");   /**< Keyboard key mapped to the item 2 command. */
+const SavegameKey Savegame::KEY_KEYBOARD_PAUSE("_keyboard_pause");     /**< Keyboard key mapped to the pause command. */
+const SavegameKey Savegame::KEY_KEYBOARD_RIGHT("_keyboard_right");     /**< Keyboard key mapped to the right command. */
+const SavegameKey Savegame::KEY_KEYBOARD_UP("_keyboard_up");           /**< Keyboard key mapped to the up command. */
+const SavegameKey Savegame::KEY_KEYBOARD_LEFT("_keyboard_left");       /**< Keyboard key mapped to the left command. */
+const SavegameKey Savegame::KEY_KEYBOARD_DOWN("_keyboard_down");       /**< Keyboard key mapped to the down command. */
+const SavegameKey Savegame::KEY_JOYPAD_ACTION("_joypad_action");       /**< Joypad string mapped to the action command. */
+const SavegameKey Savegame::KEY_JOYPAD_ATTACK("_joypad_attack");       /**< Joypad string mapped to the attack command. */
+const SavegameKey Savegame::KEY_JOYPAD_ITEM_1("_joypad_item_1");       /**< Joypad string mapped to the item 1 command. */
+const SavegameKey Savegame::KEY_JOYPAD_ITEM_2("_joypad_item_2");       /**< Joypad string mapped to the item 2 command. */
+const SavegameKey Savegame::KEY_JOYPAD_PAUSE("_joypad_pause");         /**< Joypad string mapped to the pause command. */
+const SavegameKey Savegame::KEY_JOYPAD_RIGHT("_joypad_right");         /**< Joypad string mapped to the right command. */
+const SavegameKey Savegame::KEY_JOYPAD_UP("_joypad_up_key");           /**< Joypad string mapped to the up command. */
+const SavegameKey Savegame::KEY_JOYPAD_LEFT("_joypad_left_key");       /**< Joypad string mapped to the left command. */
+const SavegameKey Savegame::KEY_JOYPAD_DOWN("_joypad_down_key");       /**< Joypad string mapped to the down command. */
+const SavegameKey Savegame::KEY_CURRENT_LIFE("_current_life");         /**< Number of life points. */
+const SavegameKey Savegame::KEY_CURRENT_MONEY("_current_money");       /**< Amount of money. */
+const SavegameKey Savegame::KEY_CURRENT_MAGIC("_current_magic");       /**< Number of magic points. */
+const SavegameKey Savegame::KEY_MAX_LIFE("_max_life");                 /**< Maximum allowed life points. */
+const SavegameKey Savegame::KEY_MAX_MONEY("_max_money");               /**< Maximum allowed money. */
+const SavegameKey Savegame::KEY_MAX_MAGIC("_max_magic");               /**< Maximum allowed magic points. */
+const SavegameKey Savegame::KEY_ITEM_SLOT_1("_item_slot_1");           /**< Name of the equipment item in slot 1. */
+const SavegameKey Savegame::KEY_ITEM_SLOT_2("_item_slot_2");           /**< Name of the equipment item in slot 2. */
+const SavegameKey Savegame::KEY_ABILITY_TUNIC("_ability_tunic");       /**< Resistance level. */
+const SavegameKey Savegame::KEY_ABILITY_SWORD("_ability_sword");       /**< Attack level. */
+const SavegameKey Savegame::KEY_ABILITY_SWORD_KNOWLEDGE(
+    "_ability_sword_knowledge");                                       /**< Super spin attack ability level. */
+const SavegameKey Savegame::KEY_ABILITY_SHIELD("_ability_shield");     /**< Protection level. */
+const SavegameKey Savegame::KEY_ABILITY_LIFT("_ability_lift");         /**< Lift level. */
+const SavegameKey Savegame::KEY_ABILITY_SWIM("_ability_swim");         /**< Swim level. */
+const SavegameKey Savegame::KEY_ABILITY_JUMP_OVER_WATER(
+    "_ability_jump_over_water");                                       /**< Jump over water level. */
+const SavegameKey Savegame::KEY_ABILITY_RUN("_ability_run");           /**< Run level. */
+const SavegameKey Savegame::KEY_ABILITY_PUSH("_ability_push");         /**< Push level. */
+const SavegameKey Savegame::KEY_ABILITY_GRAB("_ability_grab");         /**< Grab level. */
+const SavegameKey Savegame::KEY_ABILITY_PULL("_ability_pull");         /**< Pull level. */
+const SavegameKey Savegame::KEY_ABILITY_DETECT_WEAK_WALLS(
+    "_ability_detect_weak_walls");                                     /**< Weak walls detection level. */
+const SavegameKey Savegame::KEY_ABILITY_GET_BACK_FROM_DEATH(
+    "_ability_get_back_from_death");                                   /**< Resurrection ability level. */
 
 /**
  * \brief Creates a savegame with a specified file name, existing or not.
@@ -86,6 +237,7 @@ Savegame::Savegame(MainLoop& main_loop, const std::string& file_name):
   ExportableToLua(),
   empty(true),
   file_name(file_name),
+  format(SavegameFormat::TEXT),
   main_loop(main_loop),
   equipment(*this),
   game(nullptr) {
@@ -223,9 +375,17 @@ void Savegame::post_process_existing_savegame() {
  */
 void Savegame::import_from_file() {
 
+  const std::string& buffer = QuestFiles::data_file_read(file_name);
+  if (is_binary_savegame(buffer)) {
+    format = SavegameFormat::BINARY;
+    import_from_binary(buffer);
+    post_process_existing_savegame();
+    return;
+  }
+
   // Try to parse as Lua first.
+  format = SavegameFormat::TEXT;
   lua_State* l = luaL_newstate();
-  const std::string& buffer = QuestFiles::data_file_read(file_name);
   const int load_result = luaL_loadbuffer(l, buffer.data(), buffer.size(), file_name.c_str());
 
   // Call the Lua savegame file.
@@ -267,6 +427,96 @@ void Savegame::import_from_file() {
   post_process_existing_savegame();
 }
 
+/**
+ * \brief Imports the savegame data from the content of a binary file.
+ *
+ * The binary format is:
+ * - the 8-byte signature,
+ * - the format version (32-bit),
+ * - the number of distinct strings (32-bit), followed by each string
+ *   (32-bit length and bytes): keys and string values are interned there,
+ * - the number of values (32-bit), followed by each value:
+ *   index of its key in the string table (32-bit), type (8-bit) and data
+ *   (32-bit: integer, boolean or index of the string in the string table),
+ * - the FNV-1a checksum of everything before it (32-bit).
+ *
+ * All integers are little-endian.
+ *
+ * \param buffer Content of the file.
+ */
+void Savegame::import_from_binary(const std::string& buffer) {
+
+  const std::string error_prefix = "Failed to load binary savegame file '" + file_name + "': ";
+  if (buffer.size() < sizeof(binary_magic) + 4) {
+    Debug::die(error_prefix + "file too short");
+  }
+
+  const size_t data_size = buffer.size() - 4;
+  if (read_uint32_at(buffer, data_size) != compute_checksum(buffer.data(), data_size)) {
+    Debug::die(error_prefix + "corrupted file (wrong checksum)");
+  }
+
+  BinaryReader reader(buffer, data_size);
+  uint32_t version = 0;
+  if (!reader.read_uint32(version)) {
+    Debug::die(error_prefix + "missing format version");
+  }
+  if (version == 0 || version > static_cast<uint32_t>(BINARY_FORMAT_VERSION)) {
+    std::ostringstream oss;
+    oss << error_prefix << "unsupported binary format version " << version;
+    Debug::die(oss.str());
+  }
+
+  uint32_t num_strings = 0;
+  if (!reader.read_uint32(num_strings) || num_strings > data_size) {
+    Debug::die(error_prefix + "invalid string table");
+  }
+  std::vector<std::string> strings(num_strings);
+  for (std::string& string : strings) {
+    if (!reader.read_string(string)) {
+      Debug::die(error_prefix + "invalid string table");
+    }
+  }
+
+  uint32_t num_values = 0;
+  if (!reader.read_uint32(num_values)) {
+    Debug::die(error_prefix + "invalid value count");
+  }
+  for (uint32_t i = 0; i < num_values; ++i) {
+    uint32_t key_index = 0;
+    uint8_t type = 0;
+    uint32_t data = 0;
+    if (!reader.read_uint32(key_index) ||
+        !reader.read_uint8(type) ||
+        !reader.read_uint32(data) ||
+        key_index >= num_strings) {
+      Debug::die(error_prefix + "invalid value");
+    }
+
+    const std::string& key = strings[key_index];
+    switch (type) {
+
+    case BINARY_VALUE_STRING:
+      if (data >= num_strings) {
+        Debug::die(error_prefix + "invalid string value for '" + key + "'");
+      }
+      set_string(key, strings[data]);
+      break;
+
+    case BINARY_VALUE_INTEGER:
+      set_integer(key, static_cast<int>(static_cast<int32_t>(data)));
+      break;
+
+    case BINARY_VALUE_BOOLEAN:
+      set_boolean(key, data != 0);
+      break;
+
+    default:
+      Debug::die(error_prefix + "invalid type for '" + key + "'");
+    }
+  }
+}
+
 /**
  * \brief __newindex function of the environment of the savegame file.
  *
@@ -309,14 +559,35 @@ int Savegame::l_newindex(lua_State* l) {
 
 /**
  * \brief Saves the data into a file.
+ *
+ * Text savegames are written immediately.
+ * Binary savegames are written from a separate thread.
  */
 void Savegame::save() {
 
+  if (format == SavegameFormat::BINARY) {
+    QuestFiles::data_file_save_async(file_name, export_to_binary());
+  }
+  else {
+    QuestFiles::data_file_save(file_name, export_to_text());
+  }
+  empty = false;
+}
+
+/**
+ * \brief Encodes the data as a Lua text savegame.
+ * \return The content of the file.
+ */
+std::string Savegame::export_to_text() const {
+
   std::ostringstream oss;
-  for (const auto& kvp: saved_values) {
-    const std::string& key = kvp.first;
-    oss << key << " = ";
-    const SavedValue& value = kvp.second;
+  for (const SavegameKey& key : get_sorted_keys()) {
+    const SavedValue& value = saved_values.at(key.get_index());
+    if (value.type == SavedValue::VALUE_UNSET) {
+      continue;
+    }
+
+    oss << key.get_name() << " = ";
     if (value.type == SavedValue::VALUE_BOOLEAN) {
       oss << (value.int_data ? "true" : "false");
     }
@@ -329,9 +600,77 @@ void Savegame::save() {
     oss << "\n";
   }
 
-  const std::string& text = oss.str();
-  QuestFiles::data_file_save(file_name, text);
-  empty = false;
+  return oss.str();
+}
+
+/**
+ * \brief Encodes the data as a binary savegame.
+ *
+ * See import_from_binary() for a description of the format.
+ * Values are written in the same order as in text savegames.
+ *
+ * \return The content of the file.
+ */
+std::string Savegame::export_to_binary() const {
+
+  // Intern keys and string values.
+  std::unordered_map<std::string, uint32_t> string_indexes;
+  std::vector<const std::string*> strings;
+  const auto& intern = [&](const std::string& string) {
+    const auto& result = string_indexes.emplace(string, static_cast<uint32_t>(strings.size()));
+    if (result.second) {
+      strings.push_back(&result.first->first);
+    }
+    return result.first->second;
+  };
+
+  const std::vector<SavegameKey>& keys = get_sorted_keys();
+  std::string values;
+  values.reserve(keys.size() * 9);
+  uint32_t num_values = 0;
+  for (const SavegameKey& key : keys) {
+    const SavedValue& value = saved_values.at(key.get_index());
+    if (value.type == SavedValue::VALUE_UNSET) {
+      // Unset values have no type: don't write them at all.
+      continue;
+    }
+
+    write_uint32(values, intern(key.get_name()));
+    ++num_values;
+    switch (value.type) {
+
+    case SavedValue::VALUE_UNSET:
+      break;
+
+    case SavedValue::VALUE_STRING:
+      values.push_back(static_cast<char>(BINARY_VALUE_STRING));
+      write_uint32(values, intern(value.string_data));
+      break;
+
+    case SavedValue::VALUE_INTEGER:
+      values.push_back(static_cast<char>(BINARY_VALUE_INTEGER));
+      write_uint32(values, static_cast<uint32_t>(value.int_data));
+      break;
+
+    case SavedValue::VALUE_BOOLEAN:
+      values.push_back(static_cast<char>(BINARY_VALUE_BOOLEAN));
+      write_uint32(values, value.int_data != 0 ? 1 : 0);
+      break;
+    }
+  }
+
+  std::string buffer(binary_magic, sizeof(binary_magic));
+  write_uint32(buffer, static_cast<uint32_t>(BINARY_FORMAT_VERSION));
+  write_uint32(buffer, static_cast<uint32_t>(strings.size()));
+  for (const std::string* string : strings) {
+    write_uint32(buffer, static_cast<uint32_t>(string->size()));
+    buffer.append(*string);
+  }
+  write_uint32(buffer, num_values);
+  buffer.append(values);
+  write_uint32(buffer, compute_checksum(buffer.data(), buffer.size()));
+
+  return buffer;
 }
 
 /**
@@ -342,6 +681,25 @@ const std::string& Savegame::get_file_name() const {
   return file_name;
 }
 
+/**
+ * \brief Returns the format used to save this savegame.
+ *
+ * Existing savegames keep the format they were loaded from.
+ *
+ * \return The savegame format.
+ */
+SavegameFormat Savegame::get_format() const {
+  return format;
+}
+
+/**
+ * \brief Sets the format to use next time this savegame is saved.
+ * \param format The savegame format.
+ */
+void Savegame::set_format(SavegameFormat format) {
+  this->format = format;
+}
+
 /**
  * \brief Returns the Solarus main loop.
  * \return The main loop.
@@ -406,173 +764,336 @@ void Savegame::notify_game_finished() {
   equipment.notify_game_finished();
 }
 
+/**
+ * \brief Returns the value stored for a key if any.
+ * \param key Key of the value to get.
+ * \return The value or nullptr if it is not set.
+ */
+const Savegame::SavedValue* Savegame::find_value(const SavegameKey& key) const {
+
+  const auto& it = saved_values.find(key.get_index());
+  if (it == saved_values.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+/**
+ * \brief Returns the slot where to store the value of a key.
+ * \param key Key of the value to set.
+ * \return The slot of this key, created unset if needed.
+ */
+Savegame::SavedValue& Savegame::get_value_to_set(const SavegameKey& key) {
+
+  Debug::check_assertion(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
+
+  const auto& result = saved_values.emplace(key.get_index(), SavedValue());
+  if (result.second) {
+    SavedValue& value = result.first->second;
+    value.type = SavedValue::VALUE_UNSET;
+    value.int_data = 0;
+  }
+  return result.first->second;
+}
+
+/**
+ * \brief Returns the keys of all values set, sorted by name.
+ *
+ * This is the order used to save values,
+ * so that files stay stable from one save to another.
+ *
+ * \return The keys of values set.
+ */
+std::vector<SavegameKey> Savegame::get_sorted_keys() const {
+
+  std::vector<SavegameKey> keys;
+  keys.reserve(saved_values.size());
+  for (const auto& kvp : saved_values) {
+    keys.push_back(SavegameKey::from_index(kvp.first));
+  }
+
+  std::sort(keys.begin(), keys.end(), [](const SavegameKey& key_1, const SavegameKey& key_2) {
+    return key_1.get_name() < key_2.get_name();
+  });
+  return keys;
+}
+
 /**
  * \brief Returns whether a saved value is a string.
- * \param key Name of the value to get.
+ * \param key Key of the value to get.
  * \return true if this value exists and is a string.
  */
-bool Savegame::is_string(const std::string& key) const {
+bool Savegame::is_string(const SavegameKey& key) const {
 
-  SOLARUS_ASSERT(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+  SOLARUS_ASSERT(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
 
-  bool result = false;
-  const auto& it = saved_values.find(key);
-  if (it != saved_values.end()) {
-    const SavedValue& value = it->second;
-    result = (value.type == SavedValue::VALUE_STRING);
-  }
-  return result;
+  const SavedValue* value = find_value(key);
+  return value != nullptr && value->type == SavedValue::VALUE_STRING;
 }
 
 /**
  * \brief Returns a string value saved.
- * \param key Name of the value to get.
+ * \param key Key of the value to get.
  * \return The string value associated with this key or an empty string.
  */
-std::string Savegame::get_string(const std::string& key) const {
+std::string Savegame::get_string(const SavegameKey& key) const {
 
-  SOLARUS_ASSERT(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+  SOLARUS_ASSERT(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
 
-  const auto& it = saved_values.find(key);
-  if (it == saved_values.end()) {
+  const SavedValue* value = find_value(key);
+  if (value == nullptr) {
     return "";
   }
 
-  const SavedValue& value = it->second;
-  if (value.type != SavedValue::VALUE_STRING) {
-    Debug::error(std::string("Value '") + key + "' is not a string");
+  if (value->type != SavedValue::VALUE_STRING) {
+    Debug::error(std::string("Value '") + key.get_name() + "' is not a string");
     return "";
   }
 
-  return value.string_data;
+  return value->string_data;
 }
 
 /**
  * \brief Sets a string value saved.
- * \param key Name of the value to set.
+ * \param key Key of the value to set.
  * \param value The string value to associate with this key.
  */
-void Savegame::set_string(const std::string& key, const std::string& value) {
-
-  Debug::check_assertion(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+void Savegame::set_string(const SavegameKey& key, const std::string& value) {
 
-  saved_values[key].type = SavedValue::VALUE_STRING;
-  saved_values[key].string_data = value;
+  SavedValue& saved_value = get_value_to_set(key);
+  saved_value.type = SavedValue::VALUE_STRING;
+  saved_value.string_data = value;
 }
 
 /**
  * \brief Returns whether a saved value is an integer.
- * \param key Name of the value to get.
+ * \param key Key of the value to get.
  * \return true if this value exists and is an integer.
  */
-bool Savegame::is_integer(const std::string& key) const {
+bool Savegame::is_integer(const SavegameKey& key) const {
 
-  SOLARUS_ASSERT(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+  SOLARUS_ASSERT(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
 
-  bool result = false;
-  const auto& it = saved_values.find(key);
-  if (it != saved_values.end()) {
-    const SavedValue& value = it->second;
-    result = (value.type == SavedValue::VALUE_INTEGER);
-  }
-  return result;
+  const SavedValue* value = find_value(key);
+  return value != nullptr && value->type == SavedValue::VALUE_INTEGER;
 }
 
 /**
  * \brief Returns a integer value saved.
- * \param key Name of the value to get.
+ * \param key Key of the value to get.
  * \return The integer value associated with this key or 0.
  */
-int Savegame::get_integer(const std::string& key) const {
+int Savegame::get_integer(const SavegameKey& key) const {
 
-  SOLARUS_ASSERT(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+  SOLARUS_ASSERT(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
 
-  const auto& it = saved_values.find(key);
-  if (it == saved_values.end()) {
+  const SavedValue* value = find_value(key);
+  if (value == nullptr) {
     return 0;
   }
 
-  const SavedValue& value = it->second;
-  if (value.type != SavedValue::VALUE_INTEGER) {
-    Debug::error(std::string("Value '") + key + "' is not an integer");
+  if (value->type != SavedValue::VALUE_INTEGER) {
+    Debug::error(std::string("Value '") + key.get_name() + "' is not an integer");
   }
 
-  return value.int_data;
+  return value->int_data;
 }
 
 /**
  * \brief Sets an integer value saved.
- * \param key Name of the value to set.
+ * \param key Key of the value to set.
  * \param value The integer value to associate with this key.
  */
-void Savegame::set_integer(const std::string& key, int value) {
-
-  Debug::check_assertion(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+void Savegame::set_integer(const SavegameKey& key, int value) {
 
-  saved_values[key].type = SavedValue::VALUE_INTEGER;
-  saved_values[key].int_data = value;
+  SavedValue& saved_value = get_value_to_set(key);
+  saved_value.type = SavedValue::VALUE_INTEGER;
+  saved_value.string_data.clear();
+  saved_value.int_data = value;
 }
 
 /**
  * \brief Returns whether a saved value is a boolean.
- * \param key Name of the value to get.
+ * \param key Key of the value to get.
  * \return true if this value exists and is a boolean.
  */
-bool Savegame::is_boolean(const std::string& key) const {
+bool Savegame::is_boolean(const SavegameKey& key) const {
 
-  SOLARUS_ASSERT(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+  SOLARUS_ASSERT(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
 
-  bool result = false;
-  const auto& it = saved_values.find(key);
-  if (it != saved_values.end()) {
-    const SavedValue& value = it->second;
-    result = (value.type == SavedValue::VALUE_BOOLEAN);
-  }
-  return result;
+  const SavedValue* value = find_value(key);
+  return value != nullptr && value->type == SavedValue::VALUE_BOOLEAN;
 }
 
 /**
  * \brief Returns a boolean value saved.
- * \param key Name of the value to get.
+ * \param key Key of the value to get.
  * \return The boolean value associated with this key or false.
  */
-bool Savegame::get_boolean(const std::string& key) const {
+bool Savegame::get_boolean(const SavegameKey& key) const {
 
-  SOLARUS_ASSERT(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+  SOLARUS_ASSERT(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
 
-  const auto& it = saved_values.find(key);
-  if (it == saved_values.end()) {
+  const SavedValue* value = find_value(key);
+  if (value == nullptr) {
     return false;
   }
 
-  const SavedValue& value = it->second;
-  if (value.type != SavedValue::VALUE_BOOLEAN) {
-    Debug::error(std::string("Value '") + key + "' is not a boolean");
+  if (value->type != SavedValue::VALUE_BOOLEAN) {
+    Debug::error(std::string("Value '") + key.get_name() + "' is not a boolean");
     return false;
   }
-  return value.int_data != 0;
+  return value->int_data != 0;
 }
 
 /**
  * \brief Sets a boolean value saved.
- * \param key Name of the value to set.
+ * \param key Key of the value to set.
  * \param value The boolean value to associate with this key.
  */
-void Savegame::set_boolean(const std::string& key, bool value) {
+void Savegame::set_boolean(const SavegameKey& key, bool value) {
+
+  SavedValue& saved_value = get_value_to_set(key);
+  saved_value.type = SavedValue::VALUE_BOOLEAN;
+  saved_value.string_data.clear();
+  saved_value.int_data = value;
+}
+
+/**
+ * \brief Returns whether a value is defined in the savegame.
+ * \param key Key of the value to check.
+ * \return \c true if such a value is defined.
+ */
+bool Savegame::is_set(const SavegameKey& key) const {
+
+  return find_value(key) != nullptr;
+}
+
+/**
+ * \brief Unsets a value saved.
+ * \param key Key of the value to unset.
+ */
+void Savegame::unset(const SavegameKey& key) {
+
+  Debug::check_assertion(key.is_valid_name(),
+      std::string("Savegame variable '") + key.get_name() + "' is not a valid key");
+
+  saved_values.erase(key.get_index());
+}
+
+/**
+ * \brief Returns whether a saved value is a string.
+ *
+ * Prefer the SavegameKey version when the same name is used repeatedly.
+ *
+ * \param key Name of the value to get.
+ * \return true if this value exists and is a string.
+ */
+bool Savegame::is_string(const std::string& key) const {
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return false;
+  }
+  return is_string(existing_key);
+}
+
+/**
+ * \brief Returns a string value saved.
+ * \param key Name of the value to get.
+ * \return The string value associated with this key or an empty string.
+ */
+std::string Savegame::get_string(const std::string& key) const {
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return "";
+  }
+  return get_string(existing_key);
+}
+
+/**
+ * \brief Sets a string value saved.
+ * \param key Name of the value to set.
+ * \param value The string value to associate with this key.
+ */
+void Savegame::set_string(const std::string& key, const std::string& value) {
+  set_string(get_key_to_set(key), value);
+}
+
+/**
+ * \brief Returns whether a saved value is an integer.
+ * \param key Name of the value to get.
+ * \return true if this value exists and is an integer.
+ */
+bool Savegame::is_integer(const std::string& key) const {
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return false;
+  }
+  return is_integer(existing_key);
+}
+
+/**
+ * \brief Returns a integer value saved.
+ * \param key Name of the value to get.
+ * \return The integer value associated with this key or 0.
+ */
+int Savegame::get_integer(const std::string& key) const {
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return 0;
+  }
+  return get_integer(existing_key);
+}
+
+/**
+ * \brief Sets an integer value saved.
+ * \param key Name of the value to set.
+ * \param value The integer value to associate with this key.
+ */
+void Savegame::set_integer(const std::string& key, int value) {
+  set_integer(get_key_to_set(key), value);
+}
+
+/**
+ * \brief Returns whether a saved value is a boolean.
+ * \param key Name of the value to get.
+ * \return true if this value exists and is a boolean.
+ */
+bool Savegame::is_boolean(const std::string& key) const {
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return false;
+  }
+  return is_boolean(existing_key);
+}
 
-  Debug::check_assertion(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
+/**
+ * \brief Returns a boolean value saved.
+ * \param key Name of the value to get.
+ * \return The boolean value associated with this key or false.
+ */
+bool Savegame::get_boolean(const std::string& key) const {
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return false;
+  }
+  return get_boolean(existing_key);
+}
 
-  saved_values[key].type = SavedValue::VALUE_BOOLEAN;
-  saved_values[key].int_data = value;
+/**
+ * \brief Sets a boolean value saved.
+ * \param key Name of the value to set.
+ * \param value The boolean value to associate with this key.
+ */
+void Savegame::set_boolean(const std::string& key, bool value) {
+  set_boolean(get_key_to_set(key), value);
 }
 
 /**
@@ -581,8 +1102,11 @@ void Savegame::set_boolean(const std::string& key, bool value) {
  * \return \c true if such a value is defined.
  */
 bool Savegame::is_set(const std::string& key) const {
-
-  return saved_values.find(key) != saved_values.end();
+  SavegameKey existing_key;
+  if (!SavegameKey::find(key, existing_key)) {
+    return false;
+  }
+  return is_set(existing_key);
 }
 
 /**
@@ -591,10 +1115,10 @@ bool Savegame::is_set(const std::string& key) const {
  */
 void Savegame::unset(const std::string& key) {
 
-  Debug::check_assertion(LuaTools::is_valid_lua_identifier(key),
-      std::string("Savegame variable '") + key + "' is not a valid key");
-
-  saved_values.erase(key);
+  SavegameKey existing_key;
+  if (SavegameKey::find(key, existing_key)) {
+    unset(existing_key);
+  }
 }
 
 /**
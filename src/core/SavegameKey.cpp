@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/SavegameKey.h"
+#include "solarus/lua/LuaTools.h"
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace Solarus {
+
+namespace {
+
+/**
+ * \brief Table of all savegame variable names interned so far.
+ */
+struct KeyTable {
+  std::unordered_map<std::string, size_t> indexes;  /**< Index of each name. */
+  std::deque<std::string> names;     /**< Names by index. A deque keeps
+                                      * references valid when growing. */
+  std::vector<bool> valid_names;     /**< Whether each name is a valid Lua identifier. */
+};
+
+/**
+ * \brief Returns the table of interned names.
+ *
+ * It is created on first use so that keys can be static objects.
+ *
+ * \return The key table.
+ */
+KeyTable& get_key_table() {
+
+  static KeyTable key_table;
+  return key_table;
+}
+
+}  // Anonymous namespace.
+
+/**
+ * \brief Creates a key to be assigned later, for example by find().
+ *
+ * It must not be used before being assigned.
+ */
+SavegameKey::SavegameKey():
+  index(static_cast<size_t>(-1)) {
+
+}
+
+/**
+ * \brief Returns the key of a savegame variable name, interning it if needed.
+ *
+ * The name is not required to be a valid savegame variable name:
+ * use is_valid_name() to know it.
+ *
+ * \param name Name of a savegame variable.
+ */
+SavegameKey::SavegameKey(const std::string& name) {
+
+  KeyTable& key_table = get_key_table();
+  const auto& result = key_table.indexes.emplace(name, key_table.names.size());
+  if (result.second) {
+    // New name.
+    key_table.names.push_back(name);
+    key_table.valid_names.push_back(LuaTools::is_valid_lua_identifier(name));
+  }
+  index = result.first->second;
+}
+
+/**
+ * \brief Returns the key of a name only if it was already interned.
+ *
+ * Unlike the constructor, this does not intern new names.
+ * A name never interned cannot have a value in any savegame.
+ *
+ * \param[in] name Name of a savegame variable.
+ * \param[out] key The key of this name if it exists.
+ * \return \c true if the name was already interned.
+ */
+bool SavegameKey::find(const std::string& name, SavegameKey& key) {
+
+  const KeyTable& key_table = get_key_table();
+  const auto& it = key_table.indexes.find(name);
+  if (it == key_table.indexes.end()) {
+    return false;
+  }
+  key.index = it->second;
+  return true;
+}
+
+/**
+ * \brief Returns an existing key from its index.
+ * \param index Index of a key previously interned.
+ * \return The corresponding key.
+ */
+SavegameKey SavegameKey::from_index(size_t index) {
+
+  Debug::check_assertion(index < get_num_keys(), "Invalid savegame key index");
+
+  SavegameKey key;
+  key.index = index;
+  return key;
+}
+
+/**
+ * \brief Returns the number of names interned so far.
+ *
+ * All key indexes are lower than this number.
+ *
+ * \return The number of keys.
+ */
+size_t SavegameKey::get_num_keys() {
+  return get_key_table().names.size();
+}
+
+/**
+ * \brief Returns the name of the savegame variable of this key.
+ * \return The name.
+ */
+const std::string& SavegameKey::get_name() const {
+  return get_key_table().names[index];
+}
+
+/**
+ * \brief Returns whether the name of this key is a valid savegame variable name.
+ *
+ * This is computed only once per name.
+ *
+ * \return \c true if the name is a valid Lua identifier.
+ */
+bool SavegameKey::is_valid_name() const {
+  return get_key_table().valid_names[index];
+}
+
+}
+
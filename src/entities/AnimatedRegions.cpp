@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/Map.h"
+#include "solarus/entities/AnimatedRegions.h"
+#include "solarus/entities/AnimatedTilePattern.h"
+#include "solarus/entities/Tile.h"
+#include "solarus/entities/TilePattern.h"
+#include "solarus/graphics/Surface.h"
+
+namespace Solarus {
+
+namespace {
+
+/**
+ * \brief Size of the cells whose drawing is cached.
+ */
+const Size cell_size(128, 128);
+
+/**
+ * \brief Maximum number of bytes of cached cell surfaces per layer.
+ */
+constexpr size_t max_cached_memory_size = 16 * 1024 * 1024;
+
+/**
+ * \brief Returns the least common multiple of two positive integers.
+ * \param a An integer.
+ * \param b Another integer.
+ * \return The least common multiple.
+ */
+int get_lcm(int a, int b) {
+
+  int x = a;
+  int y = b;
+  while (y != 0) {
+    const int r = x % y;
+    x = y;
+    y = r;
+  }
+  return a / x * b;
+}
+
+}
+
+/**
+ * \brief Constructor.
+ * \param map The map. Its size must be known.
+ * \param layer The layer to represent.
+ */
+AnimatedRegions::AnimatedRegions(Map& map, int layer):
+  map(map),
+  layer(layer),
+  cached_tiles(map.get_size(), cell_size),
+  cells(),
+  individual_tiles(),
+  lru_frames(),
+  cached_memory_size(0) {
+
+}
+
+/**
+ * \brief Determines which tiles can be drawn from cached cells.
+ *
+ * A cell is cached if all tiles overlapping it have an appearance that
+ * only depends on the frame counter of animated tile patterns.
+ * Other tiles and tiles outside the map are drawn individually, as well as
+ * all tiles overlapping a cell where a tile is drawn individually.
+ *
+ * \param tiles The animated tiles of this layer and the tiles overlapping
+ * them, in drawing order.
+ */
+void AnimatedRegions::build(const std::vector<TilePtr>& tiles) {
+
+  Debug::check_assertion(cells.empty(), "Animated regions are already built");
+
+  const size_t num_cells = cached_tiles.get_num_cells();
+  cells.resize(num_cells);
+
+  for (const TilePtr& tile: tiles) {
+    Debug::check_assertion(tile->get_layer() == layer, "Wrong layer for tile");
+    if (!tile->is_drawn_at_its_position()) {
+      // This tile may be drawn anywhere: don't cache anything on this layer.
+      individual_tiles = tiles;
+      return;
+    }
+  }
+
+  // Find the cells of each tile.
+  Grid<size_t> tiles_by_cell(map.get_size(), cell_size);
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    tiles_by_cell.add(i, tiles[i]->get_bounding_box());
+  }
+  std::vector<std::vector<size_t>> cells_by_tile(tiles.size());
+  for (size_t cell_index = 0; cell_index < num_cells; ++cell_index) {
+    for (size_t i: tiles_by_cell.get_elements(cell_index)) {
+      cells_by_tile[i].push_back(cell_index);
+    }
+  }
+
+  // Tiles that cannot be cached make their cells non-cacheable,
+  // and so do the other tiles of these cells.
+  std::vector<bool> are_tiles_individual(tiles.size(), false);
+  std::vector<bool> are_cells_cacheable(num_cells, true);
+  std::vector<size_t> tiles_to_check;
+  const Rectangle map_box(Point(0, 0), map.get_size());
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (tiles[i]->get_tile_pattern().get_frame_period() == 0 ||
+        !map_box.contains(tiles[i]->get_bounding_box())) {
+      are_tiles_individual[i] = true;
+      tiles_to_check.push_back(i);
+    }
+  }
+  while (!tiles_to_check.empty()) {
+    const size_t i = tiles_to_check.back();
+    tiles_to_check.pop_back();
+    for (size_t cell_index: cells_by_tile[i]) {
+      if (!are_cells_cacheable[cell_index]) {
+        continue;
+      }
+      are_cells_cacheable[cell_index] = false;
+      for (size_t j: tiles_by_cell.get_elements(cell_index)) {
+        if (!are_tiles_individual[j]) {
+          are_tiles_individual[j] = true;
+          tiles_to_check.push_back(j);
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    const TilePtr& tile = tiles[i];
+    if (are_tiles_individual[i]) {
+      individual_tiles.push_back(tile);
+      continue;
+    }
+
+    cached_tiles.add(tile, tile->get_bounding_box());
+    const int frame_period = tile->get_tile_pattern().get_frame_period();
+    for (size_t cell_index: cells_by_tile[i]) {
+      Cell& cell = cells[cell_index];
+      cell.cached = true;
+      cell.frame_period = get_lcm(cell.frame_period, frame_period);
+    }
+  }
+
+  for (Cell& cell: cells) {
+    if (cell.cached) {
+      cell.frames.resize(cell.frame_period);
+      cell.lru_positions.resize(cell.frame_period);
+    }
+  }
+}
+
+/**
+ * \brief Clears previous drawings because the tileset has changed.
+ */
+void AnimatedRegions::notify_tileset_changed() {
+
+  while (!lru_frames.empty()) {
+    discard_cell_frame(lru_frames.back());
+  }
+  // Everything will be redrawn when necessary.
+}
+
+/**
+ * \brief Draws a layer of animated regions of tiles on the current map.
+ */
+void AnimatedRegions::draw_on_map() {
+
+  const CameraPtr& camera = map.get_camera();
+  if (camera == nullptr) {
+    return;
+  }
+
+  // Draw cached cells that overlap the camera.
+  const int num_rows = cached_tiles.get_num_rows();
+  const int num_columns = cached_tiles.get_num_columns();
+  const Rectangle& camera_position = camera->get_bounding_box();
+
+  const int row1 = camera_position.get_y() / cell_size.height;
+  const int row2 = (camera_position.get_y() + camera_position.get_height()) / cell_size.height;
+  const int column1 = camera_position.get_x() / cell_size.width;
+  const int column2 = (camera_position.get_x() + camera_position.get_width()) / cell_size.width;
+
+  for (int i = row1; i <= row2; ++i) {
+    if (i < 0 || i >= num_rows) {
+      continue;
+    }
+
+    for (int j = column1; j <= column2; ++j) {
+      if (j < 0 || j >= num_columns) {
+        continue;
+      }
+
+      const int cell_index = i * num_columns + j;
+      if (!cells[cell_index].cached) {
+        continue;
+      }
+
+      const Point cell_xy = {
+          j * cell_size.width,
+          i * cell_size.height
+      };
+      draw_cell(cell_index, cell_xy - camera_position.get_xy());
+    }
+  }
+
+  // Draw other tiles individually.
+  // They never overlap cached cells.
+  for (const TilePtr& tile: individual_tiles) {
+    if (tile->overlaps(*camera) || !tile->is_drawn_at_its_position()) {
+      tile->draw_on_map();
+    }
+  }
+}
+
+/**
+ * \brief Draws the current animation frame of a cached cell.
+ *
+ * The frame is built first if it is not in the cache.
+ *
+ * \param cell_index Index of the cell to draw.
+ * \param dst_position Where to draw the cell on the camera surface.
+ */
+void AnimatedRegions::draw_cell(int cell_index, const Point& dst_position) {
+
+  Cell& cell = cells[cell_index];
+  const int frame = AnimatedTilePattern::get_frame_counter() % cell.frame_period;
+
+  if (cell.frames[frame] == nullptr) {
+    build_cell_frame(cell_index, frame);
+  }
+  else {
+    // Mark this frame as the most recently drawn one.
+    lru_frames.splice(lru_frames.begin(), lru_frames, cell.lru_positions[frame]);
+  }
+
+  cell.frames[frame]->draw(map.get_camera_surface(), dst_position);
+}
+
+/**
+ * \brief Draws all tiles of a cell on a new surface for the current
+ * animation frame.
+ *
+ * Least recently drawn frames are discarded if the cache is full.
+ *
+ * \param cell_index Index of the cell to build.
+ * \param frame Index of the frame to build in the period of the cell.
+ * It must correspond to the current frame counter.
+ */
+void AnimatedRegions::build_cell_frame(int cell_index, int frame) {
+
+  Cell& cell = cells[cell_index];
+  Debug::check_assertion(cell.frames[frame] == nullptr,
+      "This cell frame is already built"
+  );
+
+  const int row = cell_index / cached_tiles.get_num_columns();
+  const int column = cell_index % cached_tiles.get_num_columns();
+
+  // Position of this cell on the map.
+  const Point cell_xy = {
+      column * cell_size.width,
+      row * cell_size.height
+  };
+
+  SurfacePtr cell_surface = Surface::create(cell_size);
+  for (const TilePtr& tile: cached_tiles.get_elements(cell_index)) {
+
+    const Rectangle& box = tile->get_bounding_box();
+    Rectangle dst_position(
+        box.get_x() - cell_xy.x,
+        box.get_y() - cell_xy.y,
+        box.get_width(),
+        box.get_height()
+    );
+
+    tile->get_tile_pattern().fill_surface(
+        cell_surface,
+        dst_position,
+        map.get_tileset(),
+        cell_xy
+    );
+  }
+
+  cell.frames[frame] = cell_surface;
+  lru_frames.emplace_front(cell_index, frame);
+  cell.lru_positions[frame] = lru_frames.begin();
+  cached_memory_size += cell_size.width * cell_size.height * 4;
+
+  // Make room if necessary, but keep the frame just built.
+  while (cached_memory_size > max_cached_memory_size && lru_frames.size() > 1) {
+    discard_cell_frame(lru_frames.back());
+  }
+}
+
+/**
+ * \brief Removes a frame of a cell from the cache.
+ * \param cell_frame The cell index and frame index to remove.
+ */
+void AnimatedRegions::discard_cell_frame(CellFrame cell_frame) {
+
+  Cell& cell = cells[cell_frame.first];
+  const int frame = cell_frame.second;
+  Debug::check_assertion(cell.frames[frame] != nullptr,
+      "This cell frame is not built"
+  );
+
+  lru_frames.erase(cell.lru_positions[frame]);
+  cell.frames[frame] = nullptr;
+  cached_memory_size -= cell_size.width * cell_size.height * 4;
+}
+
+}
@@ -118,6 +118,14 @@ void AnimatedTilePattern::update() {
   }
 }
 
+/**
+ * \brief Returns the current frame counter shared by all animated tiles.
+ * \return The frame counter (0 to 11).
+ */
+int AnimatedTilePattern::get_frame_counter() {
+  return frame_counter;
+}
+
 /**
  * \brief Draws the tile image on a surface.
  * \param dst_surface the surface to draw
@@ -160,5 +168,18 @@ bool AnimatedTilePattern::is_drawn_at_its_position() const {
   return !parallax;
 }
 
+/**
+ * \brief Returns after how many frames this tile pattern is drawn the same
+ * way again.
+ * \return 3 or 4 depending on the animation sequence, or 0 with parallax
+ * scrolling because the appearance then also depends on the viewport.
+ */
+int AnimatedTilePattern::get_frame_period() const {
+
+  if (parallax) {
+    return 0;
+  }
+  return sequence == ANIMATION_SEQUENCE_012 ? 3 : 4;
 }
 
+}
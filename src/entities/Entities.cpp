@@ -18,6 +18,8 @@
 #include "solarus/core/Debug.h"
 #include "solarus/core/Game.h"
 #include "solarus/core/Map.h"
+#include "solarus/core/MapData.h"
+#include "solarus/entities/AnimatedRegions.h"
 #include "solarus/entities/Boomerang.h"
 #include "solarus/entities/CrystalBlock.h"
 #include "solarus/entities/Destination.h"
@@ -34,6 +36,8 @@
 #include "solarus/graphics/Color.h"
 #include "solarus/graphics/Surface.h"
 #include "solarus/lua/LuaContext.h"
+#include "solarus/movements/Movement.h"
+#include <algorithm>
 #include <sstream>
 #include <lua.hpp>
 
@@ -130,6 +134,16 @@ class DrawingOrderComparator {
 
 };
 
+/**
+ * \brief Returns whether a name starts with the given prefix.
+ * \param name The name to test.
+ * \param prefix The prefix.
+ * \return \c true if the name has this prefix.
+ */
+bool name_has_prefix(const std::string& name, const std::string& prefix) {
+  return name.compare(0, prefix.size(), prefix) == 0;
+}
+
 }  // Anonymous namespace.
 
 /**
@@ -145,17 +159,24 @@ Entities::Entities(Game& game, Map& map):
   tiles_grid_size(0),
   tiles_ground(),
   non_animated_regions(),
-  tiles_in_animated_regions(),
+  animated_regions(),
   hero(game.get_hero()),
   camera(nullptr),
   named_entities(),
   all_entities(),
   quadtree(),
+  detectors(),
+  layer_independent_detectors(),
   z_caches(),
   entities_drawn_not_at_their_position(),
   entities_to_draw(),
   entities_to_remove(),
-  default_destination(nullptr) {
+  default_destination(nullptr),
+  map_data(nullptr),
+  dormant_entities(map.get_size(), Size(256, 256)),
+  are_dormant_cells_created(dormant_entities.get_num_cells(), false),
+  num_dormant_entities(0),
+  dormant_entity_being_created(nullptr) {
 
   // Initialize the size.
   initialize_layers();
@@ -170,36 +191,153 @@ Entities::Entities(Game& game, Map& map):
     non_animated_regions[layer] = std::unique_ptr<NonAnimatedRegions>(
         new NonAnimatedRegions(map, layer)
     );
+    animated_regions[layer] = std::unique_ptr<AnimatedRegions>(
+        new AnimatedRegions(map, layer)
+    );
   }
 
   // Initialize the quadtree.
   const int margin = 64;
   Rectangle quadtree_space(-margin, -margin, map.get_width() + 2 * margin, map.get_height() + 2 * margin);
   quadtree.initialize(quadtree_space);
+  for (int layer = map.get_min_layer(); layer <= map.get_max_layer(); ++layer) {
+    detectors[layer] = std::unique_ptr<EntityTree>(new EntityTree(quadtree_space));
+  }
+  layer_independent_detectors.initialize(quadtree_space);
 
   // Create the camera.
   add_entity(std::make_shared<Camera>(map));
 }
 
+/**
+ * \brief Destructor.
+ */
+Entities::~Entities() {
+}
+
 /**
  * \brief Creates live entities from the given data.
+ *
+ * Unnamed destructibles are not created yet: they stay dormant until the
+ * camera approaches them or something queries entities where they are.
+ * This is not done if the destructible metatable defines on_created().
+ *
+ * \param data The map data. It is kept until all dormant entities are
+ * created.
  */
-void Entities::create_entities(const MapData& data) {
+void Entities::create_entities(const std::shared_ptr<const MapData>& data) {
 
   // Create entities from the map data file.
   LuaContext& lua_context = map.get_lua_context();
+  const bool dormant_destructibles = !lua_context.metatable_has_field(
+      LuaContext::get_entity_internal_type_name(EntityType::DESTRUCTIBLE),
+      "on_created"
+  );
   for (int layer = map.get_min_layer(); layer <= map.get_max_layer(); ++layer) {
-    for (int i = 0; i < data.get_num_entities(layer); ++i) {
-      const EntityData& entity_data = data.get_entity({ layer, i });
+    for (int i = 0; i < data->get_num_entities(layer); ++i) {
+      const EntityData& entity_data = data->get_entity({ layer, i });
       EntityType type = entity_data.get_type();
       if (!EntityTypeInfo::can_be_stored_in_map_file(type)) {
         Debug::error("Illegal entity type in map data: " + enum_to_name(type));
       }
+      if (dormant_destructibles &&
+          type == EntityType::DESTRUCTIBLE &&
+          !entity_data.has_name() &&
+          map.is_valid_layer(entity_data.get_layer())) {
+        // Keep its place in the Z order for when it gets created.
+        const DormantEntity dormant_entity = {
+            &entity_data,
+            z_caches[entity_data.get_layer()].reserve()
+        };
+        // Entities outside the map go to the nearest cell so that they
+        // still get created.
+        const Point& xy = entity_data.get_xy();
+        const Point cell_xy(
+            std::max(0, std::min(map.get_width() - 1, xy.x)),
+            std::max(0, std::min(map.get_height() - 1, xy.y))
+        );
+        dormant_entities.add(dormant_entity, Rectangle(cell_xy, Size(0, 0)));
+        ++num_dormant_entities;
+        continue;
+      }
       if (lua_context.create_map_entity_from_data(map, entity_data)) {
         lua_pop(lua_context.get_internal_state(), 1);  // Discard the created entity on the stack.
       }
     }
   }
+
+  if (num_dormant_entities > 0) {
+    map_data = data;
+  }
+}
+
+/**
+ * \brief Creates the dormant entities that may overlap a rectangle.
+ * \param where A rectangle of the map.
+ */
+void Entities::create_dormant_entities(const Rectangle& where) {
+
+  if (num_dormant_entities == 0) {
+    return;
+  }
+
+  // Dormant entities are stored at their origin point:
+  // add a margin for their bounding box and sprites.
+  constexpr int margin = 64;
+  const Size& cell_size = dormant_entities.get_cell_size();
+  const int num_rows = static_cast<int>(dormant_entities.get_num_rows());
+  const int num_columns = static_cast<int>(dormant_entities.get_num_columns());
+  const int row1 = std::max(0, (where.get_y() - margin) / cell_size.height);
+  const int row2 = std::min(num_rows - 1, (where.get_y() + where.get_height() + margin) / cell_size.height);
+  const int column1 = std::max(0, (where.get_x() - margin) / cell_size.width);
+  const int column2 = std::min(num_columns - 1, (where.get_x() + where.get_width() + margin) / cell_size.width);
+
+  for (int i = row1; i <= row2; ++i) {
+    for (int j = column1; j <= column2; ++j) {
+      const int cell_index = i * num_columns + j;
+      if (are_dormant_cells_created[cell_index]) {
+        continue;
+      }
+      are_dormant_cells_created[cell_index] = true;
+      for (const DormantEntity& dormant_entity : dormant_entities.get_elements(cell_index)) {
+        create_dormant_entity(dormant_entity);
+      }
+    }
+  }
+}
+
+/**
+ * \brief Creates all remaining dormant entities.
+ *
+ * This is necessary before returning entities without a spatial criteria.
+ */
+void Entities::create_all_dormant_entities() {
+
+  if (num_dormant_entities == 0) {
+    return;
+  }
+
+  create_dormant_entities(Rectangle(Point(0, 0), map.get_size()));
+}
+
+/**
+ * \brief Creates a dormant entity for real.
+ * \param dormant_entity The entity to create.
+ */
+void Entities::create_dormant_entity(const DormantEntity& dormant_entity) {
+
+  LuaContext& lua_context = map.get_lua_context();
+  dormant_entity_being_created = &dormant_entity;
+  if (lua_context.create_map_entity_from_data(map, *dormant_entity.data)) {
+    lua_pop(lua_context.get_internal_state(), 1);  // Discard the created entity on the stack.
+  }
+  dormant_entity_being_created = nullptr;
+
+  --num_dormant_entities;
+  if (num_dormant_entities == 0) {
+    // No more need to keep the map data.
+    map_data = nullptr;
+  }
 }
 
 /**
@@ -227,6 +365,8 @@ Hero& Entities::get_hero() {
  */
 EntityVector Entities::get_entities() {
 
+  create_all_dormant_entities();
+
   EntityVector result;
   result.insert(result.begin(), all_entities.begin(), all_entities.end());
   return result;
@@ -317,6 +457,7 @@ EntityVector Entities::get_entities_with_prefix(const std::string& prefix) {
 
   if (prefix.empty()) {
     // No prefix: return all entities no matter their name.
+    create_all_dormant_entities();
     for (const EntityPtr& entity: all_entities) {
       if (!entity->is_being_removed()) {
         entities.push_back(entity);
@@ -327,10 +468,12 @@ EntityVector Entities::get_entities_with_prefix(const std::string& prefix) {
   }
 
   // Normal case: add entities whose name starts with the prefix.
-  for (const auto& kvp: named_entities) {
-    const EntityPtr& entity = kvp.second;
-    if (entity->has_prefix(prefix) &&
-        !entity->is_being_removed()) {
+  // Names are sorted: entities with the prefix are contiguous.
+  for (auto it = named_entities.lower_bound(prefix);
+      it != named_entities.end() && name_has_prefix(it->first, prefix);
+      ++it) {
+    const EntityPtr& entity = it->second;
+    if (!entity->is_being_removed()) {
       entities.push_back(entity);
     }
   }
@@ -338,6 +481,44 @@ EntityVector Entities::get_entities_with_prefix(const std::string& prefix) {
   return entities;
 }
 
+/**
+ * \brief Returns the number of entities having the specified name prefix.
+ *
+ * This is equivalent to get_entities_with_prefix(prefix).size()
+ * but does not build the list.
+ *
+ * \param prefix Prefix of the name.
+ * \return The number of entities having this prefix in their name.
+ */
+int Entities::get_num_entities_with_prefix(const std::string& prefix) const {
+
+  int count = 0;
+
+  if (prefix.empty()) {
+    // No prefix: count all entities no matter their name.
+    for (const EntityPtr& entity: all_entities) {
+      if (!entity->is_being_removed()) {
+        ++count;
+      }
+    }
+    // Dormant entities are counted without being created.
+    return count + static_cast<int>(num_dormant_entities) + 1;  // The hero.
+  }
+
+  // Normal case: count entities whose name starts with the prefix.
+  // Names are sorted: entities with the prefix are contiguous.
+  for (auto it = named_entities.lower_bound(prefix);
+      it != named_entities.end() && name_has_prefix(it->first, prefix);
+      ++it) {
+    const EntityPtr& entity = it->second;
+    if (!entity->is_being_removed()) {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
 /**
  * \brief Like get_entities_with_prefix(const std::string&), but sorts entities according to
  * their Z index on the map.
@@ -375,10 +556,12 @@ EntityVector Entities::get_entities_with_prefix(
   }
 
   // Normal case: add entities whose name starts with the prefix.
-  for (const auto& kvp: named_entities) {
-    const EntityPtr& entity = kvp.second;
+  // Names are sorted: entities with the prefix are contiguous.
+  for (auto it = named_entities.lower_bound(prefix);
+      it != named_entities.end() && name_has_prefix(it->first, prefix);
+      ++it) {
+    const EntityPtr& entity = it->second;
     if (entity->get_type() == type &&
-        entity->has_prefix(prefix) &&
         !entity->is_being_removed()
     ) {
       entities.push_back(entity);
@@ -412,8 +595,27 @@ EntityVector Entities::get_entities_with_prefix_sorted(
  */
 bool Entities::has_entity_with_prefix(const std::string& prefix) const {
 
-  for (const EntityPtr& entity: all_entities) {
-    if (entity->has_prefix(prefix) && !entity->is_being_removed()) {
+  if (prefix.empty() && num_dormant_entities > 0) {
+    // Dormant entities have no name.
+    return true;
+  }
+
+  if (prefix.empty()) {
+    for (const EntityPtr& entity: all_entities) {
+      if (!entity->is_being_removed()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Names are sorted: entities with the prefix are contiguous.
+  for (auto it = named_entities.lower_bound(prefix);
+      it != named_entities.end() && name_has_prefix(it->first, prefix);
+      ++it) {
+    const EntityPtr& entity = it->second;
+    if (entity->get_type() != EntityType::HERO &&
+        !entity->is_being_removed()) {
       return true;
     }
   }
@@ -430,6 +632,10 @@ void Entities::get_entities_in_rectangle(
     const Rectangle& rectangle, ConstEntityVector& result
 ) const {
 
+  // Creating dormant entities does not change the content of the map
+  // as seen from outside.
+  const_cast<Entities*>(this)->create_dormant_entities(rectangle);
+
   EntityVector non_const_result = quadtree.get_elements(rectangle);
 
   result.reserve(non_const_result.size());
@@ -445,7 +651,8 @@ void Entities::get_entities_in_rectangle(
     const Rectangle& rectangle, EntityVector& result
 ) {
 
-  result = quadtree.get_elements(rectangle);
+  create_dormant_entities(rectangle);
+  quadtree.get_elements(rectangle, result);
 }
 
 /**
@@ -475,6 +682,30 @@ void Entities::get_entities_in_rectangle_sorted(
   std::sort(result.begin(), result.end(), ZOrderComparator(*this));
 }
 
+/**
+ * \brief Returns the detectors that may have collisions with entities
+ * of a layer in the given rectangle.
+ *
+ * This is faster than get_entities_in_rectangle() for collision checks
+ * because entities that detect nothing are not there.
+ *
+ * \param[in] rectangle A rectangle.
+ * \param[in] layer The layer of entities to check.
+ * \param[out] result The detectors of that layer and the layer-independent
+ * ones in that rectangle, in arbitrary order.
+ */
+void Entities::get_detectors_in_rectangle(
+    const Rectangle& rectangle, int layer, EntityVector& result
+) {
+
+  create_dormant_entities(rectangle);
+  detectors.at(layer)->get_elements(rectangle, result);
+
+  EntityVector layer_independent_result;
+  layer_independent_detectors.get_elements(rectangle, layer_independent_result);
+  result.insert(result.end(), layer_independent_result.begin(), layer_independent_result.end());
+}
+
 /**
  * \brief Returns all entities in the same separator region as the given point.
  *
@@ -624,6 +855,10 @@ EntitySet Entities::get_entities_by_type(EntityType type, int layer) {
 
   Debug::check_assertion(map.is_valid_layer(layer), "Invalid layer");
 
+  if (type == EntityType::DESTRUCTIBLE) {
+    create_all_dormant_entities();
+  }
+
   EntitySet result;
 
   const auto& it = entities_by_type.find(type);
@@ -696,15 +931,22 @@ void Entities::notify_map_started() {
   for (int layer = map.get_min_layer(); layer <= map.get_max_layer(); ++layer) {
     std::vector<TileInfo> tiles_in_animated_regions_info;
     non_animated_regions.at(layer)->build(tiles_in_animated_regions_info);
+    std::vector<TilePtr> tiles_in_animated_regions;
     for (const TileInfo& tile_info : tiles_in_animated_regions_info) {
       // This tile is non-optimizable, create it for real.
       TilePtr tile = std::make_shared<Tile>(tile_info);
-      tiles_in_animated_regions.at(layer).push_back(tile);
+      tiles_in_animated_regions.push_back(tile);
       add_entity(tile);
     }
+    animated_regions.at(layer)->build(tiles_in_animated_regions);
+  }
+
+  // Collision modes and layers may have changed during the loading phase.
+  for (const EntityPtr& entity: all_entities) {
+    notify_entity_detector_changed(*entity);
   }
 
-  // Now, tiles_in_animated_regions contains the tiles that won't be optimized.
+  // Now, animated regions contain the tiles that won't be optimized.
   // Notify entities.
   for (const EntityPtr& entity: all_entities) {
     entity->notify_map_started();
@@ -735,6 +977,7 @@ void Entities::notify_tileset_changed() {
   // Redraw optimized tiles (i.e. non animated ones).
   for (int layer = map.get_min_layer(); layer <= map.get_max_layer(); ++layer) {
     non_animated_regions[layer]->notify_tileset_changed();
+    animated_regions[layer]->notify_tileset_changed();
   }
 
   for (const EntityPtr& entity: all_entities) {
@@ -765,7 +1008,7 @@ void Entities::initialize_layers() {
   for (int layer = map.get_min_layer(); layer <= map.get_max_layer(); ++layer) {
     tiles_ground[layer] = std::vector<Ground>();
     non_animated_regions[layer] = std::unique_ptr<NonAnimatedRegions>();
-    tiles_in_animated_regions[layer] = std::vector<TilePtr>();
+    animated_regions[layer] = std::unique_ptr<AnimatedRegions>();
     z_caches[layer] = ZCache();
   }
 }
@@ -966,6 +1209,7 @@ void Entities::add_entity(const EntityPtr& entity) {
 
     // Update the quadtree.
     quadtree.add(entity, entity->get_max_bounding_box());
+    add_detector(entity);
 
     // Update the specific entities lists.
     switch (entity->get_type()) {
@@ -995,7 +1239,15 @@ void Entities::add_entity(const EntityPtr& entity) {
     }
 
     // Track the insertion order.
-    z_caches[layer].add(entity);
+    if (dormant_entity_being_created != nullptr &&
+        dormant_entity_being_created->data->get_layer() == layer) {
+      // Use the place reserved when the map data was read.
+      z_caches[layer].add(entity, dormant_entity_being_created->z);
+      dormant_entity_being_created = nullptr;
+    }
+    else {
+      z_caches[layer].add(entity);
+    }
 
     // Update the list of entities by type.
     auto it = entities_by_type.find(type);
@@ -1113,12 +1365,17 @@ void Entities::remove_marked_entities() {
 
     // Remove it from the quadtree.
     quadtree.remove(entity);
+    remove_detector(entity);
 
     // Remove it from the whole list.
     all_entities.remove(entity);
     const std::string& name = entity->get_name();
     if (!name.empty()) {
-      named_entities.erase(name);
+      // The name may already be used by a new entity.
+      const auto& it = named_entities.find(name);
+      if (it != named_entities.end() && it->second == entity) {
+        named_entities.erase(it);
+      }
     }
 
     // Update the specific entities lists.
@@ -1177,9 +1434,17 @@ void Entities::update() {
 
   Debug::check_assertion(map.is_started(), "The map is not started");
 
+  // Create dormant entities that are about to be visible.
+  if (camera != nullptr) {
+    create_dormant_entities(camera->get_bounding_box());
+  }
+
   // First update the hero.
   hero->update();
 
+  // Advance simple movements of custom entities together.
+  update_batched_movements();
+
   // Update the dynamic entities.
   for (const EntityPtr& entity: all_entities) {
 
@@ -1199,6 +1464,79 @@ void Entities::update() {
   remove_marked_entities();
 }
 
+/**
+ * \brief Updates in a batch the movements that do not need to notify each step.
+ *
+ * Straight, circle and pixel movements created by scripts are updated
+ * here, grouped by type, when they move a custom entity, are not swept
+ * and have no on_position_changed() event.
+ * Each entity is notified once of its final position, after all batched
+ * movements were updated. The entities then skip their movement update.
+ *
+ * Other entity types update their movement in the middle of their own
+ * update logic, so they are not batched.
+ */
+void Entities::update_batched_movements() {
+
+  LuaContext& lua_context = map.get_lua_context();
+  for (const EntityPtr& entity: all_entities) {
+
+    if (entity->get_type() != EntityType::CUSTOM ||
+        entity->is_being_removed()) {
+      continue;
+    }
+
+    const std::shared_ptr<Movement>& movement = entity->get_movement();
+    if (movement == nullptr ||
+        !movement->is_batchable() ||
+        movement->is_swept() ||
+        movement->is_suspended() ||
+        lua_context.userdata_has_field(*movement, "on_position_changed")) {
+      continue;
+    }
+
+    const std::string& type_name = movement->get_lua_type_name();
+    if (type_name == LuaContext::movement_straight_module_name) {
+      batched_straight_movements.push_back({ entity, movement });
+    }
+    else if (type_name == LuaContext::movement_circle_module_name) {
+      batched_circle_movements.push_back({ entity, movement });
+    }
+    else if (type_name == LuaContext::movement_pixel_module_name) {
+      batched_pixel_movements.push_back({ entity, movement });
+    }
+  }
+
+  for (std::vector<BatchedMovement>* batch : {
+      &batched_straight_movements,
+      &batched_circle_movements,
+      &batched_pixel_movements
+  }) {
+    for (const BatchedMovement& batched_movement : *batch) {
+      batched_movement.movement->start_batched_update();
+      batched_movement.movement->update();
+    }
+  }
+
+  for (std::vector<BatchedMovement>* batch : {
+      &batched_straight_movements,
+      &batched_circle_movements,
+      &batched_pixel_movements
+  }) {
+    for (const BatchedMovement& batched_movement : *batch) {
+      Entity& entity = *batched_movement.entity;
+      const bool moved = batched_movement.movement->finish_batched_update();
+      if (moved &&
+          batched_movement.movement->get_entity() != &entity &&
+          !entity.is_being_removed()) {
+        // The movement was stopped during the batch.
+        entity.notify_position_changed();
+      }
+    }
+    batch->clear();
+  }
+}
+
 /**
  * \brief Draws the entities on the map surface.
  */
@@ -1267,12 +1605,7 @@ void Entities::draw() {
     // in other words, draw all regions containing animated tiles
     // (and maybe more, but we don't care because non-animated tiles
     // will be drawn later).
-    for (unsigned int i = 0; i < tiles_in_animated_regions[layer].size(); i++) {
-      Tile& tile = *tiles_in_animated_regions[layer][i];
-      if (tile.overlaps(*camera) || !tile.is_drawn_at_its_position()) {
-        tile.draw_on_map();
-      }
-    }
+    animated_regions[layer]->draw_on_map();
 
     // Draw the non-animated tiles (with transparent rectangles on the regions of animated tiles
     // since they are already drawn).
@@ -1334,6 +1667,77 @@ void Entities::notify_entity_bounding_box_changed(Entity& entity) {
   // (i.e. not managed by MapEntities) this does nothing.
   EntityPtr shared_entity = std::static_pointer_cast<Entity>(entity.shared_from_this());
   quadtree.move(shared_entity, shared_entity->get_max_bounding_box());
+  if (entity.is_detector()) {
+    get_detector_tree(entity).move(shared_entity, shared_entity->get_max_bounding_box());
+  }
+}
+
+/**
+ * \brief This function should be called whenever the collision modes,
+ * the layer or the layer independence of collisions of an entity change.
+ *
+ * Detectors are indexed separately to make collision checks faster.
+ *
+ * \param entity The entity modified.
+ */
+void Entities::notify_entity_detector_changed(Entity& entity) {
+
+  EntityPtr shared_entity = std::static_pointer_cast<Entity>(entity.shared_from_this());
+  if (!quadtree.contains(shared_entity)) {
+    // Not managed by Entities.
+    return;
+  }
+
+  remove_detector(shared_entity);
+  add_detector(shared_entity);
+}
+
+/**
+ * \brief Returns the detector index where an entity belongs
+ * according to its layer.
+ * \param entity An entity.
+ * \return The detector quadtree for this entity.
+ */
+EntityTree& Entities::get_detector_tree(const Entity& entity) {
+
+  if (entity.has_layer_independent_collisions()) {
+    return layer_independent_detectors;
+  }
+  return *detectors.at(entity.get_layer());
+}
+
+/**
+ * \brief Adds an entity to the detector index if it is a detector.
+ * \param entity An entity already in the main quadtree.
+ */
+void Entities::add_detector(const EntityPtr& entity) {
+
+  if (!entity->is_detector()) {
+    return;
+  }
+
+  get_detector_tree(*entity).add(entity, entity->get_max_bounding_box());
+}
+
+/**
+ * \brief Removes an entity from the detector index.
+ *
+ * Does nothing if the entity is not there.
+ *
+ * \param entity An entity.
+ */
+void Entities::remove_detector(const EntityPtr& entity) {
+
+  // Its layer or collision modes may have changed since it was added:
+  // look everywhere.
+  if (layer_independent_detectors.remove(entity)) {
+    return;
+  }
+  for (const auto& kvp : detectors) {
+    if (kvp.second->remove(entity)) {
+      return;
+    }
+  }
 }
 
 /**
@@ -1405,6 +1809,28 @@ void Entities::ZCache::add(const ConstEntityPtr& entity) {
   z_values.insert(std::make_pair(entity, max));
 }
 
+/**
+ * \brief Adds an entity to the structure with a Z order reserved earlier.
+ * \param entity The entity to add.
+ * \param z A Z order returned by reserve().
+ */
+void Entities::ZCache::add(const ConstEntityPtr& entity, int z) {
+
+  z_values.insert(std::make_pair(entity, z));
+}
+
+/**
+ * \brief Reserves a Z order for an entity that will be added later.
+ *
+ * Entities added after this call will be above it.
+ *
+ * \return The reserved Z order.
+ */
+int Entities::ZCache::reserve() {
+
+  return ++max;
+}
+
 /**
  * \brief Removes an entity from the structure.
  *
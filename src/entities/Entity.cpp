@@ -584,6 +584,9 @@ int Entity::get_layer() const {
 void Entity::set_layer(int layer) {
 
   this->layer = layer;
+  if (is_on_map()) {
+    get_entities().notify_entity_detector_changed(*this);
+  }
   notify_layer_changed();
 }
 
@@ -1767,7 +1770,11 @@ void Entity::set_collision_modes(int collision_modes) {
   if (collision_modes & CollisionMode::COLLISION_SPRITE) {
     enable_pixel_collisions();
   }
+  const bool was_detector = is_detector();
   this->collision_modes = collision_modes;
+  if (is_detector() != was_detector && is_on_map()) {
+    get_entities().notify_entity_detector_changed(*this);
+  }
 }
 
 /**
@@ -1816,7 +1823,15 @@ bool Entity::has_layer_independent_collisions() const {
  * that are on another layer.
  */
 void Entity::set_layer_independent_collisions(bool independent) {
+
+  if (independent == layer_independent_collisions) {
+    return;
+  }
+
   this->layer_independent_collisions = independent;
+  if (is_on_map()) {
+    get_entities().notify_entity_detector_changed(*this);
+  }
 }
 
 /**
@@ -2336,8 +2351,25 @@ const Point& Entity::direction_to_xy_move(int direction8) {
  */
 void Entity::set_enabled(bool enabled) {
 
+  if (set_enabled_state(enabled)) {
+    notify_enabled(enabled);
+  }
+}
+
+/**
+ * \brief Enables or disables this entity without calling notify_enabled().
+ *
+ * Its movement, sprites and timers are suspended or resumed accordingly.
+ * This is useful to change several entities at once before notifying them.
+ * The caller is then responsible for calling notify_enabled().
+ *
+ * \param enabled true to enable the entity, false to disable it
+ * \return \c true if the enabled state changed.
+ */
+bool Entity::set_enabled_state(bool enabled) {
+
   if (this->enabled == enabled) {
-    return;
+    return false;
   }
 
   if (enabled) {
@@ -2368,7 +2400,6 @@ void Entity::set_enabled(bool enabled) {
         get_lua_context()->set_entity_timers_suspended(*this, false);
       }
     }
-    notify_enabled(true);
   }
   else {
     this->enabled = false;
@@ -2392,8 +2423,8 @@ void Entity::set_enabled(bool enabled) {
         get_lua_context()->set_entity_timers_suspended(*this, true);
       }
     }
-    notify_enabled(false);
   }
+  return true;
 }
 
 /**
@@ -3504,9 +3535,14 @@ void Entity::update() {
   }
   clear_old_sprites();
 
-  // Update the movement.
+  // Update the movement, unless Entities already did it in a batch.
   if (movement != nullptr) {
-    movement->update();
+    if (movement->is_updated_in_batch()) {
+      movement->set_updated_in_batch(false);
+    }
+    else {
+      movement->update();
+    }
   }
   clear_old_movements();
   if (stream_action != nullptr) {
@@ -143,6 +143,22 @@ bool TilePattern::is_drawn_at_its_position() const {
   return true;
 }
 
+/**
+ * \brief Returns after how many frames of animated tile patterns this tile
+ * pattern is drawn the same way again.
+ *
+ * This allows to cache the drawing of tiles whose appearance only depends on
+ * the frame counter of AnimatedTilePattern.
+ * Returns 1 for non-animated tile patterns and 0 for animated ones by
+ * default.
+ *
+ * \return The period in animation frames, or 0 if the appearance of this
+ * tile pattern depends on something else, like the time or the viewport.
+ */
+int TilePattern::get_frame_period() const {
+  return is_animated() ? 0 : 1;
+}
+
 /**
  * \brief Fills a rectangle by repeating this tile pattern.
  * \param dst_surface The destination surface.
@@ -38,7 +38,8 @@ namespace Solarus {
 Surface::Surface(int width, int height):
   Drawable(),
   internal_surface(nullptr),
-  opacity(255) {
+  opacity(255),
+  opaque_state(OpaqueState::UNKNOWN) {
 
   Debug::check_assertion(width > 0 && height > 0,
       "Attempt to create a surface with an empty size");
@@ -71,7 +72,8 @@ Surface::Surface(int width, int height):
 Surface::Surface(SDL_Surface* internal_surface):
   Drawable(),
   internal_surface(internal_surface),
-  opacity(255) {
+  opacity(255),
+  opaque_state(OpaqueState::UNKNOWN) {
 
   // Convert to the preferred pixel format.
   SDL_PixelFormat* pixel_format = Video::get_pixel_format();
@@ -173,12 +175,11 @@ SDL_Surface* Surface::get_surface_from_file(
     return nullptr;
   }
 
-  const std::string& buffer = QuestFiles::data_file_read(prefixed_file_name, language_specific);
-  SDL_RWops* rw = SDL_RWFromMem(const_cast<char*>(buffer.data()), (int) buffer.size());
+  SDL_RWops* rw = QuestFiles::data_file_open_rw(prefixed_file_name, language_specific);
+  Debug::check_assertion(rw != nullptr,
+      std::string("Cannot open image '") + prefixed_file_name + "'");
 
-  SDL_Surface* surface = IMG_Load_RW(rw, 0);
-
-  SDL_RWclose(rw);
+  SDL_Surface* surface = IMG_Load_RW(rw, 1);  // Also closes rw.
 
   Debug::check_assertion(surface != nullptr,
       std::string("Cannot load image '") + prefixed_file_name + "'");
@@ -256,6 +257,9 @@ void Surface::set_opacity(uint8_t opacity) {
  * \return The internal SDL surface.
  */
 SDL_Surface* Surface::get_internal_surface() {
+
+  // The caller may modify pixels.
+  notify_pixels_changed();
   return internal_surface.get();
 }
 
@@ -268,64 +272,113 @@ SDL_Surface* Surface::get_internal_surface() {
  */
 std::string Surface::get_pixels() const {
 
-  const int num_pixels = get_width() * get_height();
+  return get_pixels(Rectangle(Point(0, 0), get_size()));
+}
+
+/**
+ * \brief Returns a buffer of the raw pixels of a region of this surface.
+ *
+ * Pixels returned have the RGBA 32-bit format, row by row, without padding.
+ *
+ * \param region The region to read. It must be inside the surface.
+ * \return The pixel buffer.
+ */
+std::string Surface::get_pixels(const Rectangle& region) const {
+
+  Debug::check_assertion(is_region_valid(region),
+      "Pixel region is outside the surface");
 
-  if (internal_surface->format->format == SDL_PIXELFORMAT_ABGR8888) {
-    // No conversion needed.
-    const char* buffer = static_cast<const char*>(internal_surface->pixels);
-    return std::string(buffer, num_pixels * 4);
+  const int width = region.get_width();
+  const int height = region.get_height();
+  std::string buffer(width * height * 4, '\0');
+  if (buffer.empty()) {
+    return buffer;
   }
 
-  // Convert to RGBA format.
-  SDL_PixelFormat* format = SDL_AllocFormat(SDL_PIXELFORMAT_ABGR8888);  // TODO keep this object
-  SDL_Surface_UniquePtr converted_surface(SDL_ConvertSurface(
-      internal_surface.get(),
-      format,
-      0
-  ));
-  SDL_FreeFormat(format);
-  Debug::check_assertion(converted_surface != nullptr,
-      std::string("Failed to convert pixels to RGBA format") + SDL_GetError());
-  const char* buffer = static_cast<const char*>(converted_surface->pixels);
-  return std::string(buffer, num_pixels * 4);
+  // Convert to RGBA format directly into the buffer.
+  const SDL_Surface& surface = *internal_surface;
+  const char* pixels = static_cast<const char*>(surface.pixels) +
+      region.get_y() * surface.pitch +
+      region.get_x() * surface.format->BytesPerPixel;
+  const int result = SDL_ConvertPixels(
+      width,
+      height,
+      surface.format->format,
+      pixels,
+      surface.pitch,
+      SDL_PIXELFORMAT_ABGR8888,
+      &buffer[0],
+      width * 4
+  );
+  Debug::check_assertion(result == 0,
+      std::string("Failed to convert pixels to RGBA format: ") + SDL_GetError());
+  return buffer;
 }
 
 /**
- * @brief Set pixels of this surface from a RGBA buffer
- * @param buffer a string considerer as array of bytes with pixels in RGBA
+ * \brief Sets the pixels of this surface from a RGBA buffer.
+ * \param buffer A string considered as an array of bytes with pixels in RGBA.
+ * Its size must be 4 bytes per pixel of the surface.
  */
 void Surface::set_pixels(const std::string& buffer) {
 
-    if (internal_surface->format->format == SDL_PIXELFORMAT_ABGR8888) {
-      // No conversion needed.
-      char* pixels = static_cast<char*>(internal_surface->pixels);
-      std::copy(buffer.begin(), buffer.end(), pixels);
-      return;
-    }
+  set_pixels(buffer, Rectangle(Point(0, 0), get_size()));
+}
 
-    SDL_PixelFormat* format_rgba = SDL_AllocFormat(SDL_PIXELFORMAT_ABGR8888); // TODO keep this object :)
-    SDL_Surface_UniquePtr rgba_surf(SDL_CreateRGBSurfaceFrom(
-          const_cast<char*>(buffer.data()),
-          get_width(),
-          get_height(),
-          format_rgba->BitsPerPixel,
-          format_rgba->BytesPerPixel * get_width(),
-          format_rgba->Rmask,
-          format_rgba->Gmask,
-          format_rgba->Bmask,
-          format_rgba->Amask
-      ));
-    SDL_FreeFormat(format_rgba);
-    // Convert from RGBA.
-    SDL_PixelFormat* pixel_format = Video::get_pixel_format();
-    SDL_Surface_UniquePtr converted_surf(SDL_ConvertSurface(
-         rgba_surf.get(),
-         pixel_format,
-         0
-    ));
-    internal_surface = std::move(converted_surf);
-    SDL_SetSurfaceAlphaMod(internal_surface.get(), opacity);  // Re-apply the alpha.
-    SDL_SetSurfaceBlendMode(internal_surface.get(), SDL_BLENDMODE_BLEND);
+/**
+ * \brief Sets the pixels of a region of this surface from a RGBA buffer.
+ * \param buffer A string considered as an array of bytes with pixels in RGBA,
+ * row by row, without padding. Its size must be 4 bytes per pixel of the
+ * region.
+ * \param region The region to write. It must be inside the surface.
+ */
+void Surface::set_pixels(const std::string& buffer, const Rectangle& region) {
+
+  Debug::check_assertion(is_region_valid(region),
+      "Pixel region is outside the surface");
+
+  const int width = region.get_width();
+  const int height = region.get_height();
+  Debug::check_assertion(buffer.size() == static_cast<size_t>(width * height * 4),
+      "Wrong pixel buffer size");
+  if (buffer.empty()) {
+    return;
+  }
+
+  // Convert from RGBA format directly into the surface.
+  SDL_Surface& surface = *internal_surface;
+  char* pixels = static_cast<char*>(surface.pixels) +
+      region.get_y() * surface.pitch +
+      region.get_x() * surface.format->BytesPerPixel;
+  const int result = SDL_ConvertPixels(
+      width,
+      height,
+      SDL_PIXELFORMAT_ABGR8888,
+      buffer.data(),
+      width * 4,
+      surface.format->format,
+      pixels,
+      surface.pitch
+  );
+  Debug::check_assertion(result == 0,
+      std::string("Failed to convert pixels from RGBA format: ") + SDL_GetError());
+  notify_pixels_changed();
+}
+
+/**
+ * \brief Returns whether a rectangle is a valid region of this surface.
+ * \param region The rectangle to check.
+ * \return \c true if the region has a non-negative size and is entirely
+ * inside the surface.
+ */
+bool Surface::is_region_valid(const Rectangle& region) const {
+
+  return region.get_x() >= 0 &&
+      region.get_y() >= 0 &&
+      region.get_width() >= 0 &&
+      region.get_height() >= 0 &&
+      region.get_x() + region.get_width() <= get_width() &&
+      region.get_y() + region.get_height() <= get_height();
 }
 
 /**
@@ -336,6 +389,7 @@ void Surface::set_pixels(const std::string& buffer) {
  */
 void Surface::clear() {
 
+  notify_pixels_changed();
   SDL_FillRect(
       internal_surface.get(),
       nullptr,
@@ -353,6 +407,7 @@ void Surface::clear() {
  */
 void Surface::clear(const Rectangle& where) {
 
+  notify_pixels_changed();
   SDL_FillRect(
       internal_surface.get(),
       where.get_internal_rect(),
@@ -383,6 +438,8 @@ void Surface::fill_with_color(const Color& color) {
  */
 void Surface::fill_with_color(const Color& color, const Rectangle& where) {
 
+  notify_pixels_changed();
+
   if (color.get_alpha() == 255) {
     // Opaque color: directly replace the pixel values.
     SDL_FillRect(internal_surface.get(), where.get_internal_rect(), get_color_value(color));
@@ -438,9 +495,16 @@ void Surface::raw_draw_region(
     Surface& dst_surface,
     const Point& dst_position) {
 
+  SDL_BlendMode blend_mode = get_sdl_blend_mode();
+  if (blend_mode == SDL_BLENDMODE_BLEND && opacity == 255 && is_opaque()) {
+    // Blending opaque pixels is the same as copying them, which is faster.
+    blend_mode = SDL_BLENDMODE_NONE;
+  }
+
+  dst_surface.notify_pixels_changed();
   SDL_SetSurfaceBlendMode(
         this->internal_surface.get(),
-        get_sdl_blend_mode()
+        blend_mode
   );
   SDL_BlitSurface(
       this->internal_surface.get(),
@@ -485,6 +549,7 @@ void Surface::apply_pixel_filter(
   Debug::check_assertion(dst_internal_surface != nullptr,
       "Missing software destination surface for pixel filter");
 
+  dst_surface.notify_pixels_changed();
   SDL_LockSurface(src_internal_surface);
   SDL_LockSurface(dst_internal_surface);
 
@@ -506,6 +571,55 @@ Surface& Surface::get_transition_surface() {
   return *this;
 }
 
+/**
+ * \brief Returns whether all pixels of this surface are opaque.
+ *
+ * The result is computed the first time and kept until pixels change.
+ * The opacity property of the surface is not taken into account.
+ *
+ * \return \c true if the surface has no transparent or translucent pixel.
+ */
+bool Surface::is_opaque() const {
+
+  if (opaque_state != OpaqueState::UNKNOWN) {
+    return opaque_state == OpaqueState::OPAQUE;
+  }
+
+  opaque_state = OpaqueState::NOT_OPAQUE;
+  SDL_Surface* surface = internal_surface.get();
+  uint32_t colorkey;
+  if (surface->format->BytesPerPixel != 4 ||
+      SDL_GetColorKey(surface, &colorkey) == 0) {
+    return false;
+  }
+
+  const uint32_t alpha_mask = surface->format->Amask;
+  if (alpha_mask != 0) {
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; ++y) {
+      const uint32_t* row = reinterpret_cast<const uint32_t*>(
+          static_cast<const uint8_t*>(surface->pixels) + y * surface->pitch);
+      for (int x = 0; x < surface->w; ++x) {
+        if ((row[x] & alpha_mask) != alpha_mask) {
+          SDL_UnlockSurface(surface);
+          return false;
+        }
+      }
+    }
+    SDL_UnlockSurface(surface);
+  }
+
+  opaque_state = OpaqueState::OPAQUE;
+  return true;
+}
+
+/**
+ * \brief Notifies this surface that its pixels may have changed.
+ */
+void Surface::notify_pixels_changed() {
+  opaque_state = OpaqueState::UNKNOWN;
+}
+
 /**
  * \brief Returns a pixel value of this surface.
  *
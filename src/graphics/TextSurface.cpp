@@ -27,10 +27,97 @@
 #include "solarus/lua/LuaContext.h"
 #include "solarus/lua/LuaTools.h"
 #include <lua.hpp>
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace Solarus {
 
+namespace {
+
+/**
+ * \brief Decodes a character of a UTF-8 string.
+ * \param text The string.
+ * \param[in,out] i Index of the first byte of the character.
+ * Set to the index of the next character.
+ * \return The code point, or a value outside the Unicode range if the
+ * string is malformed.
+ */
+uint32_t decode_utf8(const std::string& text, size_t& i) {
+
+  const uint8_t first_byte = static_cast<uint8_t>(text[i]);
+  ++i;
+
+  int num_continuation_bytes = 0;
+  uint32_t code_point = 0;
+  if (first_byte < 0x80) {
+    return first_byte;
+  }
+  else if ((first_byte & 0xE0) == 0xC0) {
+    num_continuation_bytes = 1;
+    code_point = first_byte & 0x1F;
+  }
+  else if ((first_byte & 0xF0) == 0xE0) {
+    num_continuation_bytes = 2;
+    code_point = first_byte & 0x0F;
+  }
+  else if ((first_byte & 0xF8) == 0xF0) {
+    num_continuation_bytes = 3;
+    code_point = first_byte & 0x07;
+  }
+  else {
+    return 0xFFFFFFFF;
+  }
+
+  for (int j = 0; j < num_continuation_bytes; ++j) {
+    if (i >= text.size() || (text[i] & 0xC0) != 0x80) {
+      return 0xFFFFFFFF;
+    }
+    code_point = (code_point << 6) | (text[i] & 0x3F);
+    ++i;
+  }
+  return code_point;
+}
+
+/**
+ * \brief Copies the pixels of a surface onto another one of the same format,
+ * keeping the most opaque pixel where they overlap.
+ *
+ * This is how SDL_ttf merges glyphs that overlap in a string.
+ *
+ * \param src_surface The surface to copy.
+ * \param dst_surface The destination surface.
+ * \param x X coordinate in the destination surface.
+ */
+void merge_pixels(SDL_Surface& src_surface, SDL_Surface& dst_surface, int x) {
+
+  const uint32_t alpha_mask = dst_surface.format->Amask;
+  const int x_start = std::max(0, -x);
+  const int x_end = std::min(src_surface.w, dst_surface.w - x);
+  const int height = std::min(src_surface.h, dst_surface.h);
+
+  SDL_LockSurface(&src_surface);
+  SDL_LockSurface(&dst_surface);
+  for (int j = 0; j < height; ++j) {
+    const uint32_t* src_row = reinterpret_cast<const uint32_t*>(
+        static_cast<const uint8_t*>(src_surface.pixels) + j * src_surface.pitch);
+    uint32_t* dst_row = reinterpret_cast<uint32_t*>(
+        static_cast<uint8_t*>(dst_surface.pixels) + j * dst_surface.pitch);
+    for (int i = x_start; i < x_end; ++i) {
+      const uint32_t src_pixel = src_row[i];
+      uint32_t& dst_pixel = dst_row[x + i];
+      if ((src_pixel & alpha_mask) > (dst_pixel & alpha_mask)) {
+        dst_pixel = src_pixel;
+      }
+    }
+  }
+  SDL_UnlockSurface(&dst_surface);
+  SDL_UnlockSurface(&src_surface);
+}
+
+}  // Anonymous namespace.
+
 /**
  * \brief Creates a text to draw with the default properties.
  *
@@ -70,7 +157,8 @@ TextSurface::TextSurface(int x, int y,
   x(x),
   y(y),
   surface(nullptr),
-  text() {
+  text(),
+  num_chars(0) {
 
   if (font_id.empty()) {
     Debug::error("This quest has no fonts");
@@ -121,7 +209,7 @@ void TextSurface::set_horizontal_alignment(HorizontalAlignment horizontal_alignm
 
   this->horizontal_alignment = horizontal_alignment;
 
-  rebuild();
+  update_text_position();
 }
 
 /**
@@ -146,7 +234,7 @@ void TextSurface::set_vertical_alignment(VerticalAlignment vertical_alignment) {
 
   this->vertical_alignment = vertical_alignment;
 
-  rebuild();
+  update_text_position();
 }
 
 /**
@@ -167,7 +255,7 @@ void TextSurface::set_alignment(HorizontalAlignment horizontal_alignment,
   this->horizontal_alignment = horizontal_alignment;
   this->vertical_alignment = vertical_alignment;
 
-  rebuild();
+  update_text_position();
 }
 
 /**
@@ -249,7 +337,7 @@ void TextSurface::set_position(int x, int y) {
 
   this->x = x;
   this->y = y;
-  rebuild();
+  update_text_position();
 }
 
 /**
@@ -271,7 +359,7 @@ void TextSurface::set_x(int x) {
   }
 
   this->x = x;
-  rebuild();
+  update_text_position();
 }
 
 /**
@@ -293,7 +381,7 @@ void TextSurface::set_y(int y) {
   }
 
   this->y = y;
-  rebuild();
+  update_text_position();
 }
 
 /**
@@ -330,6 +418,28 @@ void TextSurface::set_text(const std::string& text) {
     return;
   }
 
+  if (surface != nullptr &&
+      text.size() > this->text.size() &&
+      text.compare(0, this->text.size(), this->text) == 0 &&
+      (text[this->text.size()] & 0xC0) != 0x80) {
+    // Characters are appended: only draw the new ones.
+    const std::string chars = text.substr(this->text.size());
+    bool appended = false;
+    if (FontResource::is_bitmap_font(font_id)) {
+      append_bitmap(chars);
+      appended = true;
+    }
+    else if (glyph_layout.valid) {
+      appended = append_ttf(chars);
+    }
+
+    if (appended) {
+      this->text = text;
+      update_text_position();
+      return;
+    }
+  }
+
   this->text = text;
   rebuild();
 }
@@ -409,6 +519,21 @@ void TextSurface::rebuild() {
     rebuild_ttf();
   }
 
+  update_text_position();
+}
+
+/**
+ * \brief Computes the position of the text surface from the alignment.
+ *
+ * This function is called when the position or the alignment changes,
+ * which does not require to draw the text again.
+ */
+void TextSurface::update_text_position() {
+
+  if (surface == nullptr) {
+    return;
+  }
+
   // calculate the coordinates of the top-left corner
   int x_left = 0, y_top = 0;
 
@@ -452,15 +577,29 @@ void TextSurface::rebuild() {
  */
 void TextSurface::rebuild_bitmap() {
 
+  num_chars = 0;
+  append_bitmap(text);
+}
+
+/**
+ * \brief Draws characters after the current text in the case of a bitmap
+ * font.
+ *
+ * The text surface is replaced by a larger one.
+ *
+ * \param chars The characters to add, in UTF-8.
+ */
+void TextSurface::append_bitmap(const std::string& chars) {
+
   // First count the number of characters in the UTF-8 string.
-  int num_chars = 0;
-  for (unsigned i = 0; i < text.size(); i++) {
-    char current_char = text[i];
+  int num_new_chars = 0;
+  for (unsigned i = 0; i < chars.size(); i++) {
+    char current_char = chars[i];
     if ((current_char & 0xE0) == 0xC0) {
       // This character uses two bytes.
       ++i;
     }
-    ++num_chars;
+    ++num_new_chars;
   }
 
   // Determine the letter size from the surface size.
@@ -469,12 +608,16 @@ void TextSurface::rebuild_bitmap() {
   int char_width = bitmap_size.width / 128;
   int char_height = bitmap_size.height / 16;
 
-  surface = Surface::create((char_width - 1) * num_chars + 1, char_height);
+  SurfacePtr previous_surface = surface;
+  surface = Surface::create((char_width - 1) * (num_chars + num_new_chars) + 1, char_height);
+  if (previous_surface != nullptr) {
+    merge_pixels(*previous_surface->get_internal_surface(), *surface->get_internal_surface(), 0);
+  }
 
   // Traverse the string again to draw the characters.
-  Point dst_position;
-  for (unsigned i = 0; i < text.size(); i++) {
-    char first_byte = text[i];
+  Point dst_position((char_width - 1) * num_chars, 0);
+  for (unsigned i = 0; i < chars.size(); i++) {
+    char first_byte = chars[i];
     Rectangle src_position(0, 0, char_width, char_height);
     if ((first_byte & 0xE0) != 0xC0) {
       // This character uses one byte.
@@ -483,7 +626,7 @@ void TextSurface::rebuild_bitmap() {
     else {
       // This character uses two bytes.
       ++i;
-      char second_byte = text[i];
+      char second_byte = chars[i];
       uint16_t code_point = ((first_byte & 0x1F) << 6) | (second_byte & 0x3F);
       src_position.set_xy((code_point % 128) * char_width,
           (code_point / 128) * char_height);
@@ -491,6 +634,7 @@ void TextSurface::rebuild_bitmap() {
     bitmap->draw_region(src_position, surface, dst_position);
     dst_position.x += char_width - 1;
   }
+  num_chars += num_new_chars;
 }
 
 /**
@@ -500,7 +644,13 @@ void TextSurface::rebuild_bitmap() {
  */
 void TextSurface::rebuild_ttf() {
 
-  // create the text surface
+  // Compose the text from cached glyphs if possible.
+  glyph_layout = GlyphLayout();
+  if (append_ttf(text)) {
+    return;
+  }
+
+  // Otherwise, let SDL_ttf render the whole text.
 
   SDL_Surface* internal_surface = nullptr;
   TTF_Font& internal_font = FontResource::get_outline_font(font_id, font_size);
@@ -527,6 +677,76 @@ void TextSurface::rebuild_ttf() {
   surface = std::make_shared<Surface>(internal_surface);
 }
 
+/**
+ * \brief Draws characters after the current text in the case of a normal
+ * font.
+ *
+ * Characters are copied from the glyph atlas of the font and the text
+ * surface is replaced by a larger one.
+ *
+ * \param chars The characters to add, in UTF-8.
+ * \return \c false if the characters cannot be composed from glyphs.
+ * The text surface is then unchanged and has to be rendered by SDL_ttf.
+ */
+bool TextSurface::append_ttf(const std::string& chars) {
+
+  FontResource::GlyphAtlasPtr atlas = FontResource::get_glyph_atlas(
+      font_id,
+      font_size,
+      rendering_mode == RenderingMode::ANTIALIASING,
+      text_color
+  );
+
+  // Lay out the new characters after the current ones.
+  GlyphLayout layout = glyph_layout;
+  std::vector<std::pair<const FontResource::Glyph*, int>> glyphs;
+  size_t i = 0;
+  while (i < chars.size()) {
+    uint32_t code_point = decode_utf8(chars, i);
+    const FontResource::Glyph* glyph = atlas->get_glyph(code_point);
+    if (glyph == nullptr) {
+      return false;
+    }
+    layout.pen_x += atlas->get_kerning(layout.last_code_point, code_point);
+    const int glyph_x = layout.pen_x + glyph->min_x;
+    layout.min_x = std::min(layout.min_x, glyph_x);
+    layout.max_x = std::max(layout.max_x, layout.pen_x + glyph->max_x);
+    glyphs.emplace_back(glyph, glyph_x);
+    layout.pen_x += glyph->advance;
+    layout.last_code_point = code_point;
+  }
+
+  if (surface != nullptr && layout.min_x != glyph_layout.min_x) {
+    // The text would grow to the left.
+    return false;
+  }
+
+  const int width = layout.max_x - layout.min_x;
+  const int height = atlas->get_height();
+  if (width <= 0 || height <= 0) {
+    return false;
+  }
+
+  SurfacePtr previous_surface = surface;
+  surface = Surface::create(width, height);
+  if (previous_surface != nullptr) {
+    merge_pixels(*previous_surface->get_internal_surface(), *surface->get_internal_surface(), 0);
+  }
+  for (const auto& glyph : glyphs) {
+    if (glyph.first->image != nullptr) {
+      merge_pixels(
+          *glyph.first->image->get_internal_surface(),
+          *surface->get_internal_surface(),
+          glyph.second - layout.min_x
+      );
+    }
+  }
+
+  glyph_layout = layout;
+  glyph_layout.valid = true;
+  return true;
+}
+
 /**
  * \brief Draws the text on a surface.
  *
@@ -16,6 +16,7 @@
  */
 #include "solarus/audio/Sound.h"
 #include "solarus/audio/Music.h"
+#include "solarus/core/CurrentQuest.h"
 #include "solarus/lua/LuaContext.h"
 #include "solarus/lua/LuaTools.h"
 #include <lua.hpp>
@@ -33,7 +34,7 @@ const std::string LuaContext::audio_module_name = "sol.audio";
  */
 void LuaContext::register_audio_module() {
 
-  const std::vector<luaL_Reg> functions = {
+  std::vector<luaL_Reg> functions = {
       { "get_sound_volume", audio_api_get_sound_volume },
       { "set_sound_volume", audio_api_set_sound_volume },
       { "play_sound", audio_api_play_sound },
@@ -50,6 +51,11 @@ void LuaContext::register_audio_module() {
       { "get_music_tempo", audio_api_get_music_tempo },
       { "set_music_tempo", audio_api_set_music_tempo }
   };
+  if (CurrentQuest::is_format_at_least({ 1, 6 })) {
+    functions.insert(functions.end(), {
+        { "get_sound_voices", audio_api_get_sound_voices }
+    });
+  }
   register_functions(audio_module_name, functions);
 }
 
@@ -91,10 +97,12 @@ int LuaContext::audio_api_play_sound(lua_State* l) {
   return LuaTools::exception_boundary_handle(l, [&] {
     const std::string& sound_id = LuaTools::check_string(l, 1);
 
+    int priority = LuaTools::opt_int(l, 2, 0);
+
     if (!Sound::exists(sound_id)) {
       LuaTools::error(l, std::string("No such sound: '") + sound_id + "'");
     }
-    Sound::play(sound_id);
+    Sound::play(sound_id, priority);
 
     return 0;
   });
@@ -113,6 +121,20 @@ int LuaContext::audio_api_preload_sounds(lua_State* l) {
   });
 }
 
+/**
+ * \brief Implementation of sol.audio.get_sound_voices().
+ * \param l the Lua context that is calling this function
+ * \return number of values to return to Lua
+ */
+int LuaContext::audio_api_get_sound_voices(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    lua_pushinteger(l, Sound::get_num_voices_playing());
+    lua_pushinteger(l, Sound::get_num_voices());
+    return 2;
+  });
+}
+
 /**
  * \brief Implementation of sol.audio.get_music_volume().
  * \param l the Lua context that is calling this function
@@ -49,6 +49,8 @@ void LuaContext::register_game_module() {
   // Methods of the game type.
   const std::vector<luaL_Reg> methods = {
       { "save", game_api_save },
+      { "get_save_format", game_api_get_save_format },
+      { "set_save_format", game_api_set_save_format },
       { "start", game_api_start },
       { "is_started", game_api_is_started },
       { "is_suspended", game_api_is_suspended },
@@ -114,6 +116,13 @@ void LuaContext::register_game_module() {
   };
 
   register_type(game_module_name, functions, methods, metamethods);
+
+  // Create the table that caches savegame keys of Lua strings.
+                                  // ...
+  lua_newtable(l);
+                                  // ... keys
+  lua_setfield(l, LUA_REGISTRYINDEX, "sol.savegame_keys");
+                                  // ...
 }
 
 /**
@@ -139,6 +148,105 @@ std::shared_ptr<Savegame> LuaContext::check_game(lua_State* l, int index) {
   ));
 }
 
+/**
+ * \brief Checks that the value at the specified index of the stack is a
+ * valid savegame variable name and returns its key.
+ *
+ * The name is interned if it is new: only use this function for names of
+ * values about to be stored. Use find_savegame_key() for lookups.
+ *
+ * \param l A Lua context.
+ * \param index An index in the stack.
+ * \return The savegame key.
+ */
+SavegameKey LuaContext::check_savegame_key(lua_State* l, int index) {
+
+  SavegameKey key;
+  if (find_savegame_key(l, index, key)) {
+    return key;
+  }
+
+  // New name, already validated by find_savegame_key().
+  key = SavegameKey(LuaTools::check_string(l, index));
+  cache_savegame_key(l, index, key);
+  return key;
+}
+
+/**
+ * \brief Checks that the value at the specified index of the stack is a
+ * valid savegame variable name and gets its key if it was already interned.
+ *
+ * Keys are cached by Lua string, so after the first call with a given name,
+ * no C++ string is built and no name is hashed again.
+ * Names never interned are neither interned nor cached:
+ * no savegame can have a value for them.
+ *
+ * \param[in] l A Lua context.
+ * \param[in] index An index in the stack.
+ * \param[out] key The savegame key if the name was already interned.
+ * \return \c true if the name was already interned.
+ */
+bool LuaContext::find_savegame_key(lua_State* l, int index, SavegameKey& key) {
+
+  if (lua_type(l, index) == LUA_TSTRING) {
+    lua_getfield(l, LUA_REGISTRYINDEX, "sol.savegame_keys");
+                                  // ... keys
+    lua_pushvalue(l, index);
+                                  // ... keys name
+    lua_rawget(l, -2);
+                                  // ... keys key_index/nil
+    if (lua_isnumber(l, -1)) {
+      const size_t key_index = static_cast<size_t>(lua_tointeger(l, -1));
+      lua_pop(l, 2);
+                                  // ...
+      key = SavegameKey::from_index(key_index);
+      return true;
+    }
+    lua_pop(l, 2);
+                                  // ...
+  }
+
+  const std::string& name = LuaTools::check_string(l, index);
+  if (!LuaTools::is_valid_lua_identifier(name)) {
+    LuaTools::arg_error(l, index,
+        std::string("Invalid savegame variable '") + name
+        + "': the name should only contain alphanumeric characters or '_'"
+        + " and cannot start with a digit");
+  }
+
+  if (!SavegameKey::find(name, key)) {
+    return false;
+  }
+
+  cache_savegame_key(l, index, key);
+  return true;
+}
+
+/**
+ * \brief Remembers the savegame key of a Lua string.
+ * \param l A Lua context.
+ * \param index Index of the name in the stack.
+ * Nothing is cached if it is not a string.
+ * \param key The key of this name.
+ */
+void LuaContext::cache_savegame_key(lua_State* l, int index, const SavegameKey& key) {
+
+  if (lua_type(l, index) != LUA_TSTRING) {
+    return;
+  }
+
+  lua_getfield(l, LUA_REGISTRYINDEX, "sol.savegame_keys");
+                                  // ... keys
+  lua_pushvalue(l, index);
+                                  // ... keys name
+  lua_pushinteger(l, static_cast<lua_Integer>(key.get_index()));
+                                  // ... keys name key_index
+  lua_rawset(l, -3);
+                                  // ... keys
+  lua_pop(l, 1);
+                                  // ...
+}
+
 /**
  * \brief Pushes a game userdata onto the stack.
  * \param l A Lua context.
@@ -233,6 +341,38 @@ int LuaContext::game_api_save(lua_State* l) {
   });
 }
 
+/**
+ * \brief Implementation of game:get_save_format().
+ * \param l The Lua context that is calling this function.
+ * \return Number of values to return to Lua.
+ */
+int LuaContext::game_api_get_save_format(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    const Savegame& savegame = *check_game(l, 1);
+
+    push_string(l, enum_to_name(savegame.get_format()));
+    return 1;
+  });
+}
+
+/**
+ * \brief Implementation of game:set_save_format().
+ * \param l The Lua context that is calling this function.
+ * \return Number of values to return to Lua.
+ */
+int LuaContext::game_api_set_save_format(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    Savegame& savegame = *check_game(l, 1);
+    SavegameFormat format = LuaTools::check_enum<SavegameFormat>(l, 2);
+
+    savegame.set_format(format);
+
+    return 0;
+  });
+}
+
 /**
  * \brief Implementation of game:start().
  * \param l The Lua context that is calling this function.
@@ -611,13 +751,11 @@ int LuaContext::game_api_get_value(lua_State* l) {
 
   return LuaTools::exception_boundary_handle(l, [&] {
     Savegame& savegame = *check_game(l, 1);
-    const std::string& key = LuaTools::check_string(l, 2);
-
-    if (!LuaTools::is_valid_lua_identifier(key)) {
-      LuaTools::arg_error(l, 3,
-          std::string("Invalid savegame variable '") + key
-          + "': the name should only contain alphanumeric characters or '_'"
-          + " and cannot start with a digit");
+    SavegameKey key;
+    if (!find_savegame_key(l, 2, key)) {
+      // Never stored by any savegame.
+      lua_pushnil(l);
+      return 1;
     }
 
     if (savegame.is_boolean(key)) {
@@ -646,19 +784,20 @@ int LuaContext::game_api_set_value(lua_State* l) {
 
   return LuaTools::exception_boundary_handle(l, [&] {
     Savegame& savegame = *check_game(l, 1);
-    const std::string& key = LuaTools::check_string(l, 2);
-
-    if (key[0] == '_') {
-      LuaTools::arg_error(l, 3,
-          std::string("Invalid savegame variable '") + key
+    const char* name = lua_tostring(l, 2);
+    if (name != nullptr && name[0] == '_') {
+      LuaTools::arg_error(l, 2,
+          std::string("Invalid savegame variable '") + name
           + "': names prefixed by '_' are reserved for built-in variables");
     }
 
-    if (!LuaTools::is_valid_lua_identifier(key)) {
-      LuaTools::arg_error(l, 3,
-          std::string("Invalid savegame variable '") + key
-          + "': the name should only contain alphanumeric characters or '_'"
-          + " and cannot start with a digit");
+    SavegameKey key;
+    if (!find_savegame_key(l, 2, key)) {
+      if (lua_isnil(l, 3)) {
+        // Never stored by any savegame: nothing to unset.
+        return 0;
+      }
+      key = check_savegame_key(l, 2);
     }
 
     switch (lua_type(l, 3)) {
@@ -53,7 +53,11 @@ std::map<lua_State*, LuaContext*> LuaContext::lua_contexts;
  */
 LuaContext::LuaContext(MainLoop& main_loop):
   l(nullptr),
-  main_loop(main_loop) {
+  main_loop(main_loop),
+  userdata_fields_revision(0),
+  movements_on_points_to_update(),
+  movements_on_points_stopped(0),
+  entity_vectors_unused() {
 
 }
 
@@ -578,8 +582,21 @@ bool LuaContext::userdata_has_metafield(
 
   // We avoid to push the userdata for performance.
   // Maybe the userdata does not even exist in the Lua side.
+  return metatable_has_field(userdata.get_lua_type_name(), key);
+}
+
+/**
+ * \brief Returns whether the metatable of a userdata type has the specified
+ * field.
+ * \param type_name Lua type name of the userdata, e.g. "sol.enemy".
+ * \param key String key to test.
+ * \return \c true if this key exists on the metatable of this type.
+ */
+bool LuaContext::metatable_has_field(
+    const std::string& type_name, const char* key) const {
+
                                   // ...
-  luaL_getmetatable(l, userdata.get_lua_type_name().c_str());
+  luaL_getmetatable(l, type_name.c_str());
                                   // ... meta
   lua_pushstring(l, key);
                                   // ... meta key
@@ -591,6 +608,20 @@ bool LuaContext::userdata_has_metafield(
   return found;
 }
 
+/**
+ * \brief Returns a number that changes whenever a string field is added to
+ * or removed from a userdata.
+ *
+ * This allows C++ code to cache which userdata define a callback and to
+ * refresh that cache only when needed.
+ * Fields of metatables are not tracked.
+ *
+ * \return The current revision of userdata fields.
+ */
+uint64_t LuaContext::get_userdata_fields_revision() const {
+  return userdata_fields_revision;
+}
+
 /**
  * \brief Gets a method of the object on top of the stack.
  *
@@ -1228,7 +1259,9 @@ void LuaContext::notify_userdata_destroyed(ExportableToLua& userdata) {
     }
     lua_pop(l, 1);
                                   // ...
-    get_lua_context(l).userdata_fields.erase(&userdata);
+    LuaContext& lua_context = get_lua_context(l);
+    lua_context.userdata_fields.erase(&userdata);
+    ++lua_context.userdata_fields_revision;
   }
 }
 
@@ -1251,6 +1284,7 @@ void LuaContext::userdata_close_lua() {
   }
   lua_pop(l, 1);
   userdata_fields.clear();
+  ++userdata_fields_revision;
 
   // Clear userdata tables.
   lua_pushnil(l);
@@ -1315,13 +1349,18 @@ int LuaContext::userdata_meta_newindex_as_table(lua_State* l) {
                                   // ... udata_tables udata_table
 
   if (lua_isstring(l, 2)) {
+    LuaContext& lua_context = get_lua_context(l);
     if (!lua_isnil(l, 3)) {
       // Add the key to the list of existing strings keys on this userdata.
-      get_lua_context(l).userdata_fields[userdata.get()].insert(lua_tostring(l, 2));
+      if (lua_context.userdata_fields[userdata.get()].insert(lua_tostring(l, 2)).second) {
+        ++lua_context.userdata_fields_revision;
+      }
     }
     else {
       // Assigning nil: remove the key from the list.
-      get_lua_context(l).userdata_fields[userdata.get()].erase(lua_tostring(l, 2));
+      if (lua_context.userdata_fields[userdata.get()].erase(lua_tostring(l, 2)) > 0) {
+        ++lua_context.userdata_fields_revision;
+      }
     }
   }
 
@@ -2212,6 +2251,26 @@ void LuaContext::on_obtained_treasure(const Treasure& treasure) {
   }
 }
 
+/**
+ * \brief Calls the on_snapshot() method of the object on top of the stack.
+ */
+void LuaContext::on_snapshot() {
+
+  if (find_method("on_snapshot")) {
+    call_function(1, 0, "on_snapshot");
+  }
+}
+
+/**
+ * \brief Calls the on_restore_snapshot() method of the object on top of the stack.
+ */
+void LuaContext::on_restore_snapshot() {
+
+  if (find_method("on_restore_snapshot")) {
+    call_function(1, 0, "on_restore_snapshot");
+  }
+}
+
 /**
  * \brief Calls the on_state_changed() method of the object on top of the stack.
  * \param state_name A name describing the new state.
@@ -17,6 +17,7 @@
 #include "solarus/core/Debug.h"
 #include "solarus/core/QuestFiles.h"
 #include "solarus/lua/LuaData.h"
+#include "solarus/lua/LuaDataCache.h"
 #include <lua.hpp>
 #include <cstdio>
 #include <fstream>
@@ -100,7 +101,21 @@ bool LuaData::import_from_quest_file(
   const std::string& buffer = QuestFiles::data_file_read(
       quest_file_name, language_specific
   );
-  return import_from_buffer(buffer, quest_file_name);
+  if (language_specific) {
+    return import_from_buffer(buffer, quest_file_name);
+  }
+
+  // Use the compiled chunk if the file was already parsed.
+  lua_State* l = luaL_newstate();
+  if (LuaDataCache::load_buffer(l, buffer, quest_file_name) != 0) {
+    Debug::error(std::string("Failed to load data file: ") + lua_tostring(l, -1));
+    lua_close(l);
+    return false;
+  }
+
+  bool success = import_from_lua(l);
+  lua_close(l);
+  return success;
 }
 
 /**
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/CurrentQuest.h"
+#include "solarus/core/QuestDatabase.h"
+#include "solarus/core/QuestFiles.h"
+#include "solarus/lua/LuaDataCache.h"
+#include <lua.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Solarus {
+
+namespace LuaDataCache {
+
+namespace {
+
+/**
+ * \brief Maximum number of worker threads.
+ */
+constexpr unsigned max_num_workers = 8;
+
+/**
+ * \brief Maximum size in bytes of the sources and chunks kept in memory.
+ *
+ * Preparsed files that are not loaded yet stay in memory: when this limit is
+ * reached, workers stop and the remaining files are compiled when loaded.
+ */
+constexpr size_t max_retained_size = 32 * 1024 * 1024;
+
+/**
+ * \brief State of a data file known by the cache.
+ */
+enum class EntryState {
+  PENDING,      /**< Waiting for a worker thread. */
+  COMPILING,    /**< A worker thread is compiling it. */
+  DONE          /**< Compiled, or given up. */
+};
+
+/**
+ * \brief A data file known by the cache.
+ */
+struct Entry {
+  EntryState state;
+  std::string source;     /**< Content of the file that was compiled. */
+  std::string chunk;      /**< Compiled chunk, empty if not available. */
+};
+
+std::unordered_map<std::string, Entry> entries_;     /**< Data files preparsed, by file name. */
+std::deque<std::string> pending_files_;              /**< Files waiting for a worker. */
+std::vector<std::thread> workers_;
+std::mutex mutex_;                                   /**< Protects entries_ and pending_files_. */
+std::condition_variable entry_done_condition_;
+size_t retained_size_ = 0;                           /**< Size of sources and chunks in entries_. */
+bool stopping_ = false;
+
+/**
+ * \brief Lua writer function that appends a compiled chunk to a string.
+ */
+int write_chunk(lua_State* /* l */, const void* data, size_t size, void* user_data) {
+
+  static_cast<std::string*>(user_data)->append(static_cast<const char*>(data), size);
+  return 0;
+}
+
+/**
+ * \brief Compiles a data file and gets its compiled chunk.
+ * \param l A Lua state.
+ * \param buffer Content of the data file.
+ * \param file_name Name of the data file.
+ * \param[out] chunk The compiled chunk, or an empty string in case of error.
+ * \return The result of luaL_loadbuffer(): 0 in case of success, with the
+ * chunk on top of the stack, or an error code with the error message on top
+ * of the stack.
+ */
+int compile(
+    lua_State* l,
+    const std::string& buffer,
+    const std::string& file_name,
+    std::string& chunk
+) {
+  chunk.clear();
+  const int result = luaL_loadbuffer(l, buffer.data(), buffer.size(), file_name.c_str());
+  if (result != 0) {
+    return result;
+  }
+
+  lua_dump(l, write_chunk, &chunk);
+  return 0;
+}
+
+/**
+ * \brief Function executed by worker threads.
+ *
+ * Each worker has its own Lua state and compiles pending files
+ * until there are none left.
+ */
+void run_worker() {
+
+  lua_State* l = luaL_newstate();
+
+  while (true) {
+
+    std::string file_name;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_ ||
+          pending_files_.empty() ||
+          retained_size_ >= max_retained_size) {
+        break;
+      }
+      file_name = pending_files_.front();
+      pending_files_.pop_front();
+
+      auto it = entries_.find(file_name);
+      if (it == entries_.end() || it->second.state != EntryState::PENDING) {
+        // The main thread already took care of it.
+        continue;
+      }
+      it->second.state = EntryState::COMPILING;
+    }
+
+    std::string buffer;
+    std::string chunk;
+    if (QuestFiles::data_file_exists(file_name)) {
+      buffer = QuestFiles::data_file_read(file_name);
+      // Syntax errors are ignored here: they will be reported
+      // when the file is actually loaded.
+      compile(l, buffer, file_name, chunk);
+      lua_settop(l, 0);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Entry& entry = entries_[file_name];
+      entry.state = EntryState::DONE;
+      if (!chunk.empty() &&
+          retained_size_ + buffer.size() + chunk.size() <= max_retained_size) {
+        retained_size_ += buffer.size() + chunk.size();
+        entry.source = std::move(buffer);
+        entry.chunk = std::move(chunk);
+      }
+    }
+    entry_done_condition_.notify_all();
+  }
+
+  lua_close(l);
+}
+
+/**
+ * \brief Waits for worker threads to finish.
+ */
+void join_workers() {
+
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+}  // Anonymous namespace.
+
+/**
+ * \brief Starts preparsing the data files of the quest.
+ *
+ * This function should be called once the quest database is loaded.
+ */
+void initialize() {
+
+  // Maps, tilesets and sprites are the biggest data files.
+  std::vector<std::string> file_names;
+  const std::vector<std::pair<ResourceType, std::string>> preparsed_types = {
+      { ResourceType::MAP, "maps/" },
+      { ResourceType::TILESET, "tilesets/" },
+      { ResourceType::SPRITE, "sprites/" }
+  };
+  for (const auto& preparsed_type : preparsed_types) {
+    for (const auto& kvp : CurrentQuest::get_resources(preparsed_type.first)) {
+      file_names.push_back(preparsed_type.second + kvp.first + ".dat");
+    }
+  }
+  preparse(file_names);
+}
+
+/**
+ * \brief Stops worker threads and forgets all compiled chunks.
+ */
+void quit() {
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  join_workers();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  pending_files_.clear();
+  retained_size_ = 0;
+  stopping_ = false;
+}
+
+/**
+ * \brief Compiles data files in advance from worker threads.
+ *
+ * Files that do not exist or have syntax errors are ignored here:
+ * errors are reported when they are actually loaded.
+ *
+ * \param file_names Data files to compile, relative to the quest data
+ * directory. They must not be language-specific.
+ */
+void preparse(const std::vector<std::string>& file_names) {
+
+  join_workers();  // Normally finished already.
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::string& file_name : file_names) {
+      const auto& result = entries_.emplace(file_name, Entry{ EntryState::PENDING, "", "" });
+      if (result.second) {
+        pending_files_.push_back(file_name);
+      }
+    }
+    if (pending_files_.empty()) {
+      return;
+    }
+  }
+
+  const unsigned num_cores = std::max(1u, std::thread::hardware_concurrency());
+  const unsigned num_workers = std::min(
+      max_num_workers,
+      std::max(1u, num_cores - 1)
+  );
+  for (unsigned i = 0; i < num_workers; ++i) {
+    workers_.emplace_back(run_worker);
+  }
+}
+
+/**
+ * \brief Returns the memory used by preparsed files not loaded yet.
+ * \return The size in bytes of their sources and compiled chunks.
+ */
+size_t get_retained_size() {
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  return retained_size_;
+}
+
+/**
+ * \brief Loads a data file as a Lua chunk, using the cache if possible.
+ *
+ * This is a replacement of luaL_loadbuffer() for data files.
+ * If the file was preparsed with exactly the same content, its compiled
+ * chunk is used directly. Otherwise, it is compiled now.
+ * Compiled chunks are only produced by this process and never stored on
+ * disk, and they are released with their source once used.
+ *
+ * \param l A Lua state.
+ * \param buffer Content of the data file.
+ * \param file_name Name of the data file.
+ * \return The result of luaL_loadbuffer(): 0 in case of success, with the
+ * chunk on top of the stack, or an error code with the error message on top
+ * of the stack.
+ */
+int load_buffer(
+    lua_State* l,
+    const std::string& buffer,
+    const std::string& file_name
+) {
+  std::string chunk;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = entries_.find(file_name);
+    if (it != entries_.end()) {
+      Entry& entry = it->second;
+      if (entry.state == EntryState::PENDING) {
+        // Not started yet: no need to wait for a worker.
+        entry.state = EntryState::DONE;
+      }
+      else {
+        entry_done_condition_.wait(lock, [&entry] {
+          return entry.state == EntryState::DONE;
+        });
+        retained_size_ -= entry.source.size() + entry.chunk.size();
+        // Compare the whole content: a hash could collide.
+        if (entry.source == buffer) {
+          chunk.swap(entry.chunk);
+        }
+        std::string().swap(entry.source);
+        std::string().swap(entry.chunk);
+      }
+    }
+  }
+
+  if (!chunk.empty()) {
+    if (luaL_loadbuffer(l, chunk.data(), chunk.size(), file_name.c_str()) == 0) {
+      return 0;
+    }
+    lua_pop(l, 1);
+  }
+
+  return luaL_loadbuffer(l, buffer.data(), buffer.size(), file_name.c_str());
+}
+
+}
+
+}
+
@@ -155,6 +155,77 @@ bool do_string(
   return call_function(l, 0, 0, chunk_name.c_str());
 }
 
+/**
+ * \brief Loads and executes some Lua code and collects the values it returns.
+ *
+ * Like do_string(), errors are printed, but the error message is also
+ * returned to the caller.
+ *
+ * \param l A Lua state.
+ * \param code The code to execute.
+ * \param chunk_name A name describing the Lua chunk
+ * (only used to print the error message if any).
+ * \param[out] results Receives the values returned by the code converted to
+ * strings, or the error message in case of failure.
+ * \return \c true in case of success.
+ */
+bool do_string(
+    lua_State* l,
+    const std::string& code,
+    const std::string& chunk_name,
+    std::vector<std::string>& results
+) {
+  const int base = lua_gettop(l);
+  int status = luaL_loadstring(l, code.c_str());
+  if (status == 0) {
+    lua_pushcfunction(l, &LuaContext::l_backtrace);
+    lua_insert(l, base + 1);
+    status = lua_pcall(l, 0, LUA_MULTRET, base + 1);
+    lua_remove(l, base + 1);
+  }
+
+  if (status != 0) {
+    const char* message = lua_tostring(l, -1);
+    const std::string error_message = (message != nullptr) ?
+        message : std::string("(error object is a ") + luaL_typename(l, -1) + ")";
+    Debug::error(std::string("In ") + chunk_name + ": " + error_message);
+    results.push_back(error_message);
+    lua_settop(l, base);
+    return false;
+  }
+
+  const int top = lua_gettop(l);
+  for (int i = base + 1; i <= top; ++i) {
+    switch (lua_type(l, i)) {
+
+    case LUA_TNUMBER:
+    case LUA_TSTRING:
+      lua_pushvalue(l, i);  // Don't let lua_tostring() change the original.
+      results.push_back(lua_tostring(l, -1));
+      lua_pop(l, 1);
+      break;
+
+    case LUA_TBOOLEAN:
+      results.push_back(lua_toboolean(l, i) ? "true" : "false");
+      break;
+
+    case LUA_TNIL:
+      results.push_back("nil");
+      break;
+
+    default:
+    {
+      std::ostringstream oss;
+      oss << luaL_typename(l, i) << ": " << lua_topointer(l, i);
+      results.push_back(oss.str());
+      break;
+    }
+    }
+  }
+  lua_settop(l, base);
+  return true;
+}
+
 /**
  * \brief Similar to luaL_error() but throws a LuaException.
  *
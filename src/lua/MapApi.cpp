@@ -103,6 +103,37 @@ const char* move_camera_code =
 "  timer_1:set_suspended_with_map(false)\n"
 "end)\n";
 
+/**
+ * \brief Name of the metatable of entity iterator states.
+ */
+const char* entity_iterator_type_name = "sol.entity_iterator";
+
+/**
+ * \brief State of an entity iterator, stored in a Lua full userdata.
+ */
+struct EntityIterator {
+
+  EntityIterator(EntityVector&& entities):
+    entities(std::move(entities)),
+    index(0) {
+  }
+
+  EntityVector entities;  /**< The entities to traverse. */
+  size_t index;           /**< Index of the next entity to return. */
+};
+
+/**
+ * \brief Finalizer of entity iterator states.
+ * \param l The Lua context that is calling this function.
+ * \return Number of values to return to Lua.
+ */
+int entity_iterator_meta_gc(lua_State* l) {
+
+  EntityIterator* iterator = static_cast<EntityIterator*>(lua_touserdata(l, 1));
+  iterator->~EntityIterator();
+  return 0;
+}
+
 }  // Anonymous namespace.
 
 /**
@@ -151,7 +182,10 @@ void LuaContext::register_map_module() {
       { "get_entities_in_region", map_api_get_entities_in_region },
       { "get_hero", map_api_get_hero },
       { "set_entities_enabled", map_api_set_entities_enabled },
-      { "remove_entities", map_api_remove_entities }
+      { "remove_entities", map_api_remove_entities },
+      { "save_snapshot", map_api_save_snapshot },
+      { "restore_snapshot", map_api_restore_snapshot },
+      { "get_detector_stats", map_api_get_detector_stats }
   };
 
   const std::vector<luaL_Reg> metamethods = {
@@ -186,6 +220,12 @@ void LuaContext::register_map_module() {
     Debug::check_assertion(lua_isfunction(l, -1), "map:move_camera() is not a function");
     lua_setfield(l, LUA_REGISTRYINDEX, "map.move_camera");
   }
+
+  // Metatable of the state of entity iterators.
+  luaL_newmetatable(l, entity_iterator_type_name);
+  lua_pushcfunction(l, entity_iterator_meta_gc);
+  lua_setfield(l, -2, "__gc");
+  lua_pop(l, 1);
 }
 
 /**
@@ -1375,13 +1415,66 @@ int LuaContext::l_get_map_entity_or_global(lua_State* l) {
   });
 }
 
+/**
+ * \brief Pushes a list of entities as an iterator onto the stack.
+ *
+ * The iterator is pushed onto the stack as one value of type function.
+ * The list is not copied into a Lua table: entities are pushed one by one
+ * when the iterator is called.
+ *
+ * \param l A Lua context.
+ * \param entities A list of entities. The iterator preserves their order
+ * and takes ownership of the list.
+ */
+void LuaContext::push_entity_iterator(lua_State* l, EntityVector&& entities) {
+
+  EntityIterator* iterator = static_cast<EntityIterator*>(
+      lua_newuserdata(l, sizeof(EntityIterator))
+  );
+  new (iterator) EntityIterator(std::move(entities));
+  luaL_getmetatable(l, entity_iterator_type_name);
+  lua_setmetatable(l, -2);
+  // 1 upvalue: the iterator state.
+
+  lua_pushcclosure(l, l_entity_iterator_next, 1);
+}
+
+/**
+ * \brief Returns an empty list of entities, reusing the memory of a
+ * finished iterator if possible.
+ * \return An empty list.
+ */
+EntityVector LuaContext::get_unused_entity_vector() {
+
+  if (entity_vectors_unused.empty()) {
+    return EntityVector();
+  }
+
+  EntityVector entities = std::move(entity_vectors_unused.back());
+  entity_vectors_unused.pop_back();
+  return entities;
+}
+
+/**
+ * \brief Keeps the memory of a list of entities no longer needed.
+ * \param entities The list. It is cleared.
+ */
+void LuaContext::set_entity_vector_unused(EntityVector&& entities) {
+
+  constexpr size_t max_entity_vectors_unused = 4;
+
+  entities.clear();
+  if (entity_vectors_unused.size() < max_entity_vectors_unused) {
+    entity_vectors_unused.push_back(std::move(entities));
+  }
+}
+
 /**
  * \brief Closure of an iterator over a list of entities.
  *
- * This closure expects 3 upvalues in this order:
- * - The array of entities.
- * - The size of the array (for performance).
- * - The current index in the array.
+ * This closure expects 1 upvalue: the iterator state created by
+ * push_entity_iterator().
+ * Entities removed from the map since the iterator was created are skipped.
  *
  * \param l The Lua context that is calling this function.
  * \return Number of values to return to Lua.
@@ -1390,25 +1483,27 @@ int LuaContext::l_entity_iterator_next(lua_State* l) {
 
   return LuaTools::exception_boundary_handle(l, [&] {
 
-    // Get upvalues.
-    const int table_index = lua_upvalueindex(1);
-    const int size = lua_tointeger(l, lua_upvalueindex(2));
-    int index = lua_tointeger(l, lua_upvalueindex(3));
-
-    if (index > size) {
-      // Finished.
-      return 0;
+    EntityIterator& iterator = *static_cast<EntityIterator*>(
+        lua_touserdata(l, lua_upvalueindex(1))
+    );
+    EntityVector& entities = iterator.entities;
+
+    while (iterator.index < entities.size()) {
+      Entity& entity = *entities[iterator.index];
+      ++iterator.index;
+      if (!entity.is_being_removed()) {
+        push_entity(l, entity);
+        return 1;
+      }
     }
 
-    // Get the next value.
-    lua_rawgeti(l, table_index, index);
-
-    // Increment index.
-    ++index;
-    lua_pushinteger(l, index);
-    lua_replace(l, lua_upvalueindex(3));
-
-    return 1;
+    // Finished: release the entities and keep the memory for other iterators.
+    if (entities.capacity() > 0) {
+      get_lua_context(l).set_entity_vector_unused(std::move(entities));
+      entities.clear();
+      iterator.index = 0;
+    }
+    return 0;
   });
 }
 
@@ -1999,10 +2094,7 @@ int LuaContext::map_api_get_entities(lua_State* l) {
     Map& map = *check_map(l, 1);
     const std::string& prefix = LuaTools::opt_string(l, 2, "");
 
-    const EntityVector& entities =
-        map.get_entities().get_entities_with_prefix_sorted(prefix);
-
-    push_entity_iterator(l, entities);
+    push_entity_iterator(l, map.get_entities().get_entities_with_prefix_sorted(prefix));
     return 1;
   });
 }
@@ -2018,10 +2110,7 @@ int LuaContext::map_api_get_entities_count(lua_State* l) {
     Map& map = *check_map(l, 1);
     const std::string& prefix = LuaTools::check_string(l, 2);
 
-    const EntityVector& entities =
-        map.get_entities().get_entities_with_prefix(prefix);
-
-    lua_pushinteger(l, entities.size());
+    lua_pushinteger(l, map.get_entities().get_num_entities_with_prefix(prefix));
     return 1;
   });
 }
@@ -2053,10 +2142,7 @@ int LuaContext::map_api_get_entities_by_type(lua_State* l) {
     Map& map = *check_map(l, 1);
     EntityType type = LuaTools::check_enum<EntityType>(l, 2);
 
-    const EntityVector& entities =
-        map.get_entities().get_entities_by_type_sorted(type);
-
-    push_entity_iterator(l, entities);
+    push_entity_iterator(l, map.get_entities().get_entities_by_type_sorted(type));
     return 1;
   });
 }
@@ -2075,12 +2161,12 @@ int LuaContext::map_api_get_entities_in_rectangle(lua_State* l) {
     const int width = LuaTools::check_int(l, 4);
     const int height = LuaTools::check_int(l, 5);
 
-    EntityVector entities;
+    EntityVector entities = get_lua_context(l).get_unused_entity_vector();
     map.get_entities().get_entities_in_rectangle_sorted(
         Rectangle(x, y, width, height), entities
     );
 
-    push_entity_iterator(l, entities);
+    push_entity_iterator(l, std::move(entities));
     return 1;
   });
 }
@@ -2109,7 +2195,7 @@ int LuaContext::map_api_get_entities_in_region(lua_State* l) {
       LuaTools::type_error(l, 2, "entity or number");
     }
 
-    EntityVector entities;
+    EntityVector entities = get_lua_context(l).get_unused_entity_vector();
     map.get_entities().get_entities_in_region_sorted(
         xy, entities
     );
@@ -2122,7 +2208,7 @@ int LuaContext::map_api_get_entities_in_region(lua_State* l) {
       }
     }
 
-    push_entity_iterator(l, entities);
+    push_entity_iterator(l, std::move(entities));
     return 1;
   });
 }
@@ -2181,6 +2267,58 @@ int LuaContext::map_api_remove_entities(lua_State* l) {
   });
 }
 
+/**
+ * \brief Implementation of map:save_snapshot().
+ * \param l The Lua context that is calling this function.
+ * \return Number of values to return to Lua.
+ */
+int LuaContext::map_api_save_snapshot(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    Map& map = *check_map(l, 1);
+
+    if (!map.is_loaded()) {
+      LuaTools::error(l, "This map is not loaded");
+    }
+    map.save_snapshot();
+    return 0;
+  });
+}
+
+/**
+ * \brief Implementation of map:restore_snapshot().
+ * \param l The Lua context that is calling this function.
+ * \return Number of values to return to Lua.
+ */
+int LuaContext::map_api_restore_snapshot(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    Map& map = *check_map(l, 1);
+
+    if (!map.is_loaded()) {
+      LuaTools::error(l, "This map is not loaded");
+    }
+    lua_pushboolean(l, map.restore_snapshot());
+    return 1;
+  });
+}
+
+/**
+ * \brief Implementation of map:get_detector_stats().
+ * \param l The Lua context that is calling this function.
+ * \return Number of values to return to Lua.
+ */
+int LuaContext::map_api_get_detector_stats(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    const Map& map = *check_map(l, 1);
+
+    lua_pushinteger(l, static_cast<lua_Integer>(map.get_num_detector_candidates()));
+    lua_pushinteger(l, static_cast<lua_Integer>(map.get_num_detector_checks()));
+    return 2;
+  });
+}
+
 /**
  * \brief Implementation of all entity creation functions: map_api_create_*.
  * \param l The Lua context that is calling this function.
@@ -2424,5 +2562,41 @@ void LuaContext::map_on_obtained_treasure(Map& map, const Treasure& treasure) {
   lua_pop(l, 1);
 }
 
+/**
+ * \brief Calls the on_snapshot() method of a Lua map.
+ *
+ * Does nothing if the method is not defined.
+ *
+ * \param map A map whose entities were just captured by map:save_snapshot().
+ */
+void LuaContext::map_on_snapshot(Map& map) {
+
+  if (!userdata_has_field(map, "on_snapshot")) {
+    return;
+  }
+
+  push_map(l, map);
+  on_snapshot();
+  lua_pop(l, 1);
+}
+
+/**
+ * \brief Calls the on_restore_snapshot() method of a Lua map.
+ *
+ * Does nothing if the method is not defined.
+ *
+ * \param map A map whose entities were just restored by map:restore_snapshot().
+ */
+void LuaContext::map_on_restore_snapshot(Map& map) {
+
+  if (!userdata_has_field(map, "on_restore_snapshot")) {
+    return;
+  }
+
+  push_map(l, map);
+  on_restore_snapshot();
+  lua_pop(l, 1);
+}
+
 }
 
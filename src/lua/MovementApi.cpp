@@ -14,6 +14,7 @@
  * You should have received a copy of the GNU General Public License along
  * with this program. If not, see <http://www.gnu.org/licenses/>.
  */
+#include "solarus/core/CurrentQuest.h"
 #include "solarus/core/Debug.h"
 #include "solarus/core/Game.h"
 #include "solarus/core/MainLoop.h"
@@ -132,6 +133,12 @@ void LuaContext::register_movement_module() {
       { "is_smooth", straight_movement_api_is_smooth },
       { "set_smooth", straight_movement_api_set_smooth }
   };
+  if (CurrentQuest::is_format_at_least({ 1, 6 })) {
+    straight_movement_methods.insert(straight_movement_methods.end(), {
+        { "is_swept", movement_api_is_swept },
+        { "set_swept", movement_api_set_swept }
+    });
+  }
   straight_movement_methods.insert(
         straight_movement_methods.end(),
         movement_common_methods.begin(),
@@ -175,6 +182,12 @@ void LuaContext::register_movement_module() {
       { "is_smooth", target_movement_api_is_smooth },
       { "set_smooth", target_movement_api_set_smooth },
   };
+  if (CurrentQuest::is_format_at_least({ 1, 6 })) {
+    target_movement_methods.insert(target_movement_methods.end(), {
+        { "is_swept", movement_api_is_swept },
+        { "set_swept", movement_api_set_swept }
+    });
+  }
   target_movement_methods.insert(
         target_movement_methods.end(),
         movement_common_methods.begin(),
@@ -197,7 +210,8 @@ void LuaContext::register_movement_module() {
       { "get_loop", path_movement_api_get_loop },
       { "set_loop", path_movement_api_set_loop },
       { "get_snap_to_grid", path_movement_api_get_snap_to_grid },
-      { "set_snap_to_grid", path_movement_api_set_snap_to_grid }
+      { "set_snap_to_grid", path_movement_api_set_snap_to_grid },
+      { "fast_forward", path_movement_api_fast_forward }
   };
   path_movement_methods.insert(
         path_movement_methods.end(),
@@ -310,6 +324,12 @@ void LuaContext::register_movement_module() {
       { "get_delay", pixel_movement_api_get_delay },
       { "set_delay", pixel_movement_api_set_delay }
   };
+  if (CurrentQuest::is_format_at_least({ 1, 6 })) {
+    pixel_movement_methods.insert(pixel_movement_methods.end(), {
+        { "is_swept", movement_api_is_swept },
+        { "set_swept", movement_api_set_swept }
+    });
+  }
   pixel_movement_methods.insert(
         pixel_movement_methods.end(),
         movement_common_methods.begin(),
@@ -468,25 +488,51 @@ void LuaContext::stop_movement_on_point(const std::shared_ptr<Movement>& movemen
                                   // ... movements
   lua_pop(l, 1);
                                   // ...
+  ++movements_on_points_stopped;
 }
 
 /**
  * \brief Updates all movements applied to x,y points.
  *
  * Movements applied to map entities or drawables are already updated
- * by the entity or the drawable.
+ * by the entity or the drawable, or in a batch by the map entities
+ * (see Entities::update_batched_movements()).
  * This may change in the future in order to unify the handling of movements.
  */
 void LuaContext::update_movements() {
 
+  // Collect the movements before updating them in a single loop:
+  // updating them may call Lua code that starts or stops movements.
+  std::vector<std::shared_ptr<Movement>>& movements = movements_on_points_to_update;
+  movements.clear();
   lua_getfield(l, LUA_REGISTRYINDEX, "sol.movements_on_points");
   lua_pushnil(l);  // First key.
   while (lua_next(l, -2)) {
-    Movement& movement = *check_movement(l, -2);
-    movement.update();
+    // Keys of this table are always movements: no need to check their type.
+    const ExportableToLuaPtr& userdata = *(static_cast<ExportableToLuaPtr*>(
+        lua_touserdata(l, -2)
+    ));
+    movements.push_back(std::static_pointer_cast<Movement>(userdata));
     lua_pop(l, 1);  // Pop the value, keep the key for next iteration.
   }
+
+  const uint64_t num_stopped = movements_on_points_stopped;
+  for (const std::shared_ptr<Movement>& movement : movements) {
+    if (movements_on_points_stopped != num_stopped) {
+      // Some movements were stopped during this pass:
+      // only update this one if it still moves a point.
+      push_movement(l, *movement);
+      lua_rawget(l, -2);
+      const bool on_point = !lua_isnil(l, -1);
+      lua_pop(l, 1);
+      if (!on_point) {
+        continue;
+      }
+    }
+    movement->update();
+  }
   lua_pop(l, 1);  // Pop the movements table.
+  movements.clear();
 }
 
 /**
@@ -505,6 +551,7 @@ int LuaContext::movement_api_create(lua_State* l) {
       std::shared_ptr<StraightMovement> straight_movement =
           std::make_shared<StraightMovement>(false, true);
       straight_movement->set_speed(32);
+      straight_movement->set_batchable(true);
       movement = straight_movement;
     }
     else if (type == "random") {
@@ -544,12 +591,14 @@ int LuaContext::movement_api_create(lua_State* l) {
     }
     else if (type == "circle") {
       movement = std::make_shared<CircleMovement>(false);
+      movement->set_batchable(true);
     }
     else if (type == "jump") {
       movement = std::make_shared<JumpMovement>(0, 0, 0, false);
     }
     else if (type == "pixel") {
       movement = std::make_shared<PixelMovement>("", 30, false, false);
+      movement->set_batchable(true);
     }
     else {
       LuaTools::arg_error(l, 1, "should be one of: "
@@ -719,6 +768,38 @@ int LuaContext::movement_api_get_direction4(lua_State* l) {
   });
 }
 
+/**
+ * \brief Implementation of movement:is_swept().
+ * \param l the Lua context that is calling this function
+ * \return number of values to return to Lua
+ */
+int LuaContext::movement_api_is_swept(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    std::shared_ptr<Movement> movement = check_movement(l, 1);
+
+    lua_pushboolean(l, movement->is_swept());
+    return 1;
+  });
+}
+
+/**
+ * \brief Implementation of movement:set_swept().
+ * \param l the Lua context that is calling this function
+ * \return number of values to return to Lua
+ */
+int LuaContext::movement_api_set_swept(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    std::shared_ptr<Movement> movement = check_movement(l, 1);
+    bool swept = LuaTools::opt_boolean(l, 2, true);
+
+    movement->set_swept(swept);
+
+    return 0;
+  });
+}
+
 /**
  * \brief Returns whether a value is a userdata of type straight movement.
  * \param l A Lua context.
@@ -1287,6 +1368,26 @@ int LuaContext::path_movement_api_set_snap_to_grid(lua_State* l) {
   });
 }
 
+/**
+ * \brief Implementation of path_movement:fast_forward().
+ * \param l the Lua context that is calling this function
+ * \return number of values to return to Lua
+ */
+int LuaContext::path_movement_api_fast_forward(lua_State* l) {
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    PathMovement& movement = *check_path_movement(l, 1);
+    int num_moves = LuaTools::check_int(l, 2);
+
+    if (num_moves < 0) {
+      LuaTools::arg_error(l, 2, "Invalid number of moves: must be positive or zero");
+    }
+
+    lua_pushinteger(l, movement.fast_forward(num_moves));
+    return 1;
+  });
+}
+
 /**
  * \brief Checks that the userdata at the specified index of the stack is a
  * random path movement and returns it.
@@ -30,6 +30,39 @@ namespace Solarus {
  */
 const std::string LuaContext::surface_module_name = "sol.surface";
 
+namespace {
+
+/**
+ * \brief Checks the optional region arguments of surface pixel functions.
+ *
+ * The region is either the whole surface (no argument) or four integers
+ * x, y, width and height at the given index of the stack.
+ *
+ * \param l A Lua context.
+ * \param index Index of the first region argument in the stack.
+ * \param surface The surface accessed.
+ * \return The region.
+ */
+Rectangle check_surface_region(
+    lua_State* l, int index, const Surface& surface) {
+
+  if (lua_gettop(l) < index) {
+    return Rectangle(Point(0, 0), surface.get_size());
+  }
+
+  int x = LuaTools::check_int(l, index);
+  int y = LuaTools::check_int(l, index + 1);
+  int width = LuaTools::check_int(l, index + 2);
+  int height = LuaTools::check_int(l, index + 3);
+  Rectangle region(x, y, width, height);
+  if (!surface.is_region_valid(region)) {
+    LuaTools::arg_error(l, index, "Region is outside the surface");
+  }
+  return region;
+}
+
+}
+
 /**
  * \brief Initializes the surface features provided to Lua.
  */
@@ -241,10 +274,10 @@ int LuaContext::surface_api_set_opacity(lua_State* l) {
 int LuaContext::surface_api_get_pixels(lua_State* l) {
 
   return LuaTools::exception_boundary_handle(l, [&] {
-    Surface& surface = *check_surface(l, 1);
-    // TODO optional parameters x, y, width, height
+    const Surface& surface = *check_surface(l, 1);
+    const Rectangle& region = check_surface_region(l, 2, surface);
 
-    push_string(l, surface.get_pixels());
+    push_string(l, surface.get_pixels(region));
     return 1;
   });
 }
@@ -255,12 +288,20 @@ int LuaContext::surface_api_get_pixels(lua_State* l) {
  * \return Number of values to return to Lua.
  */
 int LuaContext::surface_api_set_pixels(lua_State* l) {
-    return LuaTools::exception_boundary_handle(l, [&] {
-        Surface& surface = *check_surface(l,1);
-        const std::string& buffer = LuaTools::check_string(l,2);
-        surface.set_pixels(buffer);
-        return 0;
-    });
+
+  return LuaTools::exception_boundary_handle(l, [&] {
+    Surface& surface = *check_surface(l, 1);
+    const std::string& buffer = LuaTools::check_string(l, 2);
+    const Rectangle& region = check_surface_region(l, 3, surface);
+
+    if (buffer.size() != static_cast<size_t>(region.get_width() * region.get_height() * 4)) {
+      LuaTools::arg_error(l, 2, "Wrong pixel buffer size: expected " +
+          std::to_string(region.get_width() * region.get_height() * 4) +
+          " bytes, got " + std::to_string(buffer.size()));
+    }
+    surface.set_pixels(buffer, region);
+    return 0;
+  });
 }
 
 }
@@ -59,6 +59,10 @@ void print_help(const Arguments& args) {
     << std::endl
     << "  -lua-console=yes|no           accepts standard input lines as Lua commands (default yes)"
     << std::endl
+    << "  -lua-console-socket=<path>    also accepts Lua commands on a local socket and replies one result line per command"
+    << std::endl
+    << "  -lua-console-budget=N         runs at most N Lua console commands per cycle, 0 means no limit (default 64)"
+    << std::endl
     << "  -turbo=yes|no                 runs as fast as possible rather than simulating real time (default no)"
     << std::endl
     << "  -lag=X                        slows down each frame of X milliseconds to simulate slower systems for debugging (default 0)"
@@ -89,6 +93,10 @@ void print_help(const Arguments& args) {
  *   -no-video                         Disables displaying (used for unit tests).
  *   -quest-size=<width>x<height>      Sets the size of the drawing area (if compatible with the quest).
  *   -lua-console=yes|no               Accepts lines from standard input as Lua commands (default: yes).
+ *   -lua-console-socket=<path>        Also accepts Lua commands on a local socket and replies
+ *                                     one result line per command (not available on Windows).
+ *   -lua-console-budget=N             Runs at most N Lua console commands per cycle,
+ *                                     0 means no limit (default: 64).
  *   -turbo=yes|no                     Runs as fast as possible rather than simulating real time (default: no).
  *   -lag=X                            (Advanced) Artificially slows down each frame of X milliseconds
  *                                     to simulate slower systems for debugging (default: 0).
@@ -401,7 +401,7 @@ void CircleMovement::recompute_position() {
     center += center_entity->get_xy();
   }
 
-  Point xy = Geometry::get_xy(center, Geometry::degrees_to_radians(current_angle), current_radius);
+  Point xy = Geometry::get_xy_degrees(center, current_angle, current_radius);
   if (get_entity() == nullptr
       || !test_collision_with_obstacles(xy - get_entity()->get_xy())) {
     set_xy(xy);
@@ -52,6 +52,12 @@ Movement::Movement(bool ignore_obstacles):
   last_collision_box_on_obstacle(-1, -1),
   default_ignore_obstacles(ignore_obstacles),
   current_ignore_obstacles(ignore_obstacles),
+  swept(false),
+  num_changes(0),
+  batchable(false),
+  updated_in_batch(false),
+  position_notifications_deferred(false),
+  position_changed_in_batch(false),
   finished_callback_ref() {
 
 }
@@ -86,6 +92,7 @@ void Movement::set_entity(Entity* entity) {
   Debug::check_assertion(drawable == nullptr, "This movement is already assigned to a drawable");
 
   this->entity = entity;
+  updated_in_batch = false;
 
   if (entity == nullptr) {
     this->xy = { 0, 0 };
@@ -263,6 +270,12 @@ void Movement::translate_xy(const Point& dxy) {
  */
 void Movement::notify_position_changed() {
 
+  if (position_notifications_deferred) {
+    // Only the final position of the batch will be notified.
+    position_changed_in_batch = true;
+    return;
+  }
+
   LuaContext* lua_context = get_lua_context();
   if (lua_context != nullptr && are_lua_notifications_enabled()) {
     lua_context->movement_on_position_changed(*this, get_xy());
@@ -297,6 +310,8 @@ void Movement::notify_obstacle_reached() {
  */
 void Movement::notify_movement_changed() {
 
+  increment_num_changes();
+
   LuaContext* lua_context = get_lua_context();
   if (lua_context != nullptr && are_lua_notifications_enabled()) {
     lua_context->movement_on_changed(*this);
@@ -514,6 +529,205 @@ void Movement::restore_default_ignore_obstacles() {
   this->current_ignore_obstacles = default_ignore_obstacles;
 }
 
+/**
+ * \brief Returns whether obstacles are tested along the whole way
+ * of each update at once.
+ * \return \c true if the movement is swept.
+ */
+bool Movement::is_swept() const {
+
+  return swept;
+}
+
+/**
+ * \brief Sets whether obstacles should be tested along the whole way
+ * of each update at once.
+ *
+ * By default, movements make their one-pixel steps one by one and test
+ * obstacles before each of them.
+ * When this is enabled, movement types that support it first look for all
+ * steps that can be made freely during the update, with a single search of
+ * the entities that may be obstacles, and then make them without testing
+ * obstacles again.
+ * Detectors are still checked at each intermediate position, so fast
+ * entities cannot go through them.
+ * Steps that reach an obstacle are still handled as usual.
+ *
+ * Only straight, target and pixel movements support this for now.
+ *
+ * \param swept \c true to test obstacles along the whole way at once.
+ */
+void Movement::set_swept(bool swept) {
+
+  this->swept = swept;
+}
+
+/**
+ * \brief Returns whether this movement may be updated in a batch with
+ * other movements of the same type.
+ * \return \c true if the movement can be batched.
+ */
+bool Movement::is_batchable() const {
+
+  return batchable;
+}
+
+/**
+ * \brief Sets whether this movement may be updated in a batch with
+ * other movements of the same type.
+ *
+ * A batched movement is updated before the entities of the map and only
+ * notifies its final position of the cycle: detectors, the ground and the
+ * on_position_changed() events of the entity do not see intermediate steps.
+ * Obstacles are still tested at each step.
+ * This should only be enabled for movements whose subclass does not need
+ * to be notified of each step.
+ *
+ * \param batchable \c true to allow batched updates.
+ */
+void Movement::set_batchable(bool batchable) {
+
+  this->batchable = batchable;
+}
+
+/**
+ * \brief Prepares an update of this movement in a batch.
+ *
+ * Position changes are then deferred until finish_batched_update().
+ */
+void Movement::start_batched_update() {
+
+  position_notifications_deferred = true;
+  position_changed_in_batch = false;
+  updated_in_batch = true;
+}
+
+/**
+ * \brief Ends an update of this movement in a batch.
+ *
+ * The position change, if any, is notified now if the movement still
+ * controls an entity.
+ *
+ * \return \c true if the position changed during the batch.
+ */
+bool Movement::finish_batched_update() {
+
+  position_notifications_deferred = false;
+  const bool position_changed = position_changed_in_batch;
+  position_changed_in_batch = false;
+  if (position_changed && entity != nullptr) {
+    notify_position_changed();
+  }
+  return position_changed;
+}
+
+/**
+ * \brief Returns whether a batch already updated this movement
+ * during the current cycle.
+ * \return \c true if the entity should not update it again.
+ */
+bool Movement::is_updated_in_batch() const {
+
+  return updated_in_batch;
+}
+
+/**
+ * \brief Sets whether a batch already updated this movement
+ * during the current cycle.
+ * \param updated_in_batch \c true if the entity should not update it again.
+ */
+void Movement::set_updated_in_batch(bool updated_in_batch) {
+
+  this->updated_in_batch = updated_in_batch;
+}
+
+/**
+ * \brief Tests positions relative to the current one and returns how many of
+ * them are free of obstacles before the first blocked one.
+ *
+ * Entities that may be obstacles are only searched once for all positions.
+ *
+ * \param offsets Successive positions to test, relative to the current one.
+ * \return The number of positions that are free of obstacles,
+ * starting from the first one.
+ */
+size_t Movement::get_num_free_offsets(const std::vector<Point>& offsets) const {
+
+  if (entity == nullptr || current_ignore_obstacles || offsets.empty()) {
+    return offsets.size();
+  }
+
+  Map& map = entity->get_map();
+  const int layer = entity->get_layer();
+  const Rectangle& bounding_box = entity->get_bounding_box();
+
+  // Gather entities along the whole way.
+  Rectangle area = bounding_box;
+  for (const Point& offset: offsets) {
+    Rectangle collision_box = bounding_box;
+    collision_box.add_xy(offset);
+    area |= collision_box;
+  }
+  std::vector<Entity*> candidate_obstacles;
+  map.get_candidate_obstacles(layer, area, *entity, candidate_obstacles);
+
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    Rectangle collision_box = bounding_box;
+    collision_box.add_xy(offsets[i]);
+    if (map.test_collision_with_obstacles(layer, collision_box, *entity, candidate_obstacles)) {
+      return i;
+    }
+  }
+  return offsets.size();
+}
+
+/**
+ * \brief Returns how many times the movement was changed.
+ *
+ * Subclasses that make several precomputed steps at once compare this
+ * value before and after each step to know if a callback changed the
+ * movement in the meantime.
+ *
+ * \return The number of changes so far.
+ */
+uint64_t Movement::get_num_changes() const {
+  return num_changes;
+}
+
+/**
+ * \brief Records that the speed, direction or path of the movement changed.
+ *
+ * notify_movement_changed() already calls this function.
+ */
+void Movement::increment_num_changes() {
+  ++num_changes;
+}
+
+/**
+ * \brief Returns whether precomputed free steps can still be made after
+ * a step that may have run callbacks.
+ *
+ * They cannot if the entity was removed or got another movement, if the
+ * movement was suspended or changed, or if the entity was moved elsewhere:
+ * the obstacle tests of the remaining steps are then no longer valid.
+ *
+ * \param expected_xy The position the last step should have led to.
+ * \param expected_num_changes Value of get_num_changes() before the steps.
+ * \return \c true if the next free step can be made.
+ */
+bool Movement::can_continue_free_steps(
+    const Point& expected_xy,
+    uint64_t expected_num_changes
+) const {
+
+  return entity != nullptr &&
+      !entity->is_being_removed() &&
+      entity->get_movement().get() == this &&
+      !is_suspended() &&
+      num_changes == expected_num_changes &&
+      get_xy() == expected_xy;
+}
+
 /**
  * \brief Returns the direction a sprite controlled by this movement should take.
  * \return the direction to use to display the object controlled by this movement (0 to 3)
@@ -19,8 +19,28 @@
 #include "solarus/core/Map.h"
 #include "solarus/entities/Entity.h"
 #include "solarus/movements/PathFinding.h"
+#include <algorithm>
 #include <limits>
 
+namespace {
+
+/**
+ * \brief Maximum Manhattan distance from the target of explored nodes.
+ */
+constexpr int max_distance = 200;
+
+/**
+ * \brief Size of cells used to sort candidate obstacles.
+ */
+constexpr int obstacle_cell_size = 32;
+
+/**
+ * \brief Maximum size of a transition collision box.
+ */
+constexpr int max_transition_size = 24;
+
+}
+
 namespace Solarus {
 
 const Point PathFinding::neighbours_locations[] = {
@@ -121,7 +141,7 @@ std::string PathFinding::compute_path(const Point& offset) {
       "Could not snap the target to the map grid");
 
   const int total_mdistance = Geometry::get_manhattan_distance(source, target);
-  if (total_mdistance > 200 || target_entity.get_layer() != source_entity.get_layer()) {
+  if (total_mdistance > max_distance || target_entity.get_layer() != source_entity.get_layer()) {
     //std::cout << "too far, not computing a path\n";
     return ""; // too far to compute a path
   }
@@ -141,6 +161,7 @@ std::string PathFinding::compute_path(const Point& offset) {
   open_list.clear();
   closed_list.clear();
   open_list_indices.clear();
+  collect_candidate_obstacles(target);
 
   open_list[index] = starting_node;
   open_list_indices.push_front(index);
@@ -181,7 +202,7 @@ std::string PathFinding::compute_path(const Point& offset) {
         //std::cout << "  node in direction " << i << ": index = " << new_node.index << std::endl;
 
         const bool in_closed_list = (closed_list.find(new_node.index) != closed_list.end());
-        if (!in_closed_list && Geometry::get_manhattan_distance(new_node.location, target) < 200
+        if (!in_closed_list && Geometry::get_manhattan_distance(new_node.location, target) < max_distance
             && is_node_transition_valid(*current_node, i)) {
           //std::cout << "  node in direction " << i << " is not in the closed list\n";
           // not in the closed list: look in the open list
@@ -304,7 +325,76 @@ bool PathFinding::is_node_transition_valid(
   Rectangle collision_box = transition_collision_boxes[direction];
   collision_box.add_xy(initial_node.location);
 
-  return !map.test_collision_with_obstacles(source_entity.get_layer(), collision_box, source_entity);
+  const int cell_x = (collision_box.get_x() - obstacles_area.get_x()) / obstacle_cell_size;
+  const int cell_y = (collision_box.get_y() - obstacles_area.get_y()) / obstacle_cell_size;
+  const int num_columns = obstacles_area.get_width() / obstacle_cell_size;
+  const int num_rows = obstacles_area.get_height() / obstacle_cell_size;
+  if (!obstacles_area.contains(collision_box.get_xy()) ||
+      cell_x >= num_columns ||
+      cell_y >= num_rows) {
+    // Should not happen: no precomputed obstacles here.
+    return !map.test_collision_with_obstacles(source_entity.get_layer(), collision_box, source_entity);
+  }
+
+  return !map.test_collision_with_obstacles(
+      source_entity.get_layer(),
+      collision_box,
+      source_entity,
+      obstacle_cells[cell_y * num_columns + cell_x]
+  );
+}
+
+/**
+ * \brief Finds the entities that may be obstacles anywhere the search can go.
+ *
+ * This replaces a spatial search of entities for each transition by a
+ * single one.
+ * Entities are sorted by cells so that each transition only tests the ones
+ * of the cell where its collision box starts.
+ *
+ * \param target The target location, aligned on the map grid.
+ */
+void PathFinding::collect_candidate_obstacles(const Point& target) {
+
+  // Nodes are at most at max_distance from the target
+  // and their transitions extend a bit further.
+  const int margin = max_distance + 8;
+  const int num_cells = (2 * margin + max_transition_size + obstacle_cell_size - 1) / obstacle_cell_size;
+  obstacles_area = Rectangle(
+      target.x - margin,
+      target.y - margin,
+      num_cells * obstacle_cell_size,
+      num_cells * obstacle_cell_size
+  );
+
+  std::vector<Entity*> candidates;
+  map.get_candidate_obstacles(
+      source_entity.get_layer(),
+      Rectangle(
+          obstacles_area.get_x(),
+          obstacles_area.get_y(),
+          obstacles_area.get_width() + max_transition_size,
+          obstacles_area.get_height() + max_transition_size
+      ),
+      source_entity,
+      candidates
+  );
+
+  obstacle_cells.assign(num_cells * num_cells, std::vector<Entity*>());
+  for (Entity* candidate : candidates) {
+    // A transition starting in a cell can reach max_transition_size pixels
+    // after it.
+    const Rectangle& box = candidate->get_bounding_box();
+    const int min_x = std::max(0, (box.get_x() - max_transition_size - obstacles_area.get_x()) / obstacle_cell_size);
+    const int min_y = std::max(0, (box.get_y() - max_transition_size - obstacles_area.get_y()) / obstacle_cell_size);
+    const int max_x = std::min(num_cells - 1, (box.get_x() + box.get_width() - 1 - obstacles_area.get_x()) / obstacle_cell_size);
+    const int max_y = std::min(num_cells - 1, (box.get_y() + box.get_height() - 1 - obstacles_area.get_y()) / obstacle_cell_size);
+    for (int y = min_y; y <= max_y; ++y) {
+      for (int x = min_x; x <= max_x; ++x) {
+        obstacle_cells[y * num_cells + x].push_back(candidate);
+      }
+    }
+  }
 }
 
 }
@@ -23,19 +23,32 @@
 #include "solarus/lua/LuaContext.h"
 #include "solarus/movements/PathMovement.h"
 #include <list>
+#include <memory>
+#include <vector>
 
 namespace Solarus {
 
-const std::string PathMovement::elementary_moves[] = {
-    " 1  0   1  0   1  0   1  0   1  0   1  0   1  0   1  0", // 8 pixels right
-    " 1 -1   1 -1   1 -1   1 -1   1 -1   1 -1   1 -1   1 -1", // 8 pixels right-up
-    " 0 -1   0 -1   0 -1   0 -1   0 -1   0 -1   0 -1   0 -1", // 8 pixels up
-    "-1 -1  -1 -1  -1 -1  -1 -1  -1 -1  -1 -1  -1 -1  -1 -1", // 8 pixels left-up
-    "-1  0  -1  0  -1  0  -1  0  -1  0  -1  0  -1  0  -1  0", // 8 pixels left
-    "-1  1  -1  1  -1  1  -1  1  -1  1  -1  1  -1  1  -1  1", // 8 pixels left-down
-    " 0  1   0  1   0  1   0  1   0  1   0  1   0  1   0  1", // 8 pixels down
-    " 1  1   1  1   1  1   1  1   1  1   1  1   1  1   1  1"  // 8 pixels right-down
-};
+/**
+ * \brief Returns the 8-pixel trajectory of a direction.
+ *
+ * Trajectories are created once and shared by all path movements.
+ *
+ * \param direction A direction between 0 and 7.
+ * \return The trajectory in the PixelMovement sense.
+ */
+const std::shared_ptr<const std::list<Point>>& PathMovement::get_elementary_move(int direction) {
+
+  static const std::vector<std::shared_ptr<const std::list<Point>>> elementary_moves = [] {
+    std::vector<std::shared_ptr<const std::list<Point>>> moves;
+    for (int i = 0; i < 8; ++i) {
+      const Point& xy_move = Entity::direction_to_xy_move(i);
+      moves.push_back(std::make_shared<const std::list<Point>>(8, xy_move));
+    }
+    return moves;
+  }();
+
+  return elementary_moves[direction];
+}
 
 /**
  * \brief Creates a path movement object.
@@ -56,6 +69,7 @@ PathMovement::PathMovement(
     bool must_be_aligned):
 
   PixelMovement("", 0, false, ignore_obstacles),
+  next_direction_index(0),
   current_direction(6),
   total_distance_covered(0),
   stopped_by_obstacle(false),
@@ -124,7 +138,7 @@ void PathMovement::set_loop(bool loop) {
 
   this->loop = loop;
 
-  if (PixelMovement::is_finished() && remaining_path.size() == 0 && loop) {
+  if (PixelMovement::is_finished() && next_direction_index >= initial_path.size() && loop) {
     restart();
   }
 }
@@ -199,7 +213,7 @@ void PathMovement::set_suspended(bool suspended) {
  */
 bool PathMovement::is_finished() const {
 
-  return (PixelMovement::is_finished() && remaining_path.empty() && !loop)
+  return (PixelMovement::is_finished() && next_direction_index >= initial_path.size() && !loop)
       || stopped_by_obstacle;
 }
 
@@ -208,7 +222,7 @@ bool PathMovement::is_finished() const {
  */
 void PathMovement::restart() {
 
-  this->remaining_path = initial_path;
+  this->next_direction_index = 0;
   this->snapping = false;
   this->stop_snapping_date = 0;
   this->stopped_by_obstacle = false;
@@ -271,11 +285,11 @@ void PathMovement::start_next_elementary_move() {
 
     snapping = false;
 
-    if (remaining_path.empty()) {
+    if (next_direction_index >= initial_path.size()) {
       // the path is finished
       if (loop) {
         // if the property 'loop' is true, repeat the same path again
-        remaining_path = initial_path;
+        next_direction_index = 0;
       }
       else if (!is_stopped()) {
         // the movement is finished: stop the entity
@@ -283,18 +297,19 @@ void PathMovement::start_next_elementary_move() {
       }
     }
 
-    if (!remaining_path.empty()) {
+    if (next_direction_index < initial_path.size()) {
       // normal case: there is a next trajectory to do
 
-      current_direction = remaining_path[0] - '0';
+      const char direction_char = initial_path[next_direction_index];
+      current_direction = direction_char - '0';
       Debug::check_assertion(current_direction >= 0 && current_direction < 8,
           std::string("Invalid path '") + initial_path + "' (bad direction '"
-          + remaining_path[0] + "')"
+          + direction_char + "')"
       );
 
       PixelMovement::set_delay(speed_to_delay(speed, current_direction));
-      PixelMovement::set_trajectory(elementary_moves[current_direction]);
-      remaining_path = remaining_path.substr(1);
+      PixelMovement::set_trajectory(get_elementary_move(current_direction));
+      ++next_direction_index;
     }
   }
 }
@@ -351,6 +366,104 @@ int PathMovement::get_total_distance_covered() const {
   return total_distance_covered;
 }
 
+/**
+ * \brief Makes the next elementary moves of the path at once.
+ *
+ * This is intended for entities that are not visible: the entity is moved
+ * with a single position change, without notifying each step.
+ * The elementary move in progress, if any, is completed and counted as
+ * the first one.
+ * Obstacles are still tested at each pixel of the way, and only moves that
+ * are entirely free are made: the normal update then continues from there
+ * and detects the obstacle as usual.
+ *
+ * \param num_moves Number of 8-pixel moves to make.
+ * \return The number of moves actually made.
+ */
+int PathMovement::fast_forward(int num_moves) {
+
+  if (get_entity() == nullptr ||
+      num_moves <= 0 ||
+      snapping ||
+      is_suspended() ||
+      PathMovement::is_finished()) {
+    return 0;
+  }
+
+  // Compute every pixel of the way to test obstacles.
+  std::vector<Point> offsets;
+  std::vector<size_t> move_ends;           // Number of offsets at the end of each move.
+  std::vector<size_t> next_indexes;        // Value of next_direction_index after each move.
+  std::vector<int> directions;             // Direction of each move.
+  Point offset;
+
+  if (!is_current_elementary_move_finished()) {
+    const Point& xy_move = Entity::direction_to_xy_move(current_direction);
+    for (int i = get_nb_steps_done(); i < 8; ++i) {
+      offset += xy_move;
+      offsets.push_back(offset);
+    }
+    move_ends.push_back(offsets.size());
+    next_indexes.push_back(next_direction_index);
+    directions.push_back(current_direction);
+  }
+
+  size_t index = next_direction_index;
+  while (static_cast<int>(move_ends.size()) < num_moves) {
+    if (index >= initial_path.size()) {
+      if (!loop || initial_path.empty()) {
+        break;
+      }
+      index = 0;
+    }
+
+    const char direction_char = initial_path[index];
+    const int direction = direction_char - '0';
+    Debug::check_assertion(direction >= 0 && direction < 8,
+        std::string("Invalid path '") + initial_path + "' (bad direction '"
+        + direction_char + "')"
+    );
+    const Point& xy_move = Entity::direction_to_xy_move(direction);
+    for (int i = 0; i < 8; ++i) {
+      offset += xy_move;
+      offsets.push_back(offset);
+    }
+    ++index;
+    move_ends.push_back(offsets.size());
+    next_indexes.push_back(index);
+    directions.push_back(direction);
+  }
+
+  // Only make the moves that are entirely free.
+  const size_t num_free_offsets = get_num_free_offsets(offsets);
+  size_t num_moves_done = 0;
+  while (num_moves_done < move_ends.size() &&
+      move_ends[num_moves_done] <= num_free_offsets) {
+    ++num_moves_done;
+  }
+  if (num_moves_done == 0) {
+    return 0;
+  }
+
+  const size_t num_pixels = move_ends[num_moves_done - 1];
+  next_direction_index = next_indexes[num_moves_done - 1];
+  current_direction = directions[num_moves_done - 1];
+  total_distance_covered += static_cast<int>(num_pixels);
+
+  // Drop the elementary move in progress and start the next one, if any.
+  static const std::shared_ptr<const std::list<Point>> no_move =
+      std::make_shared<const std::list<Point>>();
+  PixelMovement::set_trajectory(no_move);
+  const uint64_t num_changes = get_num_changes();
+  set_xy(get_xy() + offsets[num_pixels - 1]);
+  if (get_entity() != nullptr && get_num_changes() == num_changes) {
+    // Not stopped or changed by a callback.
+    start_next_elementary_move();
+  }
+
+  return static_cast<int>(num_moves_done);
+}
+
 /**
  * \brief Returns the direction a sprite controlled by this movement should take.
  * \return the direction to use to display the object controlled by this movement (0 to 3)
@@ -20,6 +20,7 @@
 #include "solarus/lua/LuaContext.h"
 #include "solarus/movements/PixelMovement.h"
 #include <sstream>
+#include <vector>
 
 namespace Solarus {
 
@@ -51,7 +52,7 @@ PixelMovement::PixelMovement(
  * \return the succession of translations that compose this movement
  */
 const std::list<Point>& PixelMovement::get_trajectory() const {
-  return trajectory;
+  return *trajectory;
 }
 
 /**
@@ -66,8 +67,25 @@ const std::list<Point>& PixelMovement::get_trajectory() const {
  */
 void PixelMovement::set_trajectory(const std::list<Point>& trajectory) {
 
+  set_trajectory(std::make_shared<const std::list<Point>>(trajectory));
+}
+
+/**
+ * \brief Sets the trajectory of this movement, sharing an existing list.
+ *
+ * Use this to give the same trajectory to several movements without copying
+ * it each time.
+ *
+ * \param trajectory a list of points describing the succession of translations
+ * that compose this movement. It must not be modified afterwards.
+ */
+void PixelMovement::set_trajectory(const std::shared_ptr<const std::list<Point>>& trajectory) {
+
+  Debug::check_assertion(trajectory != nullptr, "Missing trajectory");
+
   this->trajectory = trajectory;
   this->trajectory_string = ""; // will be computed only on demand
+  increment_num_changes();
 
   restart();
 }
@@ -87,16 +105,18 @@ void PixelMovement::set_trajectory(const std::string& trajectory_string) {
   int dx = 0;
   int dy = 0;
 
-  trajectory.clear();
+  std::shared_ptr<std::list<Point>> trajectory = std::make_shared<std::list<Point>>();
   std::istringstream iss(trajectory_string);
   while (iss >> dx) {
     if (!(iss >> dy)) {
       Debug::die(std::string("Invalid trajectory string: '")
           + trajectory_string + "'");
     }
-    trajectory.emplace_back(dx, dy);
+    trajectory->emplace_back(dx, dy);
   }
+  this->trajectory = trajectory;
   this->trajectory_string = trajectory_string;
+  increment_num_changes();
 
   restart();
 }
@@ -152,7 +172,7 @@ void PixelMovement::restart() {
   else {
     nb_steps_done = 0;
     finished = false;
-    trajectory_iterator = trajectory.begin();
+    trajectory_iterator = trajectory->begin();
 
     if (next_move_date == 0) {
       // Keep the previous date if we just looped.
@@ -164,11 +184,27 @@ void PixelMovement::restart() {
   }
 }
 
+/**
+ * \brief Returns the number of steps already done in the current trajectory.
+ * \return The number of steps done since the trajectory started or looped.
+ */
+int PixelMovement::get_nb_steps_done() const {
+  return nb_steps_done;
+}
+
 /**
  * \brief Updates the position.
  */
 void PixelMovement::update() {
 
+  if (is_swept() &&
+      !is_suspended() &&
+      !finished &&
+      get_entity() != nullptr &&
+      get_entity()->get_movement().get() == this) {
+    make_free_steps();
+  }
+
   uint32_t now = System::now();
 
   while (now >= next_move_date &&
@@ -221,9 +257,9 @@ void PixelMovement::make_next_step() {
 
   ++trajectory_iterator;
 
-  if (trajectory_iterator == trajectory.end()) {
+  if (trajectory_iterator == trajectory->end()) {
     if (loop) {
-      trajectory_iterator = trajectory.begin();
+      trajectory_iterator = trajectory->begin();
     }
     else {
       finished = true;
@@ -240,6 +276,90 @@ void PixelMovement::make_next_step() {
   notify_step_done(step_index, success);
 }
 
+/**
+ * \brief Makes all steps to do now that are free of obstacles,
+ * testing obstacles only once for all of them.
+ *
+ * Each free step is still made separately so that detectors are checked
+ * at every intermediate position.
+ * Steps from the first one that reaches an obstacle are left to
+ * make_next_step().
+ */
+void PixelMovement::make_free_steps() {
+
+  if (trajectory->empty() || delay == 0) {
+    return;
+  }
+
+  // Simulate the steps to do now.
+  const uint32_t now = System::now();
+  uint32_t date = next_move_date;
+  std::list<Point>::const_iterator it = trajectory_iterator;
+  bool simulation_finished = false;
+  Point offset;
+  std::vector<Point> offsets;
+  while (now >= date && !simulation_finished) {
+
+    if (it->x == 0 && it->y == 0) {
+      // A step that does not move is reported as an obstacle: let update() do it.
+      break;
+    }
+    offset += *it;
+    offsets.push_back(offset);
+
+    ++it;
+    if (it == trajectory->end()) {
+      if (loop) {
+        it = trajectory->begin();
+      }
+      else {
+        simulation_finished = true;
+      }
+    }
+    if (!simulation_finished) {
+      date += delay;
+    }
+  }
+
+  const size_t num_free_steps = get_num_free_offsets(offsets);
+  if (num_free_steps == 0) {
+    return;
+  }
+
+  // Make the free steps one by one so that detectors see each position.
+  const Point initial_step_xy = get_xy();
+  const uint64_t num_changes = get_num_changes();
+  for (size_t i = 0; i < num_free_steps; ++i) {
+    const Point dxy = *trajectory_iterator;
+
+    // Update the state before moving because the move may trigger scripts.
+    ++trajectory_iterator;
+    if (trajectory_iterator == trajectory->end()) {
+      if (loop) {
+        trajectory_iterator = trajectory->begin();
+      }
+      else {
+        finished = true;
+      }
+    }
+    if (!finished) {
+      next_move_date += delay;
+    }
+    int step_index = nb_steps_done;
+    nb_steps_done++;
+
+    translate_xy(dxy);
+    notify_step_done(step_index, true);
+
+    if (finished ||
+        !can_continue_free_steps(initial_step_xy + offsets[i], num_changes)) {
+      // A collision or a script stopped, changed or moved the entity:
+      // the remaining steps are no longer valid.
+      return;
+    }
+  }
+}
+
 /**
  * \brief This function is called when a step of the trajectory just occurred.
  * \param step_index index of the step in the trajectory (the first one is 0)
@@ -253,7 +373,7 @@ void PixelMovement::notify_step_done(int /* step_index */, bool /* success */) {
  * \return the total number of moves in this trajectory
  */
 int PixelMovement::get_length() const {
-  return int(trajectory.size());
+  return int(trajectory->size());
 }
 
 /**
@@ -21,6 +21,8 @@
 #include "solarus/lua/LuaContext.h"
 #include "solarus/movements/StraightMovement.h"
 #include <cmath>
+#include <utility>
+#include <vector>
 
 namespace Solarus {
 
@@ -90,6 +92,37 @@ double StraightMovement::get_speed() const {
  */
 void StraightMovement::set_x_speed(double x_speed) {
 
+  update_x_speed(x_speed);
+  angle = Geometry::get_angle(0.0, 0.0, this->x_speed * 100.0, y_speed * 100.0);
+  initial_xy = get_xy();
+  finished = false;
+
+  notify_movement_changed();
+}
+
+/**
+ * \brief Sets the y speed.
+ * \param y_speed the y speed of the object in pixels per second
+ */
+void StraightMovement::set_y_speed(double y_speed) {
+
+  update_y_speed(y_speed);
+  angle = Geometry::get_angle(0.0, 0.0, x_speed * 100.0, this->y_speed * 100.0);
+  initial_xy = get_xy();
+  finished = false;
+
+  notify_movement_changed();
+}
+
+/**
+ * \brief Changes the x speed without updating the angle.
+ *
+ * Computes x_delay, x_move and next_move_date_x.
+ *
+ * \param x_speed the x speed of the object in pixels per second
+ */
+void StraightMovement::update_x_speed(double x_speed) {
+
   if (std::abs(x_speed) <= 1E-6) {
     x_speed = 0;
   }
@@ -112,18 +145,16 @@ void StraightMovement::set_x_speed(double x_speed) {
     }
     set_next_move_date_x(now + x_delay);
   }
-  angle = Geometry::get_angle(0.0, 0.0, x_speed * 100.0, y_speed * 100.0);
-  initial_xy = get_xy();
-  finished = false;
-
-  notify_movement_changed();
 }
 
 /**
- * \brief Sets the y speed.
+ * \brief Changes the y speed without updating the angle.
+ *
+ * Computes y_delay, y_move and next_move_date_y.
+ *
  * \param y_speed the y speed of the object in pixels per second
  */
-void StraightMovement::set_y_speed(double y_speed) {
+void StraightMovement::update_y_speed(double y_speed) {
 
   if (std::abs(y_speed) <= 1E-6) {
     y_speed = 0;
@@ -147,11 +178,6 @@ void StraightMovement::set_y_speed(double y_speed) {
     }
     set_next_move_date_y(now + y_delay);
   }
-  angle = Geometry::get_angle(0.0, 0.0, x_speed * 100.0, y_speed * 100.0);
-  initial_xy = get_xy();
-  finished = false;
-
-  notify_movement_changed();
 }
 
 /**
@@ -164,10 +190,10 @@ void StraightMovement::set_y_speed(double y_speed) {
 void StraightMovement::set_speed(double speed) {
 
   // compute the new speed vector
-  double old_angle = this->angle;
-  set_x_speed(speed * std::cos(old_angle));
-  set_y_speed(-speed * std::sin(old_angle));
-  this->angle = old_angle;
+  update_x_speed(speed * std::cos(angle));
+  update_y_speed(-speed * std::sin(angle));
+  initial_xy = get_xy();
+  finished = false;
 
   notify_movement_changed();
 }
@@ -185,12 +211,10 @@ bool StraightMovement::is_started() const {
  */
 void StraightMovement::stop() {
 
-  double old_angle = this->angle;
-  set_x_speed(0);
-  set_y_speed(0);
-  x_move = 0;
-  y_move = 0;
-  this->angle = old_angle;
+  update_x_speed(0);
+  update_y_speed(0);
+  initial_xy = get_xy();
+  finished = false;
 
   notify_movement_changed();
 }
@@ -244,8 +268,10 @@ void StraightMovement::set_angle(double angle) {
 
   if (!is_stopped()) {
     double speed = get_speed();
-    set_x_speed(speed * std::cos(angle));
-    set_y_speed(-speed * std::sin(angle));
+    update_x_speed(speed * std::cos(angle));
+    update_y_speed(-speed * std::sin(angle));
+    initial_xy = get_xy();
+    finished = false;
   }
   this->angle = angle;
 
@@ -640,6 +666,125 @@ void StraightMovement::update_non_smooth_xy() {
 
 }
 
+/**
+ * \brief Makes all steps of this update that are free of obstacles,
+ * testing obstacles only once for all of them.
+ *
+ * Steps are computed exactly like update_smooth_xy() and
+ * update_non_smooth_xy() would do, including the additional obstacle
+ * tests of the smooth mode.
+ * Each free step is still made separately so that detectors are checked
+ * at every intermediate position.
+ * Steps from the first one that reaches an obstacle are left to them.
+ */
+void StraightMovement::update_swept_xy() {
+
+  if (get_entity() == nullptr ||
+      (x_move != 0 && x_delay == 0) ||
+      (y_move != 0 && y_delay == 0)) {
+    return;
+  }
+
+  // Simulate the steps to do now.
+  const uint32_t now = System::now();
+  uint32_t date_x = next_move_date_x;
+  uint32_t date_y = next_move_date_y;
+  Point offset;
+  std::vector<Point> offsets;    // Positions to test.
+  std::vector<size_t> step_ends; // Number of positions to test up to each step.
+  std::vector<Point> step_offsets;
+  std::vector<std::pair<uint32_t, uint32_t>> step_dates;
+  bool max_distance_reached = false;
+
+  bool x_move_now = x_move != 0 && now >= date_x;
+  bool y_move_now = y_move != 0 && now >= date_y;
+  while ((x_move_now || y_move_now) && !max_distance_reached) {
+
+    if (!is_smooth()) {
+      if (x_move_now && y_move_now) {
+        offset += Point(x_move, y_move);
+        date_x += x_delay;
+        date_y += y_delay;
+      }
+      else if (x_move_now) {
+        offset.x += x_move;
+        date_x += x_delay;
+      }
+      else {
+        offset.y += y_move;
+        date_y += y_delay;
+      }
+      offsets.push_back(offset);
+    }
+    else {
+      // Same order as update_smooth_xy().
+      // In smooth mode, a successful move also tests the other axis.
+      const bool x_first = x_move_now && (!y_move_now || date_x <= date_y);
+      for (int i = 0; i < 2; ++i) {
+        const bool move_x = (i == 0) == x_first;
+        if (move_x && x_move != 0 && now >= date_x) {
+          offset.x += x_move;
+          date_x += x_delay;
+          offsets.push_back(offset);
+          if (y_move != 0) {
+            offsets.push_back(offset + Point(0, y_move));
+          }
+        }
+        else if (!move_x && y_move != 0 && now >= date_y) {
+          offset.y += y_move;
+          date_y += y_delay;
+          offsets.push_back(offset);
+          if (x_move != 0) {
+            offsets.push_back(offset + Point(x_move, 0));
+          }
+        }
+      }
+    }
+
+    step_ends.push_back(offsets.size());
+    step_offsets.push_back(offset);
+    step_dates.emplace_back(date_x, date_y);
+
+    max_distance_reached = max_distance != 0 &&
+        Geometry::get_distance(initial_xy, get_xy() + offset) >= max_distance;
+    x_move_now = x_move != 0 && now >= date_x;
+    y_move_now = y_move != 0 && now >= date_y;
+  }
+
+  // Keep the steps whose positions are all free.
+  const size_t num_free_offsets = get_num_free_offsets(offsets);
+  size_t num_free_steps = 0;
+  while (num_free_steps < step_ends.size() &&
+      step_ends[num_free_steps] <= num_free_offsets) {
+    ++num_free_steps;
+  }
+  if (num_free_steps == 0) {
+    return;
+  }
+
+  // Make the free steps one by one so that detectors see each position.
+  const Point initial_step_xy = get_xy();
+  const uint64_t num_changes = get_num_changes();
+  Point previous_offset;
+  for (size_t i = 0; i < num_free_steps; ++i) {
+    next_move_date_x = step_dates[i].first;
+    next_move_date_y = step_dates[i].second;
+    translate_xy(step_offsets[i] - previous_offset);
+    previous_offset = step_offsets[i];
+
+    if (!can_continue_free_steps(initial_step_xy + step_offsets[i], num_changes)) {
+      // A collision or a script stopped, changed or moved the entity:
+      // the remaining steps are no longer valid.
+      return;
+    }
+  }
+
+  if (!finished && max_distance != 0 &&
+      Geometry::get_distance(initial_xy, get_xy()) >= max_distance) {
+    set_finished();
+  }
+}
+
 /**
  * \brief Updates the position of the object controlled by this movement.
  *
@@ -649,6 +794,10 @@ void StraightMovement::update() {
 
   if (!is_suspended()) {
 
+    if (is_swept()) {
+      update_swept_xy();
+    }
+
     uint32_t now = System::now();
     bool x_move_now = x_move != 0 && now >= next_move_date_x;
     bool y_move_now = y_move != 0 && now >= next_move_date_y;
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/CurrentQuest.h"
+#include "solarus/core/Debug.h"
+#include "solarus/core/DialogBoxSystem.h"
+#include "solarus/core/DialogResources.h"
+#include "solarus/core/Logger.h"
+#include "solarus/core/QuestDatabase.h"
+#include "solarus/graphics/TextSurface.h"
+#include "test_tools/TestEnvironment.h"
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Cost of revealing the text of a dialog character by character.
+ */
+struct RevealCost {
+  long long time_us = 0;        /**< Time spent updating text surfaces. */
+  size_t surface_bytes = 0;     /**< Pixels of the surfaces showing the full lines. */
+};
+
+/**
+ * \brief Returns the number of microseconds elapsed since a date.
+ */
+long long get_elapsed_us(const std::chrono::steady_clock::time_point& start) {
+
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start
+  ).count();
+}
+
+/**
+ * \brief Reveals the lines of a dialog one character at a time.
+ * \param lines The lines of the dialog.
+ * \param redraw \c true to draw each step in a new text surface,
+ * \c false to append the new character to the same text surface.
+ * \return The time spent and the memory of the final surfaces.
+ */
+RevealCost reveal_lines(const std::vector<std::string>& lines, bool redraw) {
+
+  RevealCost cost;
+  for (const std::string& line : lines) {
+    std::shared_ptr<TextSurface> text_surface = std::make_shared<TextSurface>(0, 0);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 1; i <= line.size(); ++i) {
+      if (i < line.size() && (line[i] & 0xC0) == 0x80) {
+        // Reveal whole UTF-8 characters only.
+        continue;
+      }
+      if (redraw) {
+        text_surface = std::make_shared<TextSurface>(0, 0);
+      }
+      text_surface->set_text(line.substr(0, i));
+    }
+    cost.time_us += get_elapsed_us(start);
+    cost.surface_bytes += text_surface->get_width() * text_surface->get_height() * 4;
+  }
+  return cost;
+}
+
+/**
+ * \brief Reports the cost of revealing every dialog of a language.
+ */
+void check_dialogs(TestEnvironment& /* env */, const std::string& language_id) {
+
+  DialogResources dialog_resources;
+  const std::string& file_name = "languages/" + language_id + "/text/dialogs.dat";
+  Debug::check_assertion(dialog_resources.import_from_quest_file(file_name), "Dialogs import failed");
+
+  RevealCost total_appended;
+  RevealCost total_redrawn;
+  for (const auto& kvp : dialog_resources.get_dialogs()) {
+    const std::vector<std::string>& lines = DialogBoxSystem::split_lines(kvp.second.get_text());
+    const RevealCost& appended = reveal_lines(lines, false);
+    const RevealCost& redrawn = reveal_lines(lines, true);
+    Debug::check_assertion(appended.surface_bytes == redrawn.surface_bytes,
+        "Dialog '" + kvp.first + "': appended text has a different size");
+
+    std::ostringstream oss;
+    oss << "Dialog '" << kvp.first << "' (" << language_id << "): "
+        << lines.size() << " lines, " << appended.surface_bytes << " bytes, reveal "
+        << appended.time_us << " us (" << redrawn.time_us << " us if redrawn)";
+    Logger::info(oss.str());
+
+    total_appended.time_us += appended.time_us;
+    total_appended.surface_bytes += appended.surface_bytes;
+    total_redrawn.time_us += redrawn.time_us;
+  }
+
+  std::ostringstream oss;
+  oss << "All dialogs (" << language_id << "): " << dialog_resources.get_dialogs().size()
+      << " dialogs, " << total_appended.surface_bytes << " bytes, reveal "
+      << total_appended.time_us << " us (" << total_redrawn.time_us << " us if redrawn)";
+  Logger::info(oss.str());
+}
+
+}
+
+/**
+ * Tests revealing dialogs and reports their cost.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  const std::map<std::string, std::string>& language_elements =
+      CurrentQuest::get_database().get_resource_elements(ResourceType::LANGUAGE);
+  Debug::check_assertion(!language_elements.empty(), "No languages");
+  for (const auto& kvp : language_elements) {
+    check_dialogs(env, kvp.first);
+  }
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/Geometry.h"
+#include "test_tools/TestEnvironment.h"
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Tests exact entries of the table of angles in degrees.
+ */
+void test_sin_cos_degrees(TestEnvironment& /* env */) {
+
+  const std::vector<std::pair<int, double>> expected_sines = {
+      { 0, 0.0 },
+      { 1, 0.01745240643728351 },
+      { 30, 0.5 },
+      { 45, 0.7071067811865476 },
+      { 60, 0.8660254037844386 },
+      { 89, 0.9998476951563913 },
+      { 90, 1.0 },
+      { 150, 0.5 },
+      { 180, 0.0 },
+      { 210, -0.5 },
+      { 270, -1.0 },
+      { 315, -0.7071067811865476 },
+      { 359, -0.01745240643728351 },
+      { 360, 0.0 },
+      { -90, -1.0 },
+      { 750, 0.5 },
+  };
+  for (const auto& expected : expected_sines) {
+    const int angle = expected.first;
+    Debug::check_assertion(Geometry::get_sin_degrees(angle) == expected.second,
+        "Wrong sine for angle " + std::to_string(angle));
+    Debug::check_assertion(Geometry::get_cos_degrees(angle - 90) == expected.second,
+        "Wrong cosine for angle " + std::to_string(angle - 90));
+  }
+}
+
+/**
+ * \brief Tests vectors computed from the table of angles in degrees.
+ */
+void test_get_xy_degrees(TestEnvironment& /* env */) {
+
+  const Point origin(16, -8);
+  Debug::check_assertion(Geometry::get_xy_degrees(origin, 0, 100) == Point(116, -8),
+      "Wrong vector for angle 0");
+  Debug::check_assertion(Geometry::get_xy_degrees(origin, 30, 100) == Point(102, -58),
+      "Wrong vector for angle 30");
+  Debug::check_assertion(Geometry::get_xy_degrees(origin, 90, 100) == Point(16, -108),
+      "Wrong vector for angle 90");
+  Debug::check_assertion(Geometry::get_xy_degrees(origin, 180, 100) == Point(-84, -8),
+      "Wrong vector for angle 180");
+  Debug::check_assertion(Geometry::get_xy_degrees(origin, 240, 100) == Point(-34, 78),
+      "Wrong vector for angle 240");
+  Debug::check_assertion(Geometry::get_xy_degrees(origin, 270, 100) == Point(16, 92),
+      "Wrong vector for angle 270");
+
+  // Other vectors are at most one pixel away from the ones computed from
+  // radians, where the angle is rounded.
+  for (int angle = 0; angle < 360; ++angle) {
+    for (int distance : { 0, 1, 16, 100, 12345 }) {
+      const Point expected = Geometry::get_xy(
+          origin, Geometry::degrees_to_radians(angle), distance);
+      const Point actual = Geometry::get_xy_degrees(origin, angle, distance);
+      Debug::check_assertion(
+          std::abs(actual.x - expected.x) <= 1 &&
+          std::abs(actual.y - expected.y) <= 1,
+          "Wrong vector for angle " + std::to_string(angle) +
+          " and distance " + std::to_string(distance));
+    }
+  }
+}
+
+}
+
+/**
+ * Tests for the geometry functions.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  test_sin_cos_degrees(env);
+  test_get_xy_degrees(env);
+
+  return 0;
+}
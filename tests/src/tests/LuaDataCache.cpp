@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/CurrentQuest.h"
+#include "solarus/core/Debug.h"
+#include "solarus/core/MapData.h"
+#include "solarus/core/QuestDatabase.h"
+#include "solarus/core/QuestFiles.h"
+#include "solarus/lua/LuaDataCache.h"
+#include "test_tools/TestEnvironment.h"
+#include <lua.hpp>
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Checks that a map gives the same data with and without the cache.
+ */
+void check_map(TestEnvironment& /* env */, const std::string& map_id) {
+
+  const std::string& file_name = "maps/" + map_id + ".dat";
+  const std::string& buffer = QuestFiles::data_file_read(file_name);
+
+  MapData reference_data;
+  bool success = reference_data.import_from_buffer(buffer, file_name);
+  Debug::check_assertion(success, "Map import failed");
+
+  // Twice: the second time, the chunk comes from the cache.
+  for (int i = 0; i < 2; ++i) {
+    MapData cached_data;
+    success = cached_data.import_from_quest_file(file_name);
+    Debug::check_assertion(success, "Map import from cache failed");
+
+    std::string reference_buffer;
+    std::string cached_buffer;
+    reference_data.export_to_buffer(reference_buffer);
+    cached_data.export_to_buffer(cached_buffer);
+    Debug::check_assertion(cached_buffer == reference_buffer,
+        "Map '" + map_id + "' differs when loaded from the cache");
+  }
+}
+
+/**
+ * \brief Checks that the cache never returns the chunk of another content.
+ */
+void check_modified_content() {
+
+  lua_State* l = luaL_newstate();
+
+  const std::string file_name = "lua_data_cache_test.dat";
+  int result = LuaDataCache::load_buffer(l, "value = 1", file_name);
+  Debug::check_assertion(result == 0, "Failed to load chunk");
+  lua_call(l, 0, 0);
+  lua_getglobal(l, "value");
+  Debug::check_assertion(lua_tointeger(l, -1) == 1, "Wrong value");
+  lua_pop(l, 1);
+
+  result = LuaDataCache::load_buffer(l, "value = 2", file_name);
+  Debug::check_assertion(result == 0, "Failed to load modified chunk");
+  lua_call(l, 0, 0);
+  lua_getglobal(l, "value");
+  Debug::check_assertion(lua_tointeger(l, -1) == 2, "Stale chunk loaded");
+  lua_pop(l, 1);
+
+  // Preparsed content must be compared exactly, not by hash.
+  LuaDataCache::preparse({ file_name });
+  result = LuaDataCache::load_buffer(l, "value = 3", file_name);
+  Debug::check_assertion(result == 0, "Failed to load chunk");
+  lua_call(l, 0, 0);
+  lua_getglobal(l, "value");
+  Debug::check_assertion(lua_tointeger(l, -1) == 3, "Chunk of another content loaded");
+  lua_pop(l, 1);
+
+  result = LuaDataCache::load_buffer(l, "value = ", file_name);
+  Debug::check_assertion(result != 0, "Syntax error not detected");
+  Debug::check_assertion(lua_isstring(l, -1), "Missing error message");
+  lua_pop(l, 1);
+
+  lua_close(l);
+}
+
+/**
+ * \brief Checks that preparsed files are released once loaded.
+ */
+void check_released_memory(const std::map<std::string, std::string>& map_elements) {
+
+  LuaDataCache::quit();
+  Debug::check_assertion(LuaDataCache::get_retained_size() == 0,
+      "Memory retained after quit");
+
+  std::vector<std::string> file_names;
+  for (const auto& kvp : map_elements) {
+    file_names.push_back("maps/" + kvp.first + ".dat");
+  }
+  LuaDataCache::preparse(file_names);
+
+  for (const std::string& file_name : file_names) {
+    MapData data;
+    Debug::check_assertion(data.import_from_quest_file(file_name),
+        "Map import failed");
+  }
+  Debug::check_assertion(LuaDataCache::get_retained_size() == 0,
+      "Preparsed maps still in memory after loading them");
+}
+
+}
+
+/**
+ * Tests the cache of compiled data files.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  const std::map<std::string, std::string>& map_elements =
+      CurrentQuest::get_database().get_resource_elements(ResourceType::MAP);
+  Debug::check_assertion(!map_elements.empty(), "No maps");
+  for (const auto& kvp : map_elements) {
+    check_map(env, kvp.first);
+  }
+
+  check_modified_content();
+  check_released_memory(map_elements);
+
+  return 0;
+}
+
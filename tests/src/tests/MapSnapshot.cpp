@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/Map.h"
+#include "solarus/core/MapSnapshot.h"
+#include "solarus/entities/CustomEntity.h"
+#include "test_tools/TestEnvironment.h"
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Tests restoring the position and state of entities.
+ */
+void restore_test(TestEnvironment& env) {
+
+  Map& map = env.get_map();
+  std::shared_ptr<CustomEntity> entity = env.make_entity<CustomEntity>({ 160, 177 });
+  entity->set_direction(1);
+
+  const MapSnapshot snapshot(map);
+  Debug::check_assertion(snapshot.get_map_id() == map.get_id(),
+      "Unexpected map id");
+  Debug::check_assertion(snapshot.get_num_entities() > 0,
+      "No entities captured");
+
+  entity->set_xy(200, 97);
+  entity->notify_position_changed();
+  entity->set_direction(3);
+  entity->set_enabled(false);
+  env.step();
+
+  snapshot.restore(map);
+  Debug::check_assertion(entity->get_xy() == Point(160, 177),
+      "Position was not restored");
+  Debug::check_assertion(entity->get_direction() == 1,
+      "Direction was not restored");
+  Debug::check_assertion(entity->is_enabled(),
+      "Enabled state was not restored");
+}
+
+/**
+ * \brief Tests that entities created after a snapshot are kept
+ * and that removed ones are ignored.
+ */
+void new_and_removed_entities_test(TestEnvironment& env) {
+
+  Map& map = env.get_map();
+  std::shared_ptr<CustomEntity> removed_entity = env.make_entity<CustomEntity>({ 80, 77 });
+  const MapSnapshot snapshot(map);
+
+  std::shared_ptr<CustomEntity> new_entity = env.make_entity<CustomEntity>({ 120, 77 });
+  removed_entity->set_xy(88, 77);
+  removed_entity->remove_from_map();
+  env.step();
+
+  snapshot.restore(map);
+  Debug::check_assertion(new_entity->get_xy() == Point(120, 77),
+      "An entity created after the snapshot was changed");
+  Debug::check_assertion(removed_entity->get_xy() == Point(88, 77),
+      "A removed entity was restored");
+}
+
+}
+
+/**
+ * Tests for map snapshots.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  restore_test(env);
+  new_and_removed_entities_test(env);
+
+  return 0;
+}
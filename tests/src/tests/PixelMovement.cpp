@@ -17,6 +17,8 @@
 #include "solarus/core/Debug.h"
 #include "solarus/movements/PixelMovement.h"
 #include "test_tools/TestEnvironment.h"
+#include <list>
+#include <memory>
 
 using namespace Solarus;
 
@@ -118,6 +120,37 @@ void list_test(TestEnvironment& env) {
       "Unexpected coordinates for 'list_test'");
 }
 
+/**
+ * \brief Tests two pixel movements sharing the same trajectory.
+ */
+void shared_list_test(TestEnvironment& env) {
+
+  const std::shared_ptr<const std::list<Point>> trajectory =
+      std::make_shared<const std::list<Point>>(
+          std::list<Point>{ { 1, 0 }, { 0, 2 } }
+      );
+
+  PixelMovement m1("", 50, false, false);
+  PixelMovement m2("", 50, true, false);
+  m1.set_trajectory(trajectory);
+  m2.set_trajectory(trajectory);
+
+  Debug::check_assertion(&m1.get_trajectory() == &m2.get_trajectory(),
+      "Trajectory is not shared in 'shared_list_test'");
+
+  while (!m1.is_finished()) {
+
+    m1.update();
+    m2.update();
+    env.step();
+  }
+
+  Debug::check_assertion(m1.get_x() == 1 && m1.get_y() == 2,
+      "Unexpected coordinates for 'shared_list_test'");
+  Debug::check_assertion(m2.get_x() == 1 && m2.get_y() == 2,
+      "Unexpected coordinates for 'shared_list_test'");
+}
+
 }
 
 /**
@@ -132,6 +165,7 @@ int main(int argc, char** argv) {
   empty_test(env);
   restart_test(env);
   list_test(env);
+  shared_list_test(env);
 
   return 0;
 }
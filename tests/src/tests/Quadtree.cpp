@@ -176,6 +176,23 @@ void test_add_big_size(TestEnvironment& /* env */, Quadtree<ElementPtr>& quadtre
   add(quadtree, Box(100, 0, 16, 960));
 }
 
+/**
+ * \brief Tests getting elements into an existing list.
+ */
+void test_get_elements_into_list(TestEnvironment& /* env */, Quadtree<ElementPtr>& quadtree) {
+
+  const Box region(0, 0, 640, 480);
+  const std::vector<ElementPtr>& expected = quadtree.get_elements(region);
+
+  // Previous content must be replaced and big elements found only once.
+  std::vector<ElementPtr> elements = { std::make_shared<Element>(Box(0, 0, 1, 1)) };
+  quadtree.get_elements(region, elements);
+  Debug::check_assertion(elements.size() == expected.size(), "Wrong number of elements found");
+  for (ElementPtr element : expected) {
+    check_found(elements, element);
+  }
+}
+
 /**
  * \brief Tests adding elements near the limit or outside the quadtree space.
  */
@@ -250,6 +267,7 @@ int main(int argc, char** argv) {
   test_empty(env, quadtree);
   test_add(env, quadtree);
   test_add_big_size(env, quadtree);
+  test_get_elements_into_list(env, quadtree);
   test_add_limit(env, quadtree);
   test_add_center_outside(env, quadtree);
   test_remove(env, quadtree);
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/CurrentQuest.h"
+#include "solarus/core/Debug.h"
+#include "solarus/core/QuestDatabase.h"
+#include "solarus/core/ResourceProvider.h"
+#include "test_tools/TestEnvironment.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Returns the ids of all maps of the quest.
+ */
+std::vector<std::string> get_map_ids() {
+
+  std::vector<std::string> map_ids;
+  const std::map<std::string, std::string>& map_elements =
+      CurrentQuest::get_database().get_resource_elements(ResourceType::MAP);
+  for (const auto& kvp : map_elements) {
+    map_ids.push_back(kvp.first);
+  }
+  return map_ids;
+}
+
+/**
+ * \brief Checks that the least recently used map data is evicted.
+ */
+void check_map_data_cache(TestEnvironment& /* env */) {
+
+  const std::vector<std::string>& map_ids = get_map_ids();
+  Debug::check_assertion(map_ids.size() >= 9, "Not enough maps");
+
+  ResourceProvider resource_provider;
+  std::vector<std::shared_ptr<const MapData>> map_data;
+  for (int i = 0; i < 8; ++i) {
+    map_data.push_back(resource_provider.get_map_data(map_ids[i]));
+    Debug::check_assertion(map_data[i] != nullptr, "Missing map data");
+  }
+
+  // All 8 maps are cached.
+  for (int i = 0; i < 8; ++i) {
+    Debug::check_assertion(resource_provider.get_map_data(map_ids[i]) == map_data[i],
+        "Map data not cached");
+  }
+
+  // Map 0 was used last: map 1 is the least recently used one.
+  resource_provider.get_map_data(map_ids[0]);
+  resource_provider.get_map_data(map_ids[8]);
+  Debug::check_assertion(resource_provider.get_map_data(map_ids[0]) == map_data[0],
+      "Recently used map data evicted");
+  Debug::check_assertion(resource_provider.get_map_data(map_ids[1]) != map_data[1],
+      "Least recently used map data not evicted");
+
+  // Invalidation.
+  resource_provider.invalidate_resource_element(ResourceType::MAP, map_ids[0]);
+  std::shared_ptr<const MapData> reloaded_data = resource_provider.get_map_data(map_ids[0]);
+  Debug::check_assertion(reloaded_data != nullptr, "Missing map data");
+  Debug::check_assertion(reloaded_data != map_data[0], "Invalidated map data still cached");
+}
+
+/**
+ * \brief Checks loading maps in background.
+ */
+void check_preload_map(TestEnvironment& /* env */) {
+
+  const std::vector<std::string>& map_ids = get_map_ids();
+
+  ResourceProvider resource_provider;
+  resource_provider.preload_map(map_ids[0]);
+  resource_provider.preload_map(map_ids[0]);  // Already being preloaded.
+  std::shared_ptr<const MapData> data = resource_provider.get_map_data(map_ids[0]);
+  Debug::check_assertion(data != nullptr, "Missing preloaded map data");
+  const Tileset& tileset = resource_provider.get_tileset(data->get_tileset_id());
+  Debug::check_assertion(tileset.is_loaded(), "Tileset not preloaded");
+
+  resource_provider.preload_map(map_ids[0]);  // Already cached.
+  Debug::check_assertion(resource_provider.get_map_data(map_ids[0]) == data,
+      "Preloaded map data not cached");
+
+  // Invalidation while the map is being preloaded.
+  resource_provider.invalidate_resource_element(ResourceType::MAP, map_ids[0]);
+  resource_provider.preload_map(map_ids[0]);
+  resource_provider.invalidate_resource_element(ResourceType::MAP, map_ids[0]);
+  std::shared_ptr<const MapData> reloaded_data = resource_provider.get_map_data(map_ids[0]);
+  Debug::check_assertion(reloaded_data != nullptr, "Missing map data");
+  Debug::check_assertion(reloaded_data != data, "Invalidated map data still cached");
+
+  // Preloading unknown maps is ignored.
+  resource_provider.preload_map(map_ids[1]);
+  resource_provider.preload_map("no_such_map");
+  resource_provider.finish_all_map_preloading();
+  resource_provider.update();
+  Debug::check_assertion(resource_provider.get_map_data(map_ids[1]) != nullptr,
+      "Missing preloaded map data");
+}
+
+}
+
+/**
+ * Tests the resource provider.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  check_map_data_cache(env);
+  check_preload_map(env);
+
+  return 0;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/Logger.h"
+#include "solarus/core/QuestFiles.h"
+#include "solarus/core/Savegame.h"
+#include "solarus/core/SavegameKey.h"
+#include "solarus/core/SolarusFatal.h"
+#include "solarus/core/String.h"
+#include "test_tools/TestEnvironment.h"
+#include <chrono>
+#include <memory>
+#include <sstream>
+
+using namespace Solarus;
+
+namespace {
+
+constexpr int num_test_values = 3000;
+const std::string test_file_name = "savegame_format_test.dat";
+
+/**
+ * \brief Returns the number of microseconds elapsed since a date.
+ */
+long long get_elapsed_us(const std::chrono::steady_clock::time_point& start) {
+
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start
+  ).count();
+}
+
+/**
+ * \brief Creates a savegame object and loads its file if any.
+ */
+std::shared_ptr<Savegame> load_savegame(TestEnvironment& env) {
+
+  std::shared_ptr<Savegame> savegame = std::make_shared<Savegame>(
+      env.get_main_loop(), test_file_name
+  );
+  savegame->initialize();
+  return savegame;
+}
+
+/**
+ * \brief Sets many values of all types in a savegame.
+ */
+void fill_savegame(Savegame& savegame) {
+
+  for (int i = 0; i < num_test_values; ++i) {
+    std::ostringstream oss;
+    oss << i;
+    const std::string& suffix = oss.str();
+    savegame.set_integer("integer_" + suffix, i * 7 - 1000);
+    savegame.set_string("string_" + suffix, "value " + String::to_string(i % 10));
+    savegame.set_boolean("boolean_" + suffix, i % 3 == 0);
+  }
+  savegame.set_string("special_string", "");
+}
+
+/**
+ * \brief Checks that a savegame contains the values set by fill_savegame().
+ */
+void check_savegame(const Savegame& savegame) {
+
+  for (int i = 0; i < num_test_values; ++i) {
+    std::ostringstream oss;
+    oss << i;
+    const std::string& suffix = oss.str();
+    Debug::check_assertion(savegame.get_integer("integer_" + suffix) == i * 7 - 1000,
+        "Wrong integer value for index " + suffix);
+    Debug::check_assertion(savegame.get_string("string_" + suffix) == "value " + String::to_string(i % 10),
+        "Wrong string value for index " + suffix);
+    Debug::check_assertion(savegame.get_boolean("boolean_" + suffix) == (i % 3 == 0),
+        "Wrong boolean value for index " + suffix);
+  }
+  Debug::check_assertion(savegame.is_string("special_string"), "Missing empty string value");
+}
+
+/**
+ * \brief Saves and reloads a savegame in the given format and reports timings.
+ */
+void test_round_trip(TestEnvironment& env, SavegameFormat format) {
+
+  QuestFiles::data_file_delete(test_file_name);
+
+  std::shared_ptr<Savegame> savegame = load_savegame(env);
+  Debug::check_assertion(savegame->is_empty(), "Savegame should be empty");
+  fill_savegame(*savegame);
+  savegame->set_format(format);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  savegame->save();
+  const long long save_time = get_elapsed_us(start);
+
+  start = std::chrono::steady_clock::now();
+  std::shared_ptr<Savegame> loaded_savegame = load_savegame(env);
+  const long long load_time = get_elapsed_us(start);
+
+  Debug::check_assertion(!loaded_savegame->is_empty(), "Savegame should exist");
+  Debug::check_assertion(loaded_savegame->get_format() == format, "Wrong savegame format detected");
+  check_savegame(*loaded_savegame);
+
+  std::ostringstream oss;
+  oss << "Savegame format '" << enum_to_name(format) << "' with "
+      << num_test_values * 3 << " values: save " << save_time
+      << " us, load " << load_time << " us";
+  Logger::info(oss.str());
+
+  QuestFiles::data_file_delete(test_file_name);
+}
+
+/**
+ * \brief Checks that interned keys and names access the same values.
+ */
+void test_keys(TestEnvironment& env) {
+
+  const SavegameKey key("interned_key");
+  Debug::check_assertion(SavegameKey("interned_key") == key, "Key interned twice");
+  Debug::check_assertion(SavegameKey("other_key") != key, "Different names share a key");
+  Debug::check_assertion(key.get_name() == "interned_key", "Wrong key name");
+  Debug::check_assertion(key.is_valid_name(), "Key should be valid");
+  Debug::check_assertion(!SavegameKey("not a key").is_valid_name(), "Key should be invalid");
+
+  QuestFiles::data_file_delete(test_file_name);
+  std::shared_ptr<Savegame> savegame = load_savegame(env);
+  savegame->set_integer(key, 42);
+  Debug::check_assertion(savegame->get_integer("interned_key") == 42, "Wrong value by name");
+  savegame->unset("interned_key");
+  Debug::check_assertion(!savegame->is_set(key), "Value should be unset");
+  Debug::check_assertion(savegame->get_integer(Savegame::KEY_MAX_LIFE) == 1, "Wrong built-in value");
+
+  // Reading unknown names does not intern them.
+  const size_t num_keys = SavegameKey::get_num_keys();
+  Debug::check_assertion(!savegame->is_set("never_stored_key"), "Value should be unset");
+  Debug::check_assertion(savegame->get_integer("never_stored_key") == 0, "Wrong default value");
+  savegame->unset("never_stored_key");
+  SavegameKey found_key;
+  Debug::check_assertion(!SavegameKey::find("never_stored_key", found_key), "Key should not exist");
+  Debug::check_assertion(SavegameKey::get_num_keys() == num_keys, "Reading interned a key");
+  Debug::check_assertion(SavegameKey::find("interned_key", found_key) && found_key == key, "Key not found");
+
+  // Invalid names are rejected before being interned.
+  bool rejected = false;
+  Debug::set_abort_on_die(false);
+  try {
+    savegame->set_integer("not a valid key", 1);
+  }
+  catch (const SolarusFatal&) {
+    rejected = true;
+  }
+  Debug::set_abort_on_die(true);
+  Debug::check_assertion(rejected, "Invalid key accepted");
+  Debug::check_assertion(!SavegameKey::find("not a valid key", found_key), "Invalid key was interned");
+}
+
+/**
+ * \brief Checks that unset values are not written to savegame files.
+ */
+void test_unset_values(TestEnvironment& env, SavegameFormat format) {
+
+  QuestFiles::data_file_delete(test_file_name);
+  std::shared_ptr<Savegame> savegame = load_savegame(env);
+  savegame->set_format(format);
+  savegame->set_integer("kept_value", 10);
+  savegame->set_string("removed_value", "removed");
+  savegame->set_boolean("last_value", true);
+  savegame->unset("removed_value");
+  savegame->save();
+
+  std::shared_ptr<Savegame> loaded_savegame = load_savegame(env);
+  Debug::check_assertion(loaded_savegame->get_format() == format, "Wrong savegame format detected");
+  Debug::check_assertion(!loaded_savegame->is_set("removed_value"), "Unset value was saved");
+  Debug::check_assertion(loaded_savegame->get_integer("kept_value") == 10, "Wrong value before unset one");
+  Debug::check_assertion(loaded_savegame->get_boolean("last_value"), "Wrong value after unset one");
+  QuestFiles::data_file_delete(test_file_name);
+}
+
+/**
+ * \brief Checks that files do not depend on the order values were set in.
+ */
+void test_stable_order(TestEnvironment& env, SavegameFormat format) {
+
+  std::string contents[2];
+  for (int pass = 0; pass < 2; ++pass) {
+    QuestFiles::data_file_delete(test_file_name);
+    std::shared_ptr<Savegame> savegame = load_savegame(env);
+    savegame->set_format(format);
+    for (int i = 0; i < 100; ++i) {
+      const int index = (pass == 0) ? i : 99 - i;
+      savegame->set_integer("order_" + String::to_string(index), index);
+    }
+    savegame->save();
+    contents[pass] = QuestFiles::data_file_read(test_file_name);
+  }
+
+  Debug::check_assertion(contents[0] == contents[1],
+      "Savegame file depends on the order of values");
+  QuestFiles::data_file_delete(test_file_name);
+}
+
+}
+
+/**
+ * Tests for savegame file formats.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  test_round_trip(env, SavegameFormat::TEXT);
+  test_round_trip(env, SavegameFormat::BINARY);
+  test_keys(env);
+  test_unset_values(env, SavegameFormat::TEXT);
+  test_unset_values(env, SavegameFormat::BINARY);
+  test_stable_order(env, SavegameFormat::TEXT);
+  test_stable_order(env, SavegameFormat::BINARY);
+
+  return 0;
+}
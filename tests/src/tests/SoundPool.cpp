@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/audio/SoundPool.h"
+#include "solarus/core/Debug.h"
+#include "test_tools/TestEnvironment.h"
+#include <vector>
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Tests that free voices are used first.
+ */
+void test_free_voice(TestEnvironment& /* env */) {
+
+  std::vector<SoundPool::VoiceState> voices = {
+      { false, 0, 1 },
+      { true, 0, 0 },
+      { true, 0, 0 }
+  };
+  Debug::check_assertion(SoundPool::choose_voice(voices, 0) == 1,
+      "Expected the first free voice");
+
+  voices.clear();
+  Debug::check_assertion(SoundPool::choose_voice(voices, 0) == -1,
+      "Expected no voice");
+}
+
+/**
+ * \brief Tests replacing a sound when all voices are busy.
+ */
+void test_priority_stealing(TestEnvironment& /* env */) {
+
+  const std::vector<SoundPool::VoiceState> voices = {
+      { false, 2, 1 },
+      { false, 1, 5 },
+      { false, 1, 3 },
+      { false, 3, 0 }
+  };
+
+  // The oldest sound of the lowest priority is replaced.
+  Debug::check_assertion(SoundPool::choose_voice(voices, 1) == 2,
+      "Expected the oldest sound of lowest priority");
+  Debug::check_assertion(SoundPool::choose_voice(voices, 3) == 2,
+      "Expected the oldest sound of lowest priority");
+
+  // Sounds of higher priority are never replaced.
+  Debug::check_assertion(SoundPool::choose_voice(voices, 0) == -1,
+      "A more important sound was replaced");
+}
+
+/**
+ * \brief Tests unloading the least recently played sounds.
+ */
+void test_cache(TestEnvironment& /* env */) {
+
+  std::vector<SoundPool::CachedSound> sounds = {
+      { 100, 4, true },
+      { 100, 1, true },
+      { 100, 2, false },  // Playing.
+      { 100, 3, true }
+  };
+
+  // Everything fits.
+  Debug::check_assertion(SoundPool::choose_sounds_to_unload(sounds, 400).empty(),
+      "No sound should be unloaded");
+
+  // Least recently played first, skipping the one playing.
+  std::vector<size_t> to_unload = SoundPool::choose_sounds_to_unload(sounds, 200);
+  Debug::check_assertion(to_unload == std::vector<size_t>({ 1, 3 }),
+      "Expected the least recently played sounds");
+
+  // Sounds that cannot be unloaded are kept even if too big.
+  to_unload = SoundPool::choose_sounds_to_unload(sounds, 50);
+  Debug::check_assertion(to_unload == std::vector<size_t>({ 1, 3, 0 }),
+      "Expected all sounds that can be unloaded");
+}
+
+}
+
+/**
+ * Tests the choice of voices and of sounds to unload.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  test_free_voice(env);
+  test_priority_stealing(env);
+  test_cache(env);
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/containers/SpscQueue.h"
+#include "solarus/core/Debug.h"
+#include "test_tools/TestEnvironment.h"
+#include <string>
+#include <thread>
+
+using namespace Solarus;
+
+namespace {
+
+/**
+ * \brief Tests pushing and popping elements from the same thread.
+ */
+void test_push_pop(TestEnvironment& /* env */) {
+
+  SpscQueue<std::string> queue(3);
+  std::string element;
+
+  Debug::check_assertion(queue.is_empty(), "Queue should be empty");
+  Debug::check_assertion(!queue.pop(element), "Pop should fail on an empty queue");
+
+  Debug::check_assertion(queue.push("a"), "Failed to push 'a'");
+  Debug::check_assertion(queue.push("b"), "Failed to push 'b'");
+  Debug::check_assertion(queue.push("c"), "Failed to push 'c'");
+  Debug::check_assertion(!queue.push("d"), "Push should fail on a full queue");
+
+  Debug::check_assertion(queue.pop(element) && element == "a", "Expected 'a'");
+  Debug::check_assertion(queue.push("d"), "Failed to push 'd'");
+  Debug::check_assertion(queue.pop(element) && element == "b", "Expected 'b'");
+  Debug::check_assertion(queue.pop(element) && element == "c", "Expected 'c'");
+  Debug::check_assertion(queue.pop(element) && element == "d", "Expected 'd'");
+  Debug::check_assertion(queue.is_empty(), "Queue should be empty");
+}
+
+/**
+ * \brief Tests that elements pushed from another thread arrive in order.
+ */
+void test_threads(TestEnvironment& /* env */) {
+
+  const int num_elements = 100000;
+  SpscQueue<int> queue(16);
+
+  std::thread producer([&queue, num_elements]() {
+    for (int i = 0; i < num_elements; ++i) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  int element = 0;
+  while (expected < num_elements) {
+    if (queue.pop(element)) {
+      Debug::check_assertion(element == expected, "Element received out of order");
+      ++expected;
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  Debug::check_assertion(queue.is_empty(), "Queue should be empty");
+}
+
+}
+
+/**
+ * Tests for the lock-free queue.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  test_push_pop(env);
+  test_threads(env);
+
+  return 0;
+}
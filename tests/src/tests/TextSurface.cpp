@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2006-2018 Christopho, Solarus - http://www.solarus-games.org
+ *
+ * Solarus is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Solarus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solarus/core/Debug.h"
+#include "solarus/core/FontResource.h"
+#include "solarus/core/String.h"
+#include "solarus/graphics/Color.h"
+#include "solarus/graphics/Surface.h"
+#include "solarus/graphics/TextSurface.h"
+#include "test_tools/TestEnvironment.h"
+#include <memory>
+#include <string>
+
+using namespace Solarus;
+
+namespace {
+
+const std::string bitmap_font_id = "8_bit";
+const std::string outline_font_id = "minecraftia";
+const std::string test_text = "Hello, World! 0123";
+
+/**
+ * \brief Creates a text surface with the given font and rendering mode.
+ */
+std::shared_ptr<TextSurface> create_text(const std::string& font_id, TextSurface::RenderingMode rendering_mode) {
+
+  std::shared_ptr<TextSurface> text = std::make_shared<TextSurface>(0, 0);
+  text->set_font(font_id);
+  text->set_rendering_mode(rendering_mode);
+  text->set_text_color(Color::yellow);
+  return text;
+}
+
+/**
+ * \brief Checks that two surfaces have the same size and the same visible pixels.
+ *
+ * Fully transparent pixels are considered equal whatever their color.
+ */
+void check_same_pixels(const Surface& surface, const Surface& expected_surface, const std::string& context) {
+
+  Debug::check_assertion(surface.get_size() == expected_surface.get_size(),
+      context + ": wrong size");
+
+  const std::string& pixels = surface.get_pixels();
+  const std::string& expected_pixels = expected_surface.get_pixels();
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    const bool transparent = pixels[i + 3] == 0;
+    const bool expected_transparent = expected_pixels[i + 3] == 0;
+    Debug::check_assertion(transparent == expected_transparent &&
+        (transparent || pixels.compare(i, 4, expected_pixels, i, 4) == 0),
+        context + ": wrong pixel at index " + String::to_string(static_cast<int>(i / 4)));
+  }
+}
+
+/**
+ * \brief Checks that appending characters draws the same text as drawing
+ * it at once.
+ */
+void test_append(TestEnvironment& /* env */, const std::string& font_id, TextSurface::RenderingMode rendering_mode) {
+
+  std::shared_ptr<TextSurface> appended_text = create_text(font_id, rendering_mode);
+  for (size_t i = 1; i <= test_text.size(); ++i) {
+    appended_text->set_text(test_text.substr(0, i));
+  }
+
+  std::shared_ptr<TextSurface> full_text = create_text(font_id, rendering_mode);
+  full_text->set_text(test_text);
+
+  check_same_pixels(appended_text->get_transition_surface(), full_text->get_transition_surface(),
+      "Appended text with font '" + font_id + "'");
+
+  // Appending after a text drawn at once also gives the same result.
+  full_text->set_text(test_text + test_text);
+  std::shared_ptr<TextSurface> other_full_text = create_text(font_id, rendering_mode);
+  other_full_text->set_text(test_text + test_text);
+  check_same_pixels(full_text->get_transition_surface(), other_full_text->get_transition_surface(),
+      "Text appended twice with font '" + font_id + "'");
+}
+
+/**
+ * \brief Checks that texts composed from cached glyphs look like the ones
+ * rendered by SDL_ttf.
+ */
+void test_composed_glyphs(TestEnvironment& /* env */, TextSurface::RenderingMode rendering_mode) {
+
+  std::shared_ptr<TextSurface> text = create_text(outline_font_id, rendering_mode);
+  text->set_text(test_text);
+
+  TTF_Font& font = FontResource::get_outline_font(outline_font_id, text->get_font_size());
+  SDL_Color color;
+  Color::yellow.get_components(color.r, color.g, color.b, color.a);
+  SDL_Surface* rendered_surface = (rendering_mode == TextSurface::RenderingMode::ANTIALIASING) ?
+      TTF_RenderUTF8_Blended(&font, test_text.c_str(), color) :
+      TTF_RenderUTF8_Solid(&font, test_text.c_str(), color);
+  Debug::check_assertion(rendered_surface != nullptr, "Failed to render the text with SDL_ttf");
+  const SurfacePtr expected_surface = std::make_shared<Surface>(rendered_surface);
+
+  check_same_pixels(text->get_transition_surface(), *expected_surface, "Composed text");
+}
+
+}
+
+/**
+ * Tests for drawing texts.
+ */
+int main(int argc, char** argv) {
+
+  TestEnvironment env(argc, argv);
+
+  test_append(env, bitmap_font_id, TextSurface::RenderingMode::SOLID);
+  test_append(env, outline_font_id, TextSurface::RenderingMode::SOLID);
+  test_append(env, outline_font_id, TextSurface::RenderingMode::ANTIALIASING);
+  test_composed_glyphs(env, TextSurface::RenderingMode::SOLID);
+  test_composed_glyphs(env, TextSurface::RenderingMode::ANTIALIASING);
+
+  return 0;
+}
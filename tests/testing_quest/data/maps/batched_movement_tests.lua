@@ -0,0 +1,83 @@
+local map = ...
+
+local function create_entity(x, y)
+  local entity = map:create_custom_entity({
+    direction = 0,
+    layer = 0,
+    x = x,
+    y = y,
+    width = 16,
+    height = 16,
+  })
+  entity:set_can_traverse(true)
+  entity:set_traversable(true)
+  return entity
+end
+
+local function create_straight_movement()
+  local movement = sol.movement.create("straight")
+  movement:set_smooth(false)
+  movement:set_angle(0)
+  movement:set_speed(1000)
+  movement:set_max_distance(80)
+  return movement
+end
+
+function map:on_started()
+
+  -- Batched: no on_position_changed() event on the movement.
+  local entity_1 = create_entity(40, 40)
+  local num_changes_1 = 0
+  function entity_1:on_position_changed()
+    num_changes_1 = num_changes_1 + 1
+  end
+  create_straight_movement():start(entity_1)
+
+  -- Not batched: the movement wants to know each step.
+  local entity_2 = create_entity(40, 80)
+  local num_changes_2 = 0
+  function entity_2:on_position_changed()
+    num_changes_2 = num_changes_2 + 1
+  end
+  local movement_2 = create_straight_movement()
+  function movement_2:on_position_changed()
+  end
+  movement_2:start(entity_2)
+
+  -- Detectors still see batched entities.
+  local detector = create_entity(80, 40)
+  local num_collisions = 0
+  detector:add_collision_test("overlapping", function(_, other)
+    if other == entity_1 then
+      num_collisions = num_collisions + 1
+    end
+  end)
+
+  local entity_3 = create_entity(40, 120)
+  local trajectory = {}
+  for i = 1, 20 do
+    trajectory[i] = { 2, 0 }
+  end
+  local movement_3 = sol.movement.create("pixel")
+  movement_3:set_trajectory(trajectory)
+  movement_3:set_delay(10)
+  movement_3:start(entity_3)
+
+  local entity_4 = create_entity(160, 160)
+  local movement_4 = sol.movement.create("circle")
+  movement_4:set_center(160, 160)
+  movement_4:set_radius(32)
+  movement_4:start(entity_4)
+
+  sol.timer.start(1000, function()
+    assert(entity_1:get_position() == 120)
+    assert(entity_2:get_position() == 120)
+    assert(num_changes_1 > 0)
+    assert(num_changes_1 < num_changes_2)
+    assert(num_collisions > 0)
+    assert(entity_3:get_position() == 80)
+    local x_4, y_4 = entity_4:get_position()
+    assert(x_4 ~= 160 or y_4 ~= 160)
+    sol.main.exit()
+  end)
+end
@@ -0,0 +1,54 @@
+local map = ...
+
+function map:on_started()
+
+  local hero = map:get_hero()
+  local detector = map:create_custom_entity({
+    direction = 0,
+    layer = 1,
+    x = 160,
+    y = 64,
+    width = 16,
+    height = 16,
+  })
+
+  local num_collisions = 0
+  detector:add_collision_test("overlapping", function(_, other)
+    if other == hero then
+      num_collisions = num_collisions + 1
+    end
+  end)
+
+  -- Not on the same layer.
+  hero:set_position(160, 64, 0)
+  assert(num_collisions == 0)
+
+  -- Layer-independent detector.
+  detector:set_layer_independent_collisions(true)
+  hero:set_position(161, 64, 0)
+  assert(num_collisions > 0)
+
+  -- Detector moved to the layer of the hero.
+  detector:set_layer_independent_collisions(false)
+  hero:set_position(160, 128, 0)
+  num_collisions = 0
+  detector:set_position(160, 64, 0)
+  hero:set_position(160, 64, 0)
+  assert(num_collisions > 0)
+
+  -- Detector moved away from the hero.
+  detector:set_position(160, 160, 1)
+  num_collisions = 0
+  hero:set_position(161, 160, 0)
+  assert(num_collisions == 0)
+
+  -- Statistics of the detector index.
+  local num_candidates, num_checks = map:get_detector_stats()
+  hero:set_position(160, 160, 1)
+  local new_num_candidates, new_num_checks = map:get_detector_stats()
+  assert(new_num_candidates > num_candidates)
+  assert(new_num_checks > num_checks)
+  assert(new_num_checks <= new_num_candidates)
+
+  sol.main.exit()
+end
@@ -0,0 +1,31 @@
+local map = ...
+
+local function count_destructibles(iterator)
+
+  local count = 0
+  for entity in iterator do
+    if entity:get_type() == "destructible" then
+      count = count + 1
+    end
+  end
+  return count
+end
+
+function map:on_started()
+
+  -- Named entities always exist.
+  assert(map:get_entity("named_pot") ~= nil)
+
+  -- Far entities are created when looking for them in a region.
+  assert(count_destructibles(map:get_entities_in_rectangle(1150, 850, 100, 100)) == 2)
+
+  -- Including on the right edge of the map.
+  assert(count_destructibles(map:get_entities_in_rectangle(1250, 450, 100, 100)) == 1)
+
+  -- And when looking for all entities of their type,
+  -- including the ones outside the map.
+  assert(count_destructibles(map:get_entities_by_type("destructible")) == 7)
+  assert(count_destructibles(map:get_entities("")) == 7)
+
+  sol.main.exit()
+end
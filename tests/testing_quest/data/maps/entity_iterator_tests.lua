@@ -0,0 +1,53 @@
+local map = ...
+
+local function create_entities(prefix, count)
+
+  for i = 1, count do
+    map:create_custom_entity({
+      name = prefix,
+      direction = 0,
+      layer = 0,
+      x = 16 * i,
+      y = 64,
+      width = 16,
+      height = 16,
+    })
+  end
+end
+
+local function count(iterator)
+
+  local num_entities = 0
+  for _ in iterator do
+    num_entities = num_entities + 1
+  end
+  return num_entities
+end
+
+function map:on_started()
+
+  create_entities("block", 10)
+  assert(map:get_entities_count("block") == 10)
+  assert(count(map:get_entities("block")) == 10)
+  assert(map:get_entities_count("") == count(map:get_entities("")))
+
+  -- Entities removed during the iteration are skipped.
+  local iterator = map:get_entities("block")
+  local first = iterator()
+  assert(first ~= nil)
+  for entity in map:get_entities("block") do
+    if entity ~= first then
+      entity:remove()
+    end
+  end
+  assert(iterator() == nil)
+  assert(iterator() == nil)
+  assert(map:get_entities_count("block") == 1)
+
+  -- Iterators can be used many times in a row.
+  for _ = 1, 100 do
+    assert(count(map:get_entities_in_rectangle(0, 56, 320, 16)) >= 1)
+  end
+
+  sol.main.exit()
+end
@@ -0,0 +1,45 @@
+local map = ...
+
+local function create_entity(name)
+
+  return map:create_custom_entity({
+    name = name,
+    direction = 0,
+    layer = 0,
+    x = 160,
+    y = 64,
+    width = 16,
+    height = 16,
+  })
+end
+
+function map:on_started()
+
+  create_entity("ene")
+  create_entity("enemy_a")
+  create_entity("enemy_b")
+  create_entity("enemyx")
+  create_entity("enemz")
+
+  assert(map:has_entities("enemy_"))
+  assert(map:get_entities_count("enemy_") == 2)
+  assert(map:get_entities_count("enemy") == 3)
+  assert(map:get_entities_count("ene") == 5)
+  assert(not map:has_entities("enemy_c"))
+  assert(not map:has_entities("f"))
+
+  map:remove_entities("enemy_")
+  assert(not map:has_entities("enemy_"))
+  assert(map:get_entities_count("enemy") == 1)
+
+  -- A new entity can reuse the name of a removed one right now.
+  local enemy = create_entity("enemy_a")
+  assert(enemy:get_name() == "enemy_a")
+
+  sol.timer.start(map, 10, function()
+    -- Destroying the old entity did not forget the new one.
+    assert(map:get_entity("enemy_a") == enemy)
+    assert(map:has_entities("enemy_"))
+    sol.main.exit()
+  end)
+end
@@ -0,0 +1,39 @@
+local map = ...
+local game = map:get_game()
+
+function map:on_started()
+
+  local item = game:get_item("non_saved_item")
+  local num_updates = 0
+
+  -- on_update() defined after the game has started.
+  function item:on_update()
+    num_updates = num_updates + 1
+  end
+
+  sol.timer.start(100, function()
+    assert(num_updates > 0)
+
+    -- Removing on_update() stops the updates.
+    item.on_update = nil
+    num_updates = 0
+
+    sol.timer.start(100, function()
+      assert_equal(num_updates, 0)
+
+      -- on_update() defined in the metatable of items.
+      local item_meta = sol.main.get_metatable("item")
+      function item_meta:on_update()
+        if self == item then
+          num_updates = num_updates + 1
+        end
+      end
+
+      sol.timer.start(100, function()
+        assert(num_updates > 0)
+        item_meta.on_update = nil
+        sol.main.exit()
+      end)
+    end)
+  end)
+end
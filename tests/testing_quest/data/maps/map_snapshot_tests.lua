@@ -0,0 +1,86 @@
+local map = ...
+
+local function create_entity(x, y)
+
+  return map:create_custom_entity({
+    direction = 0,
+    layer = 0,
+    x = x,
+    y = y,
+    width = 16,
+    height = 16,
+  })
+end
+
+function map:on_started()
+
+  local entity_1 = create_entity(80, 80)
+  local entity_2 = create_entity(240, 80)
+
+  local num_collisions = 0
+  entity_1:add_collision_test("overlapping", function(_, other)
+    if other == entity_2 then
+      num_collisions = num_collisions + 1
+    end
+  end)
+
+  -- Scripts save and restore what snapshots do not capture.
+  local num_snapshots = 0
+  local num_restores = 0
+  local saved_value
+  local value = 1
+  function map:on_snapshot()
+    num_snapshots = num_snapshots + 1
+    saved_value = value
+  end
+  function map:on_restore_snapshot()
+    num_restores = num_restores + 1
+    value = saved_value
+  end
+
+  -- Nothing to restore yet.
+  assert(not map:restore_snapshot())
+  assert(num_restores == 0)
+
+  map:save_snapshot()
+  assert(num_snapshots == 1)
+
+  -- Swap the entities and change their state.
+  entity_1:set_position(240, 80)
+  entity_2:set_position(80, 80)
+  entity_1:set_direction(2)
+  entity_1:set_enabled(false)
+  entity_2:set_enabled(false)
+  value = 2
+  num_collisions = 0
+
+  -- Enabled events are called once all entities are restored.
+  local entity_2_x_on_enabled
+  function entity_1:on_enabled()
+    entity_2_x_on_enabled = entity_2:get_position()
+  end
+
+  assert(map:restore_snapshot())
+  assert(num_restores == 1)
+  assert(value == 1)
+  assert(entity_2_x_on_enabled == 240)
+  local x, y = entity_1:get_position()
+  assert(x == 80 and y == 80)
+  x, y = entity_2:get_position()
+  assert(x == 240 and y == 80)
+  assert(entity_1:get_direction() == 0)
+  assert(entity_1:is_enabled())
+  assert(entity_2:is_enabled())
+
+  -- Collisions are checked once all entities are restored:
+  -- entity_1 never sees entity_2 where it was before the restore.
+  assert(num_collisions == 0)
+
+  -- The snapshot can be restored again.
+  entity_1:set_position(160, 160)
+  assert(map:restore_snapshot())
+  x, y = entity_1:get_position()
+  assert(x == 80 and y == 80)
+
+  sol.main.exit()
+end
@@ -0,0 +1,58 @@
+local map = ...
+
+local function create_entity(x, y)
+  return map:create_custom_entity({
+    direction = 0,
+    layer = 0,
+    x = x,
+    y = y,
+    width = 16,
+    height = 16,
+  })
+end
+
+local function create_path_movement()
+  local movement = sol.movement.create("path")
+  movement:set_path({ 0, 0, 0, 0 })
+  movement:set_speed(32)
+  return movement
+end
+
+function map:on_started()
+
+  -- The move in progress counts as the first one.
+  local entity_1 = create_entity(40, 40)
+  local num_changes = 0
+  function entity_1:on_position_changed()
+    num_changes = num_changes + 1
+  end
+  local movement_1 = create_path_movement()
+  local finished = false
+  movement_1:start(entity_1, function()
+    finished = true
+  end)
+  assert(movement_1:fast_forward(3) == 3)
+  assert(entity_1:get_position() == 64)
+  assert(num_changes == 1)
+
+  -- Only the rest of the path is made.
+  assert(movement_1:fast_forward(5) == 1)
+  assert(entity_1:get_position() == 72)
+  assert(movement_1:fast_forward(1) == 0)
+
+  -- Moves that would reach an obstacle are not made.
+  local entity_2 = create_entity(40, 100)
+  local obstacle = create_entity(76, 100)
+  obstacle:set_traversable(false)
+  local movement_2 = create_path_movement()
+  movement_2:start(entity_2)
+  assert(movement_2:fast_forward(4) == 2)
+  assert(entity_2:get_position() == 56)
+  assert(movement_2:fast_forward(0) == 0)
+
+  sol.timer.start(100, function()
+    assert(finished)
+    assert(entity_1:get_position() == 72)
+    sol.main.exit()
+  end)
+end
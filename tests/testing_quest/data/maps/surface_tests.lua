@@ -31,7 +31,42 @@ local function test_set_pixels()
   assert_equal(a, 255)
 end
 
+-- Test for the region parameters of get_pixels() and set_pixels().
+local function test_pixels_region()
+
+  local surface = sol.surface.create(16, 16)
+  surface:fill_color({0, 0, 0, 255})
+  surface:fill_color({255, 0, 0, 255}, 4, 2, 3, 5)
+
+  local pixels = surface:get_pixels(4, 2, 3, 5)
+  assert_equal(#pixels, 3 * 5 * 4)
+  local r, g, b, a = pixels:byte(#pixels - 3, #pixels)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+  assert_equal(a, 255)
+
+  surface:set_pixels(string.rep(string.char(0, 0, 255, 255), 2), 15, 14, 1, 2)
+  pixels = surface:get_pixels(15, 15, 1, 1)
+  r, g, b, a = pixels:byte(1, 4)
+  assert_equal(r, 0)
+  assert_equal(g, 0)
+  assert_equal(b, 255)
+  assert_equal(a, 255)
+
+  pixels = surface:get_pixels(14, 15, 1, 1)
+  r, g, b, a = pixels:byte(1, 4)
+  assert_equal(r, 0)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+  assert_equal(a, 255)
+
+  assert(not pcall(surface.get_pixels, surface, 10, 10, 8, 8))
+  assert(not pcall(surface.set_pixels, surface, "abc", 0, 0, 1, 1))
+end
+
 test_get_pixels()
 test_set_pixels()
+test_pixels_region()
 
 sol.main.exit()
@@ -0,0 +1,164 @@
+local map = ...
+
+local function create_entity(x, y)
+  local entity = map:create_custom_entity({
+    direction = 0,
+    layer = 0,
+    x = x,
+    y = y,
+    width = 16,
+    height = 16,
+  })
+  entity:set_can_traverse(true)
+  entity:set_traversable(true)
+  return entity
+end
+
+-- A detector changes swept movements in the middle of an update:
+-- the remaining precomputed steps must not be applied.
+local function test_detectors_changing_movements()
+
+  local bullet_1 = create_entity(136, 120)
+  local bullet_2 = create_entity(136, 168)
+  local detector_1 = create_entity(184, 120)
+  local detector_2 = create_entity(184, 168)
+
+  local movement_1 = sol.movement.create("straight")
+  local movement_2 = sol.movement.create("pixel")
+
+  local stopped_x
+  detector_1:add_collision_test("overlapping", function(_, other)
+    if other == bullet_1 and stopped_x == nil then
+      movement_1:set_speed(0)
+      stopped_x = bullet_1:get_position()
+    end
+  end)
+  local trajectory_changed = false
+  detector_2:add_collision_test("overlapping", function(_, other)
+    if other == bullet_2 and not trajectory_changed then
+      trajectory_changed = true
+      movement_2:set_trajectory({ { 0, 8 } })
+    end
+  end)
+
+  movement_1:set_swept(true)
+  movement_1:set_smooth(false)
+  movement_1:set_angle(0)
+  movement_1:set_speed(12000)
+  movement_1:set_max_distance(160)
+  movement_1:start(bullet_1)
+
+  local trajectory = {}
+  for i = 1, 20 do
+    trajectory[i] = { 8, 0 }
+  end
+  movement_2:set_swept(true)
+  movement_2:set_trajectory(trajectory)
+  movement_2:set_delay(1)
+  movement_2:start(bullet_2)
+
+  sol.timer.start(200, function()
+    assert(stopped_x ~= nil)
+    assert(stopped_x > 168 and stopped_x < 200)
+    assert(bullet_1:get_position() == stopped_x)
+    assert(trajectory_changed)
+    local x_2, y_2 = bullet_2:get_position()
+    assert(x_2 == 176)
+    assert(y_2 == 176)
+    sol.main.exit()
+  end)
+end
+
+-- Fast swept movements cross a detector within a single update.
+local function test_detectors()
+
+  local bullet_1 = create_entity(136, 120)
+  local bullet_2 = create_entity(136, 168)
+  local detector_1 = create_entity(184, 120)
+  local detector_2 = create_entity(184, 168)
+
+  local num_collisions_1 = 0
+  detector_1:add_collision_test("overlapping", function(_, other)
+    if other == bullet_1 then
+      num_collisions_1 = num_collisions_1 + 1
+    end
+  end)
+  local num_collisions_2 = 0
+  detector_2:add_collision_test("overlapping", function(_, other)
+    if other == bullet_2 then
+      num_collisions_2 = num_collisions_2 + 1
+    end
+  end)
+
+  -- 120 pixels per update.
+  local movement_1 = sol.movement.create("straight")
+  movement_1:set_swept(true)
+  movement_1:set_smooth(false)
+  movement_1:set_angle(0)
+  movement_1:set_speed(12000)
+  movement_1:set_max_distance(160)
+  movement_1:start(bullet_1)
+
+  -- 80 pixels per update.
+  local trajectory = {}
+  for i = 1, 20 do
+    trajectory[i] = { 8, 0 }
+  end
+  local movement_2 = sol.movement.create("pixel")
+  movement_2:set_swept(true)
+  movement_2:set_trajectory(trajectory)
+  movement_2:set_delay(1)
+  movement_2:start(bullet_2)
+
+  sol.timer.start(200, function()
+    assert(bullet_1:get_position() == 296)
+    assert(bullet_2:get_position() == 296)
+    assert(num_collisions_1 > 0)
+    assert(num_collisions_2 > 0)
+    bullet_1:remove()
+    bullet_2:remove()
+    detector_1:remove()
+    detector_2:remove()
+    test_detectors_changing_movements()
+  end)
+end
+
+function map:on_started()
+
+  -- Same straight movement, with and without swept obstacle tests.
+  local movement_1 = sol.movement.create("straight")
+  assert(not movement_1:is_swept())
+  movement_1:set_smooth(false)
+  movement_1:set_angle(3 * math.pi / 2)
+  movement_1:set_speed(400)
+  movement_1:start(npc_1)
+
+  local movement_2 = sol.movement.create("straight")
+  movement_2:set_swept(true)
+  assert(movement_2:is_swept())
+  movement_2:set_smooth(false)
+  movement_2:set_angle(3 * math.pi / 2)
+  movement_2:set_speed(400)
+  movement_2:start(npc_2)
+
+  -- Pixel movement.
+  local movement_3 = sol.movement.create("pixel")
+  movement_3:set_swept(true)
+  movement_3:set_trajectory({ { 0, 1 } })
+  movement_3:set_loop(true)
+  movement_3:set_delay(2)
+  movement_3:start(npc_3)
+
+  sol.timer.start(1000, function()
+    local _, y_1 = npc_1:get_position()
+    local _, y_2 = npc_2:get_position()
+    local _, y_3 = npc_3:get_position()
+    assert(y_1 == y_2)
+    assert(y_1 == y_3)
+    assert(npc_1:test_obstacles(0, 1))  -- Obstacle one pixel to the south.
+    assert(npc_2:test_obstacles(0, 1))
+    assert(npc_3:test_obstacles(0, 1))
+    assert(not npc_2:test_obstacles())
+    test_detectors()
+  end)
+end